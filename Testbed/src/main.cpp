@@ -1,18 +1,68 @@
 #include "Vultron/Vultron.h"
+#include "Vultron/Core/ImageWriter.h"
+#include "Vultron/Core/Profiler.h"
 #include "Vultron/SceneRenderer.h"
 #include "Vultron/Window.h"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <atomic>
 #include <iostream>
 #include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
 
-int main()
+int main(int argc, char **argv)
 {
+    // Headless runs render a fixed number of frames offscreen, no window or display needed
+    bool headless = false;
+    uint32_t headlessFrames = 1000;
+    uint32_t headlessWidth = 1920;
+    uint32_t headlessHeight = 1080;
+    Vultron::RenderBackendType backendType = Vultron::RenderBackendType::Vulkan;
+    std::string tracePath;
+    uint32_t traceFrames = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string_view(argv[i]) == "--headless")
+        {
+            headless = true;
+        }
+        else if (std::string_view(argv[i]) == "--frames" && i + 1 < argc)
+        {
+            headlessFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::string_view(argv[i]) == "--backend" && i + 1 < argc)
+        {
+            // The null backend measures the frontend alone, without a GPU, the software backend renders on the CPU
+            const std::string_view backendName = argv[++i];
+            if (backendName == "null")
+            {
+                backendType = Vultron::RenderBackendType::Null;
+            }
+            else if (backendName == "software")
+            {
+                backendType = Vultron::RenderBackendType::Software;
+            }
+        }
+        else if (std::string_view(argv[i]) == "--resolution" && i + 2 < argc)
+        {
+            headlessWidth = static_cast<uint32_t>(std::atoi(argv[++i]));
+            headlessHeight = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (std::string_view(argv[i]) == "--trace" && i + 2 < argc)
+        {
+            tracePath = argv[++i];
+            traceFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+    }
+
     Vultron::Window window;
 
-    if (!window.Initialize())
+    if (!headless && !window.Initialize())
     {
         std::cerr << "Window failed to initialize" << std::endl;
         return -1;
@@ -20,12 +70,103 @@ int main()
 
     Vultron::SceneRenderer renderer;
 
-    if (!renderer.Initialize(window))
+    const bool initialized = headless ? renderer.InitializeHeadless(headlessWidth, headlessHeight, backendType) : renderer.Initialize(window, backendType);
+    if (!initialized)
     {
         std::cerr << "Renderer failed to initialize" << std::endl;
         return -1;
     }
 
+    std::atomic<uint32_t> readbackCount = 0;
+    bool hierarchy = false;
+
+    // Testbed [--record-threads <n>] [--frames-in-flight <n>] [--render-thread]
+    //         [--present low-latency|throughput|vsync] [--fps-limit <fps>] [--present-wait]
+    //         [--headless] [--frames <n>] [--resolution <width> <height>] [--readback discard|raw|png]
+    //         [--backend vulkan|null|software], software needs --headless
+    //         [--trace <file> <frames>] writes the CPU profiler zones of the last frames on exit, F9 writes them while running
+    //         [--memory-dump <frames>] writes a GPU memory summary every few frames, F10 writes a detailed one while running
+    //         [--capture <file>] writes every frame to a capture that VultronReplay plays back
+    //         [--hierarchy] moves render objects through transform nodes instead of submitting jobs
+    // prints average timings for comparing configurations
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string_view(argv[i]) == "--record-threads" && i + 1 < argc)
+        {
+            renderer.SetRecordingThreadCount(static_cast<uint32_t>(std::atoi(argv[++i])));
+        }
+        else if (std::string_view(argv[i]) == "--frames-in-flight" && i + 1 < argc)
+        {
+            renderer.SetFramesInFlight(static_cast<uint32_t>(std::atoi(argv[++i])));
+        }
+        else if (std::string_view(argv[i]) == "--render-thread")
+        {
+            renderer.SetRenderThreadEnabled(true);
+        }
+        else if (std::string_view(argv[i]) == "--present" && i + 1 < argc)
+        {
+            const std::string_view policy = argv[++i];
+            if (policy == "low-latency")
+            {
+                renderer.SetPresentPolicy(Vultron::PresentPolicy::LowLatency);
+            }
+            else if (policy == "vsync")
+            {
+                renderer.SetPresentPolicy(Vultron::PresentPolicy::VSync);
+            }
+        }
+        else if (std::string_view(argv[i]) == "--fps-limit" && i + 1 < argc)
+        {
+            renderer.SetFrameRateLimit(static_cast<float>(std::atof(argv[++i])));
+        }
+        else if (std::string_view(argv[i]) == "--present-wait")
+        {
+            renderer.SetPresentWaitEnabled(true);
+        }
+        else if (std::string_view(argv[i]) == "--memory-dump" && i + 1 < argc)
+        {
+            renderer.SetMemoryDumpInterval(std::string(VLT_CACHE_DIR) + "/memory", static_cast<uint32_t>(std::atoi(argv[++i])));
+        }
+        else if (std::string_view(argv[i]) == "--capture" && i + 1 < argc)
+        {
+            renderer.BeginCapture(argv[++i]);
+        }
+        else if (std::string_view(argv[i]) == "--hierarchy")
+        {
+            hierarchy = true;
+        }
+        else if (std::string_view(argv[i]) == "--readback" && i + 1 < argc)
+        {
+            // Frames are encoded on the job threads, straight from the readback buffers
+            const std::string format = argv[++i];
+            const std::string directory = std::string(VLT_CACHE_DIR) + "/frames";
+            if (format != "discard")
+            {
+                std::filesystem::create_directories(directory);
+            }
+
+            renderer.SetReadbackCallback([format, directory, &readbackCount](const Vultron::ReadbackFrame &frame)
+                                         {
+                const std::string filepath = directory + "/frame_" + std::to_string(frame.frameNumber);
+                if (format == "raw")
+                {
+                    Vultron::WriteImageRaw(filepath + ".raw", frame.data, frame.size);
+                }
+                else if (format == "png")
+                {
+                    Vultron::WriteImagePNG(filepath + ".png", frame.width, frame.height, frame.data);
+                }
+                readbackCount++; });
+        }
+    }
+
+    renderer.SetMemoryBudgetCallback([](const Vultron::MemoryBudgetEvent &event)
+                                     {
+        if (event.pressure > event.previousPressure)
+        {
+            std::cerr << "GPU memory heap " << event.heapIndex << " is at " << event.usage / (1024 * 1024) << " of " << event.budget / (1024 * 1024) << " MiB" << std::endl;
+        } });
+
     Vultron::RenderHandle mesh = renderer.LoadMesh(std::string(VLT_ASSETS_DIR) + "/meshes/DamagedHelmet.dat");
 
     Vultron::RenderHandle helmetTexture = renderer.LoadImage(std::string(VLT_ASSETS_DIR) + "/textures/helmet_albedo.dat");
@@ -38,47 +179,157 @@ int main()
         .texture = woordTexture,
     });
 
+    const uint32_t instanceCount = 2000;
     const uint32_t numPerRow = 20;
     const float spacing = 2.5f;
     std::vector<glm::mat4> transforms;
-    transforms.resize(Vultron::c_maxInstances);
+    transforms.resize(instanceCount);
+    std::vector<glm::vec3> positions(instanceCount);
 
     const glm::mat4 rot = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
     for (uint32_t i = 0; i < transforms.size(); i++)
     {
         const float x = (i % numPerRow) * spacing - (numPerRow * spacing) / 2.0f;
         const float y = (i / numPerRow) * spacing * -1.0f;
-        const glm::mat4 model = rot * glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
+        positions[i] = glm::vec3(x, y, 0.0f);
+        const glm::mat4 model = rot * glm::translate(glm::mat4(1.0f), positions[i]);
         transforms[i] = model;
     }
 
+    // The same layout as a root node with the rotation and one child per instance, only the children move
+    std::vector<Vultron::RenderHandle> instanceNodes;
+    if (hierarchy)
+    {
+        const Vultron::RenderHandle root = renderer.CreateTransformNode({.rotation = glm::angleAxis(glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f))});
+        for (uint32_t i = 0; i < transforms.size(); i++)
+        {
+            const Vultron::RenderHandle node = renderer.CreateTransformNode({.position = positions[i]}, root);
+            const Vultron::RenderHandle object = renderer.CreateRenderObject(mesh, i % 2 == 0 ? helmetMaterial : woodMaterial, transforms[i]);
+            renderer.AttachRenderObject(object, node);
+            instanceNodes.push_back(node);
+        }
+    }
+
     std::chrono::high_resolution_clock clock;
     auto lastTime = clock.now();
     auto startTime = lastTime;
+    float recordingTime = 0.0f;
+    float gameThreadWaitTime = 0.0f;
+    float renderThreadWaitTime = 0.0f;
+    float frameWaitTime = 0.0f;
+    float latency = 0.0f;
+    uint32_t frameCount = 0;
+    auto reportTime = clock.now();
+    uint32_t frameIndex = 0;
+    bool traceKeyWasDown = false;
+    bool memoryKeyWasDown = false;
 
-    while (!window.ShouldShutdown())
+    while (headless ? frameIndex++ < headlessFrames : !window.ShouldShutdown())
     {
         auto currentTime = clock.now();
         float deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
         lastTime = currentTime;
         float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
-        window.PollEvents();
-
         renderer.BeginFrame();
 
+        if (!headless)
+        {
+            window.PollEvents();
+
+            const bool traceKeyDown = glfwGetKey(window.GetWindowHandle(), GLFW_KEY_F9) == GLFW_PRESS;
+            if (traceKeyDown && !traceKeyWasDown)
+            {
+                std::filesystem::create_directories(VLT_CACHE_DIR);
+                Vultron::WriteChromeTrace(std::string(VLT_CACHE_DIR) + "/trace.json", traceFrames > 0 ? traceFrames : Vultron::c_profilerFrameHistory);
+            }
+            traceKeyWasDown = traceKeyDown;
+
+            const bool memoryKeyDown = glfwGetKey(window.GetWindowHandle(), GLFW_KEY_F10) == GLFW_PRESS;
+            if (memoryKeyDown && !memoryKeyWasDown)
+            {
+                std::filesystem::create_directories(VLT_CACHE_DIR);
+                renderer.WriteMemoryStats(std::string(VLT_CACHE_DIR) + "/memory.json");
+            }
+            memoryKeyWasDown = memoryKeyDown;
+        }
+
         for (uint32_t i = 0; i < transforms.size(); i++)
         {
-            renderer.SubmitRenderJob({mesh, i % 2 == 0 ? helmetMaterial : woodMaterial, glm::translate(transforms[i], glm::vec3(0.0f, 0.0f, glm::sin(time * 2.0f + i * 0.05f) * 0.5f))});
+            const glm::vec3 offset = glm::vec3(0.0f, 0.0f, glm::sin(time * 2.0f + i * 0.05f) * 0.5f);
+            if (hierarchy)
+            {
+                renderer.SetTransformNodeLocal(instanceNodes[i], {.position = positions[i] + offset});
+            }
+            else
+            {
+                renderer.SubmitRenderJob({mesh, i % 2 == 0 ? helmetMaterial : woodMaterial, glm::translate(transforms[i], offset)});
+            }
         }
 
         renderer.EndFrame();
 
-        window.SwapBuffers();
+        recordingTime += renderer.GetRecordingTime();
+        gameThreadWaitTime += renderer.GetGameThreadWaitTime();
+        renderThreadWaitTime += renderer.GetRenderThreadWaitTime();
+        frameWaitTime += renderer.GetFrameWaitTime();
+        latency += renderer.GetLatency();
+        if (++frameCount == 500)
+        {
+            const float frameTime = std::chrono::duration<float, std::chrono::milliseconds::period>(clock.now() - reportTime).count() / frameCount;
+            reportTime = clock.now();
+            std::cout << "Average command recording time: " << recordingTime / frameCount << " ms" << std::endl;
+            std::cout << "Average frame time: " << frameTime << " ms, waiting on GPU: " << frameWaitTime / frameCount << " ms, CPU/GPU overlap: " << 100.0f * (1.0f - frameWaitTime / frameCount / frameTime) << "%" << std::endl;
+            std::cout << "Average input to present latency: " << latency / frameCount << " ms" << std::endl;
+            if (backendType == Vultron::RenderBackendType::Null)
+            {
+                const float jobsPerFrame = static_cast<float>(transforms.size());
+                std::cout << "Frontend throughput: " << jobsPerFrame * 1000.0f / frameTime << " jobs per second, " << frameTime * 1'000'000.0f / jobsPerFrame << " ns per job" << std::endl;
+            }
+            if (readbackCount > 0)
+            {
+                std::cout << "Frames read back: " << readbackCount.exchange(0) * 1000.0f / (frameTime * frameCount) << " per second, last stall: " << renderer.GetReadbackStallTime() << " ms" << std::endl;
+            }
+            if (renderer.GetResizeLatency() > 0.0f)
+            {
+                std::cout << "Last resize latency: " << renderer.GetResizeLatency() << " ms" << std::endl;
+            }
+            const Vultron::MemoryStats memoryStats = renderer.GetMemoryStats();
+            for (const Vultron::MemoryHeapStats &heap : memoryStats.heaps)
+            {
+                if (heap.deviceLocal)
+                {
+                    std::cout << "Device local memory: " << heap.usage / (1024 * 1024) << " of " << heap.budget / (1024 * 1024) << " MiB" << std::endl;
+                }
+            }
+            if (renderer.IsRenderThreadEnabled())
+            {
+                std::cout << "Average wait, game thread: " << gameThreadWaitTime / frameCount << " ms, render thread: " << renderThreadWaitTime / frameCount << " ms" << std::endl;
+            }
+            recordingTime = 0.0f;
+            gameThreadWaitTime = 0.0f;
+            renderThreadWaitTime = 0.0f;
+            frameWaitTime = 0.0f;
+            latency = 0.0f;
+            frameCount = 0;
+        }
+
+        if (!headless)
+        {
+            window.SwapBuffers();
+        }
+    }
+
+    if (!tracePath.empty())
+    {
+        Vultron::WriteChromeTrace(tracePath, traceFrames);
     }
 
     renderer.Shutdown();
-    window.Shutdown();
+    if (!headless)
+    {
+        window.Shutdown();
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -1,7 +1,13 @@
 #version 460
 
+// Specialization constants, must match ShaderConstant in VulkanPipelineManager.h
+layout(constant_id = 0) const bool c_normalMapping = false;
+layout(constant_id = 1) const bool c_alphaTest = false;
+layout(constant_id = 2) const float c_alphaCutoff = 0.5;
+
 layout(location = 0) in vec2 fragTexCoord;
 layout(location = 1) in vec3 fragNormal;
+layout(location = 2) in vec3 fragPosition;
 
 layout(location = 0) out vec4 outColor;
 
@@ -13,13 +19,48 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     vec3 viewPos;
 } ubo;
 layout(set = 1, binding = 0) uniform sampler2D texSampler;
+layout(set = 1, binding = 1) uniform sampler2D normalSampler;
+
+// Per-batch data, must match DrawPushConstants in VulkanMaterial.h
+layout(push_constant) uniform DrawConstants {
+    uint baseInstance;
+    uint materialIndex;
+    uint lod;
+    uint flags;
+} draw;
+
+// Tangent frame from screen space derivatives, the meshes do not store tangents
+mat3 CotangentFrame(vec3 normal, vec3 position, vec2 uv) {
+    vec3 dp1 = dFdx(position);
+    vec3 dp2 = dFdy(position);
+    vec2 duv1 = dFdx(uv);
+    vec2 duv2 = dFdy(uv);
+
+    vec3 dp2perp = cross(dp2, normal);
+    vec3 dp1perp = cross(normal, dp1);
+    vec3 tangent = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 bitangent = dp2perp * duv1.y + dp1perp * duv2.y;
+
+    float invmax = inversesqrt(max(dot(tangent, tangent), dot(bitangent, bitangent)));
+    return mat3(tangent * invmax, bitangent * invmax, normal);
+}
 
 void main() {
+    vec4 albedo = texture(texSampler, fragTexCoord);
+    if (c_alphaTest && albedo.a < c_alphaCutoff) {
+        discard;
+    }
+
     vec3 normal = normalize(fragNormal);
+    if (c_normalMapping) {
+        vec3 tangentNormal = texture(normalSampler, fragTexCoord).xyz * 2.0 - 1.0;
+        normal = normalize(CotangentFrame(normal, fragPosition, fragTexCoord) * tangentNormal);
+    }
+
     float intensity = max(dot(normal, -ubo.lightDir), 0.0);
     vec3 lightColor = vec3(1.0, 1.0, 1.0);
     vec3 ambient = 0.1 * lightColor;
     vec3 diffuse = intensity * lightColor;
-    vec3 result = (ambient + diffuse) * texture(texSampler, fragTexCoord).rgb;
+    vec3 result = (ambient + diffuse) * albedo.rgb;
     outColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
@@ -6,6 +6,7 @@ layout(location = 2) in vec2 inTexCoord;
 
 layout(location = 0) out vec2 fragTexCoord;
 layout(location = 1) out vec3 fragNormal;
+layout(location = 2) out vec3 fragPosition;
 
 layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 model;
@@ -23,8 +24,17 @@ layout(std140, set = 0, binding = 1) readonly buffer InstanceBufferObject {
     InstanceData instances[];
 };
 
+// Per-batch data, must match DrawPushConstants in VulkanMaterial.h
+layout(push_constant) uniform DrawConstants {
+    uint baseInstance;
+    uint materialIndex;
+    uint lod;
+    uint flags;
+} draw;
+
 void main()  {
     gl_Position = ubo.proj * ubo.view * instances[gl_InstanceIndex].model * vec4(inPosition, 1.0);
     fragTexCoord = inTexCoord;
     fragNormal = inNormal;
+    fragPosition = inPosition;
 }
\ No newline at end of file
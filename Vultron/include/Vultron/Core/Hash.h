@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace Vultron
+{
+    // FNV-1a, stable across runs and platforms for the same input bytes.
+    constexpr uint64_t c_hashOffsetBasis = 14695981039346656037ull;
+    constexpr uint64_t c_hashPrime = 1099511628211ull;
+
+    inline uint64_t HashBytes(const void *data, size_t size, uint64_t hash = c_hashOffsetBasis)
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= c_hashPrime;
+        }
+
+        return hash;
+    }
+
+    // Only use on types without padding, hash struct fields one by one otherwise.
+    template <typename T>
+    inline uint64_t HashValue(const T &value, uint64_t hash = c_hashOffsetBasis)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "HashValue requires a trivially copyable type.");
+        return HashBytes(&value, sizeof(T), hash);
+    }
+
+    constexpr uint64_t HashString(std::string_view str, uint64_t hash = c_hashOffsetBasis)
+    {
+        for (char c : str)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= c_hashPrime;
+        }
+
+        return hash;
+    }
+}
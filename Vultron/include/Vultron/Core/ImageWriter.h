@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Vultron
+{
+    // Writes the pixels unchanged, no header
+    bool WriteImageRaw(const std::string &filepath, const uint8_t *data, size_t size);
+
+    // 8 bit RGBA PNG. Deflate blocks are stored uncompressed, which trades file size for encoding speed.
+    bool WriteImagePNG(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgba);
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Vultron/Core/WorkStealingQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Vultron
+{
+    // Size of every thread's queue and job ring, jobs beyond the ring are allocated on the heap
+    constexpr uint32_t c_maxJobsPerThread = 4096;
+    // Threads other than the workers that may schedule jobs, the thread calling Initialize is one of them
+    constexpr uint32_t c_maxExternalThreads = 4;
+
+    // Number of unfinished jobs, shared by every job of a group
+    class JobCounter
+    {
+    private:
+        std::atomic<uint32_t> m_value = 0;
+
+        friend class JobSystem;
+
+    public:
+        bool IsDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+    };
+
+    struct Job
+    {
+        std::function<void()> function;
+        JobCounter *counter = nullptr;
+        const JobCounter *dependency = nullptr;
+        // Set once the job ran, its slot in the job ring is free again
+        std::atomic<bool> finished = true;
+        // Not in a ring, deleted once it ran
+        bool heapAllocated = false;
+    };
+
+    class JobSystem
+    {
+    private:
+        // One per thread that schedules jobs, only the owner pushes or allocates
+        struct ThreadQueue
+        {
+            WorkStealingQueue<Job, c_maxJobsPerThread> queue;
+            std::unique_ptr<Job[]> jobs = std::make_unique<Job[]>(c_maxJobsPerThread);
+            uint32_t nextJob = 0;
+        };
+
+        std::vector<std::unique_ptr<ThreadQueue>> m_queues;
+        std::vector<std::thread> m_workers;
+        std::atomic<uint32_t> m_externalThreadMask = 0;
+
+        // Idle workers sleep until jobs are pushed
+        std::mutex m_sleepMutex;
+        std::condition_variable m_wakeCondition;
+        std::atomic<int32_t> m_pendingJobs = 0;
+        std::atomic<uint32_t> m_sleepingWorkers = 0;
+        std::atomic<bool> m_running = false;
+
+        // Jobs whose dependency was not done when they were picked up, pushed again once it is
+        std::mutex m_parkedMutex;
+        std::vector<Job *> m_parkedJobs;
+        std::atomic<uint32_t> m_parkedCount = 0;
+
+        // Only taken by idle workers, never by a thread waiting on a counter
+        std::mutex m_backgroundMutex;
+        std::deque<Job *> m_backgroundJobs;
+
+        void WorkerLoop(uint32_t queueIndex);
+
+        ThreadQueue &GetThreadQueue();
+        void Push(ThreadQueue &threadQueue, Job *job);
+        Job *GetJob(uint32_t queueIndex);
+        Job *GetBackgroundJob();
+        void Execute(Job *job);
+        // Returns false if the dependency is not done, the job is then parked until it is
+        bool ParkIfBlocked(Job *job);
+        void ReleaseParkedJobs();
+
+    public:
+        JobSystem() = default;
+        ~JobSystem() = default;
+
+        // 0 workers uses one per hardware thread, minus the calling thread
+        bool Initialize(uint32_t workerCount = 0);
+        void Shutdown();
+
+        // Must be called once by any other thread that schedules jobs, e.g. a render thread
+        void RegisterThread();
+        // Gives the queue back, every job the thread started must be done
+        void UnregisterThread();
+
+        // The job does not start before dependency is done, counter is incremented now and decremented when it finishes.
+        // The dependency must outlive the job. Never blocks, unless the thread's queue is full.
+        void Run(std::function<void()> function, JobCounter &counter, const JobCounter *dependency = nullptr);
+
+        // Like Run, for slow work such as user callbacks. Only runs on a worker that is otherwise idle, so a thread
+        // waiting on a counter never ends up running it.
+        void RunBackground(std::function<void()> function, JobCounter &counter);
+
+        // Runs other jobs until the counter reaches zero
+        void Wait(const JobCounter &counter);
+
+        // Splits [0, count) into ranges of at most grainSize and calls function(begin, end) for each, returns when all are done
+        void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)> &function);
+
+        uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+    };
+}
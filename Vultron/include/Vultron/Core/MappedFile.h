@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Vultron
+{
+    // Read-only memory mapping of a whole file.
+    class MappedFile
+    {
+    private:
+        const uint8_t *m_data = nullptr;
+        size_t m_size = 0;
+#if defined(_WIN32)
+        void *m_fileHandle = nullptr;
+        void *m_mappingHandle = nullptr;
+#endif
+
+    public:
+        MappedFile() = default;
+        ~MappedFile() = default;
+
+        bool Open(const std::string &filepath);
+        void Close();
+
+        bool IsOpen() const { return m_data != nullptr; }
+        const uint8_t *GetData() const { return m_data; }
+        size_t GetSize() const { return m_size; }
+    };
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#if VLT_PROFILER_ENABLED && (defined(__x86_64__) || defined(_M_X64))
+#define VLT_PROFILER_TSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace Vultron
+{
+    // Zones each thread keeps, older ones are overwritten
+    constexpr uint32_t c_profilerEventsPerThread = 1 << 15;
+    // Frame boundaries kept for trace export
+    constexpr uint32_t c_profilerFrameHistory = 256;
+
+#if VLT_PROFILER_ENABLED
+    // Fields are atomic only so a trace can be written while the owning thread records, relaxed stores cost nothing extra
+    struct ProfilerEvent
+    {
+        std::atomic<const char *> name = nullptr;
+        std::atomic<uint64_t> start = 0;
+        std::atomic<uint64_t> end = 0;
+    };
+
+    // Written by one thread only, read when a trace is written
+    struct ProfilerThreadBuffer
+    {
+        std::unique_ptr<ProfilerEvent[]> events = std::make_unique<ProfilerEvent[]>(c_profilerEventsPerThread);
+        std::atomic<uint64_t> count = 0;
+        uint32_t threadId = 0;
+        std::string name;
+        // Buffers of finished threads are reused, their zones are kept until then
+        bool inUse = false;
+    };
+
+    extern thread_local constinit ProfilerThreadBuffer *t_profilerBuffer;
+
+    // Slow path, the first zone on a thread takes a buffer from the registry
+    ProfilerThreadBuffer *AcquireProfilerBuffer();
+
+    // Ticks of an invariant clock, converted to nanoseconds when a trace is written
+    inline uint64_t GetProfilerTicks()
+    {
+#if VLT_PROFILER_TSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    inline void RecordProfilerZone(const char *name, uint64_t start, uint64_t end)
+    {
+        ProfilerThreadBuffer *buffer = t_profilerBuffer;
+        if (buffer == nullptr)
+        {
+            buffer = AcquireProfilerBuffer();
+        }
+
+        const uint64_t index = buffer->count.load(std::memory_order_relaxed);
+        ProfilerEvent &event = buffer->events[index & (c_profilerEventsPerThread - 1)];
+        event.name.store(name, std::memory_order_relaxed);
+        event.start.store(start, std::memory_order_relaxed);
+        event.end.store(end, std::memory_order_relaxed);
+        buffer->count.store(index + 1, std::memory_order_release);
+    }
+
+    // Records the time from construction to destruction, name must be a string literal
+    class ProfilerZone
+    {
+    private:
+        const char *m_name;
+        uint64_t m_start;
+
+    public:
+        explicit ProfilerZone(const char *name) : m_name(name), m_start(GetProfilerTicks()) {}
+        ~ProfilerZone() { RecordProfilerZone(m_name, m_start, GetProfilerTicks()); }
+
+        ProfilerZone(const ProfilerZone &) = delete;
+        ProfilerZone &operator=(const ProfilerZone &) = delete;
+    };
+#endif
+
+    // Starts a new frame, called once per frame by the thread driving the frame loop
+    void MarkProfilerFrame();
+    // Shown in the trace instead of the thread id, name must be a string literal
+    void SetProfilerThreadName(const char *name);
+
+    // Writes the zones of every thread in the last frameCount frames as Chrome trace event JSON, which
+    // chrome://tracing and Perfetto open. Returns false when the profiler is compiled out.
+    bool WriteChromeTrace(const std::string &filepath, uint32_t frameCount);
+}
+
+// Compiled out completely unless VLT_PROFILER_ENABLED is set
+#if VLT_PROFILER_ENABLED
+#define VLT_PROFILE_CONCAT_INNER(a, b) a##b
+#define VLT_PROFILE_CONCAT(a, b) VLT_PROFILE_CONCAT_INNER(a, b)
+#define VLT_PROFILE_ZONE(name) ::Vultron::ProfilerZone VLT_PROFILE_CONCAT(vltProfilerZone, __LINE__)(name)
+#define VLT_PROFILE_FRAME() ::Vultron::MarkProfilerFrame()
+#define VLT_PROFILE_THREAD(name) ::Vultron::SetProfilerThreadName(name)
+#else
+#define VLT_PROFILE_ZONE(name)
+#define VLT_PROFILE_FRAME()
+#define VLT_PROFILE_THREAD(name)
+#endif
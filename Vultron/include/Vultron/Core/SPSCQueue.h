@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Vultron
+{
+    // Bounded lock-free queue for exactly one producer and one consumer thread.
+    template <typename T, uint32_t Capacity>
+    class SPSCQueue
+    {
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+    private:
+        static constexpr uint32_t c_mask = Capacity - 1;
+
+        alignas(64) std::atomic<uint32_t> m_head = 0; // Next item to read, written by the consumer
+        alignas(64) std::atomic<uint32_t> m_tail = 0; // Next slot to write, written by the producer
+        std::array<T, Capacity> m_items{};
+
+    public:
+        // Producer only
+        bool TryPush(const T &item)
+        {
+            const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+            {
+                return false;
+            }
+
+            m_items[tail & c_mask] = item;
+            m_tail.store(tail + 1, std::memory_order_release);
+            m_tail.notify_one();
+
+            return true;
+        }
+
+        // Producer only, blocks while the queue is full
+        void Push(const T &item)
+        {
+            while (!TryPush(item))
+            {
+                m_head.wait(m_tail.load(std::memory_order_relaxed) - Capacity, std::memory_order_acquire);
+            }
+        }
+
+        // Consumer only
+        bool TryPop(T &item)
+        {
+            const uint32_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            item = std::move(m_items[head & c_mask]);
+            m_head.store(head + 1, std::memory_order_release);
+            m_head.notify_one();
+
+            return true;
+        }
+
+        // Consumer only, blocks while the queue is empty
+        void Pop(T &item)
+        {
+            while (!TryPop(item))
+            {
+                m_tail.wait(m_head.load(std::memory_order_relaxed), std::memory_order_acquire);
+            }
+        }
+
+        bool IsEmpty() const
+        {
+            return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+        }
+    };
+}
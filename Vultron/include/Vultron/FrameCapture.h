@@ -0,0 +1,157 @@
+#pragma once
+
+#include "Vultron/Core/MappedFile.h"
+#include "Vultron/SceneRenderer.h"
+#include "Vultron/Types.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Vultron
+{
+    // "VLTC" in little endian
+    constexpr uint32_t c_frameCaptureMagic = 0x43544C56;
+    constexpr uint32_t c_frameCaptureVersion = 1;
+    // Frames with more jobs are treated as damaged when reading
+    constexpr uint64_t c_maxCaptureJobs = 1ull << 26;
+
+    enum class CaptureRecordType : uint8_t
+    {
+        Mesh = 1,
+        Image,
+        Material,
+        Frame,
+        End,
+    };
+
+    // An asset as the application created it, a replay creates it again and maps the handle
+    struct CaptureAsset
+    {
+        CaptureRecordType type = CaptureRecordType::Mesh;
+        RenderHandle handle = VLT_INVALID_HANDLE;
+        // Meshes and images
+        std::string path;
+        // Materials, the texture handles are the captured ones
+        TexturedMaterial material = {};
+    };
+
+    // One BeginFrame/SubmitRenderJob/EndFrame sequence
+    struct CaptureFrame
+    {
+        Camera camera = {};
+        DirectionalLight light = {};
+        // Zero when the frame was rendered headless
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<RenderJob> jobs;
+    };
+
+    // Writes the frames and assets a SceneRenderer is given to a binary stream.
+    // Jobs are compared with the job at the same index in the previous frame, runs of unchanged jobs take a few bytes
+    // and only the transform elements that changed are stored, so mostly static scenes stay small.
+    // Asset paths below VLT_ASSETS_DIR are stored relative to it so captures can be replayed from another checkout.
+    class FrameCaptureWriter
+    {
+    private:
+        // Every asset created so far, written at the start of a capture so it can start at any frame
+        std::vector<CaptureAsset> m_assets;
+
+        std::ofstream m_file;
+        std::vector<uint8_t> m_buffer;
+        std::vector<RenderJob> m_previousJobs;
+        uint64_t m_frameCount = 0;
+        uint64_t m_bytesWritten = 0;
+
+        void WriteAsset(const CaptureAsset &asset);
+        void Flush();
+
+    public:
+        FrameCaptureWriter() = default;
+        ~FrameCaptureWriter() = default;
+
+        bool Begin(const std::string &filepath);
+        void End();
+        bool IsCapturing() const { return m_file.is_open(); }
+
+        // Called for every asset whether capturing or not
+        void RecordAsset(const CaptureAsset &asset);
+        // objectJobs are the render objects that exist in this frame, written as jobs before the jobs of the packet
+        void RecordFrame(const FramePacket &packet, const std::vector<RenderJob> &objectJobs = {});
+
+        uint64_t GetFrameCount() const { return m_frameCount; }
+        uint64_t GetBytesWritten() const { return m_bytesWritten; }
+    };
+
+    // Reads a capture record by record, the file is mapped and frames are decoded into the same job vector
+    class FrameCaptureReader
+    {
+    private:
+        MappedFile m_file;
+        size_t m_offset = 0;
+        size_t m_firstRecord = 0;
+        bool m_failed = false;
+
+        CaptureAsset m_asset = {};
+        CaptureFrame m_frame = {};
+
+        template <typename T>
+        T ReadRaw();
+        uint64_t ReadVarint();
+        std::string ReadString();
+
+        void ReadAsset(CaptureRecordType type);
+        void ReadFrame();
+
+    public:
+        FrameCaptureReader() = default;
+        ~FrameCaptureReader() = default;
+
+        bool Open(const std::string &filepath);
+        void Close();
+
+        // Reads the next record. Returns false after the end record, at the end of the file or on a damaged record,
+        // captures that were not ended properly still replay up to their last complete frame.
+        bool Next(CaptureRecordType &type);
+        // Back to the first record, frames are delta encoded so they can only be read in order
+        void Rewind();
+
+        const CaptureAsset &GetAsset() const { return m_asset; }
+        const CaptureFrame &GetFrame() const { return m_frame; }
+    };
+
+    // Feeds a capture back through a SceneRenderer, creating the assets when they appear in the stream
+    class FrameReplayer
+    {
+    private:
+        FrameCaptureReader m_reader;
+        // Captured handles to the handles the renderer gave the recreated assets, backends number each kind separately
+        std::unordered_map<RenderHandle, RenderHandle> m_meshes;
+        std::unordered_map<RenderHandle, RenderHandle> m_images;
+        std::unordered_map<RenderHandle, RenderHandle> m_materials;
+        // The reader stopped at a frame that has not been submitted yet
+        bool m_framePending = false;
+        uint64_t m_frameIndex = 0;
+
+        static RenderHandle MapHandle(const std::unordered_map<RenderHandle, RenderHandle> &handles, RenderHandle handle);
+        void CreateAsset(SceneRenderer &renderer, const CaptureAsset &asset);
+
+    public:
+        FrameReplayer() = default;
+        ~FrameReplayer() = default;
+
+        bool Open(const std::string &filepath);
+        void Close();
+
+        // Creates every asset the capture references up to its first frame, so loading is not part of the first frame
+        bool LoadAssets(SceneRenderer &renderer);
+        // Submits the next frame with BeginFrame/SubmitRenderJob/EndFrame. Returns false at the end of the capture.
+        // With loop the capture starts over instead, assets are only created once.
+        bool ReplayFrame(SceneRenderer &renderer, bool loop = false);
+
+        // Frames replayed since Open, including loops
+        uint64_t GetFrameIndex() const { return m_frameIndex; }
+    };
+}
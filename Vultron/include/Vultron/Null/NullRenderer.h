@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Vultron/RenderBackend.h"
+
+#include <cstdint>
+
+namespace Vultron
+{
+    struct NullRendererStats
+    {
+        uint64_t frames = 0;
+        uint64_t batches = 0;
+        uint64_t instances = 0;
+        // Batches with unknown handles or instance ranges outside the instance data
+        uint64_t invalidBatches = 0;
+    };
+
+    // Backend without a GPU, for measuring the frontend on its own. Nothing is loaded from disk,
+    // handles are handed out in order, so runs are deterministic.
+    class NullRenderer : public RenderBackend
+    {
+    private:
+        bool m_headless = true;
+        RenderHandle m_nextMesh = 1;
+        RenderHandle m_nextImage = 1;
+        RenderHandle m_nextMaterial = 1;
+        NullRendererStats m_stats = {};
+        RenderStats m_frameStats = {};
+
+        bool IsValid(const RenderBatch &batch, size_t instanceCount) const;
+
+    public:
+        NullRenderer() = default;
+        ~NullRenderer() = default;
+
+        bool Initialize(const Window &window, JobSystem &jobSystem) override;
+        bool InitializeHeadless(uint32_t width, uint32_t height, JobSystem &jobSystem) override;
+        void Shutdown() override;
+        bool IsHeadless() const override { return m_headless; }
+
+        void Draw(const Camera &camera, const DirectionalLight &light, const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances,
+                  const std::vector<InstanceRange> &dirtyInstances, std::chrono::high_resolution_clock::time_point inputTime) override;
+
+        RenderHandle LoadMesh(const std::string &filepath) override { return m_nextMesh++; }
+        RenderHandle LoadImage(const std::string &filepath) override { return m_nextImage++; }
+        RenderHandle CreateMaterial(const TexturedMaterial &material) override { return m_nextMaterial++; }
+
+        const NullRendererStats &GetStats() const { return m_stats; }
+        // Every valid batch counts as one draw call, there are no meshes to count triangles of
+        RenderStats GetRenderStats() const override { return m_frameStats; }
+    };
+}
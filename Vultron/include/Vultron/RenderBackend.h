@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Vultron/Core/JobSystem.h"
+#include "Vultron/Types.h"
+#include "Vultron/Window.h"
+#include "Vultron/Vulkan/VulkanGpuProfiler.h"
+#include "Vultron/Vulkan/VulkanMemory.h"
+#include "Vultron/Vulkan/VulkanReadback.h"
+#include "Vultron/Vulkan/VulkanSwapchain.h"
+
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Vultron
+{
+    struct TexturedMaterial;
+
+    enum class RenderBackendType
+    {
+        Vulkan = 0,
+        Null,     // Validates and counts what it is given, no GPU
+        Software, // Rasterizes on the CPU with the job system, headless only
+    };
+
+    // What SceneRenderer draws through. Tuning and measurement calls are optional and do nothing by default.
+    class RenderBackend
+    {
+    public:
+        virtual ~RenderBackend() = default;
+
+        virtual bool Initialize(const Window &window, JobSystem &jobSystem) = 0;
+        virtual bool InitializeHeadless(uint32_t width, uint32_t height, JobSystem &jobSystem) = 0;
+        virtual void Shutdown() = 0;
+        virtual bool IsHeadless() const = 0;
+
+        // dirtyInstances are the instances that changed since the previous Draw, instances outside of them are the same as last time.
+        // inputTime is when the input for this frame was sampled, used for the latency measurement.
+        virtual void Draw(const Camera &camera, const DirectionalLight &light, const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances,
+                          const std::vector<InstanceRange> &dirtyInstances, std::chrono::high_resolution_clock::time_point inputTime) = 0;
+
+        virtual RenderHandle LoadMesh(const std::string &filepath) = 0;
+        virtual RenderHandle LoadImage(const std::string &filepath) = 0;
+        virtual RenderHandle CreateMaterial(const TexturedMaterial &material) = 0;
+
+        // Blocks according to the frame pacing settings, call before sampling input
+        virtual void PaceFrame() {}
+        virtual void Resize(uint32_t width, uint32_t height) {}
+
+        virtual void SetRecordingThreadCount(uint32_t count) {}
+        virtual float GetRecordingTime() const { return 0.0f; }
+        virtual void SetFramesInFlight(uint32_t count) {}
+        virtual float GetFrameWaitTime() const { return 0.0f; }
+        virtual float GetGpuTime() const { return 0.0f; }
+        virtual std::vector<GpuScope> GetGpuScopes() const { return {}; }
+        virtual void SetGpuBatchScopesEnabled(bool enabled) {}
+        // Counters of the last drawn frame, the frontend adds its own
+        virtual RenderStats GetRenderStats() const { return {}; }
+        // GPU memory, only the Vulkan backend has any
+        virtual MemoryStats GetMemoryStats() const { return {}; }
+        virtual void SetMemoryBudgetCallback(MemoryBudgetCallback callback, float warningFraction) {}
+        virtual void SetMemoryDumpInterval(const std::string &directory, uint32_t frames) {}
+        virtual bool WriteMemoryStats(const std::string &filepath, bool detailed) const { return false; }
+
+        virtual void SetPresentPolicy(PresentPolicy policy) {}
+        virtual void SetFrameRateLimit(float framesPerSecond) {}
+        virtual void SetPresentWaitEnabled(bool enabled) {}
+        virtual bool IsPresentWaitSupported() const { return false; }
+        virtual float GetLatency() const { return 0.0f; }
+        virtual float GetResizeLatency() const { return 0.0f; }
+
+        virtual bool SetReadbackCallback(ReadbackCallback callback) { return false; }
+        virtual float GetReadbackStallTime() const { return 0.0f; }
+    };
+}
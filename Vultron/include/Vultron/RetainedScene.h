@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Vultron/Core/JobSystem.h"
+#include "Vultron/SceneRenderer.h"
+#include "Vultron/Types.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace Vultron
+{
+    // Instances a new batch has room for before it has to grow
+    constexpr uint32_t c_minRetainedBatchCapacity = 4;
+    // The instance buffer is only compacted above this size, small scenes are not worth it
+    constexpr uint32_t c_minRetainedCompactionSize = 4096;
+
+    // The render side of the render objects. Objects are kept in batches sorted like BuildRenderBatches and their
+    // transforms stay in the instance buffer between frames, a change only touches its own instance.
+    // Every batch owns a range of the instance buffer with room to grow. A batch that outgrows its range moves to the end
+    // of the buffer and leaves a hole, the buffer is compacted once more than half of it are holes.
+    class RetainedScene
+    {
+    private:
+        struct Batch
+        {
+            RenderHandle mesh = {};
+            RenderHandle material = {};
+            DrawParameters parameters = {};
+            // Object and transform of every instance, in instance order
+            std::vector<uint32_t> objects;
+            std::vector<glm::mat4> transforms;
+            uint32_t firstInstance = 0;
+            uint32_t capacity = 0;
+        };
+
+        struct Object
+        {
+            // Null when the object does not exist
+            Batch *batch = nullptr;
+            uint32_t instance = 0;
+        };
+
+        std::map<uint64_t, Batch> m_batches;
+        std::vector<Object> m_objects;
+        uint32_t m_objectCount = 0;
+
+        // Retained instances up to m_instanceCount, the frame's jobs are packed after them
+        std::vector<glm::mat4> m_instances;
+        uint32_t m_instanceCount = 0;
+        // One bit per c_instancePageSize instances that changed since the last GetDirtyRanges
+        std::vector<uint64_t> m_dirtyPages;
+
+        // Batches with at least one instance, rebuilt when an instance count changes
+        std::vector<RenderBatch> m_renderBatches;
+        bool m_batchesDirty = false;
+
+        void Insert(uint32_t object, const RenderJob &job);
+        void Remove(uint32_t object);
+        void WriteInstance(uint32_t instance, const glm::mat4 &transform);
+        void MarkDirty(uint32_t firstInstance, uint32_t instanceCount);
+        // Gives the batch a new range at the end of the buffer with room for capacity instances
+        void Relocate(Batch &batch, uint32_t capacity);
+        // Lays out every batch again without holes, drops empty batches
+        void Compact(JobSystem &jobSystem);
+
+    public:
+        RetainedScene() = default;
+        ~RetainedScene() = default;
+
+        // Commands are applied in order, objects are numbered by the game thread
+        void Apply(const std::vector<RenderObjectCommand> &commands);
+        // Compacts the buffer if needed and refreshes the batch list, call once per frame after Apply
+        void Update(JobSystem &jobSystem);
+
+        // Changes the transform of an existing object. Safe to call from several threads for different objects between
+        // Update and GetDirtyRanges, as long as nothing else changes the scene.
+        void WriteObjectTransform(uint32_t object, const glm::mat4 &transform);
+
+        // Appends the ranges that changed since the last call and forgets them, adjacent pages are merged
+        void GetDirtyRanges(std::vector<InstanceRange> &ranges);
+
+        const std::vector<RenderBatch> &GetBatches() const { return m_renderBatches; }
+        // Sized to the end of the retained instances after Update, the frame's jobs may be packed after them
+        std::vector<glm::mat4> &GetInstances() { return m_instances; }
+        uint32_t GetInstanceCount() const { return m_instanceCount; }
+        uint32_t GetObjectCount() const { return m_objectCount; }
+    };
+}
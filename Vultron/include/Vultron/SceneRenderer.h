@@ -1,12 +1,22 @@
 #pragma once
 
+#include "Vultron/Core/Hash.h"
+#include "Vultron/Core/JobSystem.h"
+#include "Vultron/Core/SPSCQueue.h"
+#include "Vultron/RenderBackend.h"
 #include "Vultron/Types.h"
 #include "Vultron/Window.h"
 #include "Vultron/Vulkan/VulkanRenderer.h"
 
 #include <glm/glm.hpp>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
 namespace Vultron
@@ -18,87 +28,416 @@ namespace Vultron
         RenderHandle mesh = {};
         RenderHandle material = {};
         glm::mat4 transform = {};
+        DrawParameters parameters = {};
 
-        // Compute hash of mesh and texture
+        // Compute hash of everything that has to be equal to share a batch
         uint64_t GetHash() const
         {
-            return static_cast<uint64_t>(mesh) ^ static_cast<uint64_t>(material);
+            uint64_t hash = HashValue(mesh);
+            hash = HashValue(material, hash);
+            hash = HashValue(parameters.lod, hash);
+            return HashValue(parameters.flags, hash);
         }
     };
 
+    enum class RenderObjectCommandType : uint8_t
+    {
+        Create = 0,
+        SetTransform,
+        SetMaterial,
+        Destroy,
+    };
+
+    // A change to a render object, recorded on the game thread and applied by whichever thread renders
+    struct RenderObjectCommand
+    {
+        RenderObjectCommandType type = RenderObjectCommandType::Create;
+        uint32_t object = 0;
+        // Create uses all of it, SetTransform only the transform and SetMaterial only the material
+        RenderJob job = {};
+    };
+
+    enum class TransformCommandType : uint8_t
+    {
+        Create = 0,
+        SetLocal,
+        Destroy,
+        Attach,
+    };
+
+    // Parent of a root node and object of a node that drives none
+    constexpr uint32_t c_noTransformTarget = 0xFFFFFFFF;
+
+    // A change to a transform node, recorded on the game thread like RenderObjectCommand
+    struct TransformCommand
+    {
+        TransformCommandType type = TransformCommandType::Create;
+        uint32_t node = 0;
+        // The parent for Create, the render object for Attach, c_noTransformTarget for none
+        uint32_t target = c_noTransformTarget;
+        // Used by Create and SetLocal
+        Transform local = {};
+    };
+
     // Render batch but it has a vector of transforms
     struct InstancedRenderJob
     {
         RenderHandle mesh = {};
         RenderHandle material = {};
+        DrawParameters parameters = {};
         std::vector<glm::mat4> transforms = {};
     };
 
+    // Batches copied into the instance buffer by one job
+    constexpr uint32_t c_instancePackGrainSize = 64;
+    // The game thread fills one packet while the render thread draws the other
+    constexpr uint32_t c_framePacketCount = 2;
+
+    // Everything needed to draw one frame, handed from the game thread to the render thread
+    struct FramePacket
+    {
+        std::vector<RenderJob> jobs;
+        // Render object changes since the previous packet, applied before the jobs are batched
+        std::vector<RenderObjectCommand> objectCommands;
+        // Transform node changes since the previous packet, applied with the render object changes
+        std::vector<TransformCommand> transformCommands;
+        Camera camera = {};
+        DirectionalLight light = {};
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::chrono::high_resolution_clock::time_point inputTime = {};
+    };
+
+    // Groups jobs that can share a batch and lists one batch per group in hash order, with instance offsets assigned in that order
+    // starting at firstInstance
+    void BuildRenderBatches(const std::vector<RenderJob> &jobs, std::map<uint64_t, InstancedRenderJob> &renderJobs, std::vector<RenderBatch> &batches,
+                            std::vector<const InstancedRenderJob *> &batchJobs, uint32_t firstInstance = 0);
+    // Copies the transforms of every batch to its offset in the instance buffer, batches are packed in parallel.
+    // The buffer is resized to end at the last batch, it is left as is without batches.
+    void PackInstances(JobSystem &jobSystem, const std::vector<RenderBatch> &batches, const std::vector<const InstancedRenderJob *> &batchJobs,
+                       std::vector<glm::mat4> &instanceBuffer);
+
+    class FrameCaptureWriter;
+    class RetainedScene;
+    class TransformHierarchy;
+
+    // Game thread copy of a render object
+    struct RenderObject
+    {
+        RenderJob job = {};
+        // The transform node the object follows, if any
+        RenderHandle node = VLT_INVALID_HANDLE;
+        bool alive = false;
+    };
+
+    // Game thread copy of a transform node
+    struct TransformNode
+    {
+        Transform local = {};
+        RenderHandle parent = VLT_INVALID_HANDLE;
+        RenderHandle object = VLT_INVALID_HANDLE;
+        uint32_t childCount = 0;
+        bool alive = false;
+    };
+
     class SceneRenderer
     {
     private:
-        VulkanRenderer backend;
+        JobSystem jobSystem;
+        Ptr<RenderBackend> backend;
+        const Window *window = nullptr;
+
+        // Game thread state
+        Camera camera = {};
+        DirectionalLight light = {};
+        FramePacket *currentPacket = nullptr;
+        float gameThreadWaitTime = 0.0f;
+
+        // Packets go game thread -> submittedPackets -> render thread -> freePackets -> game thread
+        std::array<FramePacket, c_framePacketCount> framePackets;
+        SPSCQueue<FramePacket *, c_framePacketCount> submittedPackets;
+        SPSCQueue<FramePacket *, c_framePacketCount> freePackets;
+        std::atomic<uint32_t> packetsInFlight = 0;
+
+        std::thread renderThread;
+        bool renderThreadEnabled = false;
+        std::atomic<float> renderThreadWaitTime = 0.0f;
+
+        // Render objects, handles are the index plus one so no object has VLT_INVALID_HANDLE.
+        // Changes are queued until EndFrame, so objects can be changed outside BeginFrame/EndFrame as well.
+        std::vector<RenderObject> renderObjects;
+        std::vector<uint32_t> freeRenderObjects;
+        std::vector<RenderObjectCommand> pendingObjectCommands;
+        uint32_t renderObjectCount = 0;
+
+        // Null for handles of objects that do not exist
+        RenderObject *FindRenderObject(RenderHandle object);
+
+        // Transform nodes, numbered like render objects and queued the same way
+        std::vector<TransformNode> transformNodes;
+        std::vector<uint32_t> freeTransformNodes;
+        std::vector<TransformCommand> pendingTransformCommands;
+        uint32_t transformNodeCount = 0;
+
+        TransformNode *FindTransformNode(RenderHandle node);
+        // Walks up the game thread copies, only used for captures
+        glm::mat4 ComputeTransformNodeWorld(RenderHandle node) const;
+
+        // Owned by whichever thread renders
         std::map<uint64_t, InstancedRenderJob> renderJobs;
+        Ptr<RetainedScene> retainedScene;
+        Ptr<TransformHierarchy> transformHierarchy;
+        std::vector<RenderBatch> frameBatches;
+        std::vector<RenderBatch> jobBatches;
+        std::vector<const InstancedRenderJob *> batchJobs;
+        std::vector<InstanceRange> dirtyInstances;
+
+        // Backend timings in milliseconds, copied with the stats so the game thread never reads them while the backend draws
+        struct RenderTimings
+        {
+            float recordingTime = 0.0f;
+            float frameWaitTime = 0.0f;
+            float gpuTime = 0.0f;
+            float latency = 0.0f;
+            float readbackStallTime = 0.0f;
+            float resizeLatency = 0.0f;
+        };
+
+        // Published once per frame by whichever thread renders
+        mutable std::mutex renderStatsMutex;
+        RenderStats renderStats = {};
+        RenderTimings renderTimings = {};
+
+        RenderTimings GetRenderTimings() const
+        {
+            std::lock_guard<std::mutex> lock(renderStatsMutex);
+            return renderTimings;
+        }
+
+        void RenderPacket(const FramePacket &packet);
+        void RenderThreadLoop();
+
+        // Blocks until the render thread has drawn every submitted packet, required before touching backend resources
+        void FlushRenderThread();
+
+        // Game thread only, remembers every asset so a capture can start at any frame
+        Ptr<FrameCaptureWriter> captureWriter;
+        std::vector<RenderJob> captureObjectJobs;
+
+        void CaptureMesh(RenderHandle handle, const std::string &path);
+        void CaptureImage(RenderHandle handle, const std::string &path);
+        void CaptureMaterial(RenderHandle handle, const TexturedMaterial &material);
 
     public:
-        SceneRenderer() = default;
-        ~SceneRenderer() = default;
+        SceneRenderer();
+        ~SceneRenderer();
+
+        bool Initialize(const Window &window, RenderBackendType backendType = RenderBackendType::Vulkan);
+        // Renders offscreen at a fixed size without a window
+        bool InitializeHeadless(uint32_t width, uint32_t height, RenderBackendType backendType = RenderBackendType::Vulkan);
+        void Shutdown();
 
-        bool Initialize(const Window &window)
+        // Paces the frame when not using a render thread, sample input after this
+        void BeginFrame();
+        void SubmitRenderJob(const RenderJob &job)
         {
-            return backend.Initialize(window);
+            currentPacket->jobs.push_back(job);
         }
+        void EndFrame();
+
+        // Retained objects are drawn every frame until destroyed without being submitted again. They are kept in sorted
+        // batches on the render side, so a frame costs what changed instead of what exists. Game thread only.
+        RenderHandle CreateRenderObject(RenderHandle mesh, RenderHandle material, const glm::mat4 &transform, DrawParameters parameters = {});
+        // Detaches the object from its transform node, if any
+        void SetRenderObjectTransform(RenderHandle object, const glm::mat4 &transform);
+        // Moves the object to the batch of its new material
+        void SetRenderObjectMaterial(RenderHandle object, RenderHandle material);
+        void DestroyRenderObject(RenderHandle object);
+        uint32_t GetRenderObjectCount() const { return renderObjectCount; }
+
+        // Transform nodes form a hierarchy on the render side. Their world matrices are propagated in parallel every frame,
+        // only below the nodes that changed. Parents have to exist when their children are created. Game thread only.
+        RenderHandle CreateTransformNode(const Transform &local, RenderHandle parent = VLT_INVALID_HANDLE);
+        void SetTransformNodeLocal(RenderHandle node, const Transform &local);
+        // The node must not have children, its render object keeps the last transform
+        void DestroyTransformNode(RenderHandle node);
+        // The object follows the node's world matrix instead of its own transform, a node drives at most one object.
+        // VLT_INVALID_HANDLE detaches the object, it keeps its last transform.
+        void AttachRenderObject(RenderHandle object, RenderHandle node);
+        uint32_t GetTransformNodeCount() const { return transformNodeCount; }
+
+        void SetCamera(const Camera &newCamera) { camera = newCamera; }
+        void SetLight(const DirectionalLight &newLight) { light = newLight; }
+
+        // Draws on a separate thread so the next frame can be simulated while this one is submitted. Call outside BeginFrame/EndFrame.
+        void SetRenderThreadEnabled(bool enabled);
+        bool IsRenderThreadEnabled() const { return renderThreadEnabled; }
 
-        void BeginFrame()
+        // Milliseconds the game thread waited for a free packet in the last BeginFrame
+        float GetGameThreadWaitTime() const { return gameThreadWaitTime; }
+        // Milliseconds the render thread waited for the last packet
+        float GetRenderThreadWaitTime() const { return renderThreadWaitTime.load(std::memory_order_relaxed); }
+
+        RenderHandle LoadMesh(const std::string &path)
         {
-            renderJobs.clear();
+            FlushRenderThread();
+            const RenderHandle handle = backend->LoadMesh(path);
+            CaptureMesh(handle, path);
+            return handle;
         }
 
-        void SubmitRenderJob(const RenderJob &job)
+        RenderHandle LoadImage(const std::string &path)
         {
-            uint64_t hash = job.GetHash();
-            if (renderJobs.find(hash) == renderJobs.end())
-            {
-                renderJobs.insert({hash, InstancedRenderJob{job.mesh, job.material, {}}});
-            }
+            FlushRenderThread();
+            const RenderHandle handle = backend->LoadImage(path);
+            CaptureImage(handle, path);
+            return handle;
+        }
 
-            renderJobs[hash].transforms.push_back(job.transform);
+        template <typename T>
+        RenderHandle CreateMaterial(const T &materialCreateInfo)
+        {
+            FlushRenderThread();
+            const RenderHandle handle = backend->CreateMaterial(materialCreateInfo);
+            CaptureMaterial(handle, materialCreateInfo);
+            return handle;
         }
 
-        void EndFrame()
+        // Writes every following frame and the assets it uses to filepath until EndCapture, see FrameCaptureWriter.
+        // Replay it with FrameReplayer or VultronReplay. Call outside BeginFrame/EndFrame.
+        bool BeginCapture(const std::string &filepath);
+        void EndCapture();
+        bool IsCapturing() const;
+
+        void SetRecordingThreadCount(uint32_t count)
         {
-            std::vector<glm::mat4> instanceBuffer;
-            std::vector<RenderBatch> batches;
+            FlushRenderThread();
+            backend->SetRecordingThreadCount(count);
+        }
+
+        // Timings of the last drawn frame, do not wait for the render thread
+        float GetRecordingTime() const
+        {
+            return GetRenderTimings().recordingTime;
+        }
 
-            for (auto &job : renderJobs)
-            {
-                instanceBuffer.insert(instanceBuffer.end(), job.second.transforms.begin(), job.second.transforms.end());
-                batches.push_back({job.second.mesh, job.second.material, static_cast<uint32_t>(instanceBuffer.size() - job.second.transforms.size()), static_cast<uint32_t>(job.second.transforms.size())});
-            }
+        void SetFramesInFlight(uint32_t count)
+        {
+            FlushRenderThread();
+            backend->SetFramesInFlight(count);
+        }
 
-            backend.Draw(batches, instanceBuffer);
+        float GetFrameWaitTime() const
+        {
+            return GetRenderTimings().frameWaitTime;
         }
 
-        void Shutdown()
+        // GPU milliseconds of the most recently finished frame, a few frames behind
+        float GetGpuTime() const
         {
-            backend.Shutdown();
+            return GetRenderTimings().gpuTime;
         }
 
-        RenderHandle LoadMesh(const std::string &path)
+        // Counters of the last drawn frame, does not wait for the render thread
+        RenderStats GetRenderStats() const
         {
-            return backend.LoadMesh(path);
+            std::lock_guard<std::mutex> lock(renderStatsMutex);
+            return renderStats;
         }
 
-        RenderHandle LoadImage(const std::string &path)
+        // GPU heap budgets as of the last drawn frame and bytes per allocation category, does not wait for the render thread
+        MemoryStats GetMemoryStats() const
         {
-            return backend.LoadImage(path);
+            return backend->GetMemoryStats();
         }
 
-        template <typename T>
-        RenderHandle CreateMaterial(const T &materialCreateInfo)
+        // See VulkanMemoryBudget::SetBudgetCallback, the callback runs on whichever thread renders
+        void SetMemoryBudgetCallback(MemoryBudgetCallback callback, float warningFraction = c_defaultMemoryWarningFraction)
+        {
+            FlushRenderThread();
+            backend->SetMemoryBudgetCallback(std::move(callback), warningFraction);
+        }
+
+        // Writes a memory summary to directory every frames frames, 0 disables it
+        void SetMemoryDumpInterval(const std::string &directory, uint32_t frames)
+        {
+            FlushRenderThread();
+            backend->SetMemoryDumpInterval(directory, frames);
+        }
+
+        // Heap budgets, category totals and the VMA statistics as JSON, detailed lists every allocation
+        bool WriteMemoryStats(const std::string &filepath, bool detailed = true) const
+        {
+            return backend->WriteMemoryStats(filepath, detailed);
+        }
+
+        // Named GPU scopes of the most recently finished frame, nested scopes follow their parent
+        std::vector<GpuScope> GetGpuScopes()
+        {
+            FlushRenderThread();
+            return backend->GetGpuScopes();
+        }
+
+        // Times every batch on the GPU as well, see VulkanRenderer::SetGpuBatchScopesEnabled
+        void SetGpuBatchScopesEnabled(bool enabled)
+        {
+            FlushRenderThread();
+            backend->SetGpuBatchScopesEnabled(enabled);
+        }
+
+        void SetPresentPolicy(PresentPolicy policy)
+        {
+            FlushRenderThread();
+            backend->SetPresentPolicy(policy);
+        }
+
+        void SetFrameRateLimit(float framesPerSecond)
+        {
+            FlushRenderThread();
+            backend->SetFrameRateLimit(framesPerSecond);
+        }
+
+        void SetPresentWaitEnabled(bool enabled)
+        {
+            FlushRenderThread();
+            backend->SetPresentWaitEnabled(enabled);
+        }
+
+        bool IsPresentWaitSupported() const
+        {
+            return backend->IsPresentWaitSupported();
+        }
+
+        // Input to present latency in milliseconds, see VulkanRenderer::GetLatency
+        float GetLatency() const
+        {
+            return GetRenderTimings().latency;
+        }
+
+        const RenderBackend &GetBackend() const { return *backend; }
+
+        bool IsHeadless() const
+        {
+            return backend->IsHeadless();
+        }
+
+        // See VulkanRenderer::SetReadbackCallback
+        bool SetReadbackCallback(ReadbackCallback callback)
+        {
+            FlushRenderThread();
+            return backend->SetReadbackCallback(std::move(callback));
+        }
+
+        float GetReadbackStallTime() const
+        {
+            return GetRenderTimings().readbackStallTime;
+        }
+
+        // Milliseconds from the last window resize to the first frame at the new size
+        float GetResizeLatency() const
         {
-            return backend.CreateMaterial(materialCreateInfo);
+            return GetRenderTimings().resizeLatency;
         }
     };
 
-}
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Vultron
+{
+    // The target is split into tiles that are rasterized independently, and tiles into blocks for the coarse depth test.
+    // Tiles must be a multiple of the block size.
+    constexpr uint32_t c_softwareTileSize = 64;
+    constexpr uint32_t c_softwareBlockSize = 8;
+
+    // u, v and the normal, divided by w for perspective correct interpolation
+    constexpr uint32_t c_softwareAttributeCount = 5;
+
+    // sRGB RGBA8 texels, one entry per mip level
+    struct SoftwareTexture
+    {
+        struct Mip
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<uint32_t> texels;
+        };
+
+        std::vector<Mip> mips;
+    };
+
+    // The subset of TexturedMaterial and PipelineState the rasterizer understands
+    struct SoftwareMaterial
+    {
+        const SoftwareTexture *texture = nullptr;
+        const SoftwareTexture *normalTexture = nullptr; // Normal mapping when set
+        bool alphaTest = false;
+        float alphaCutoff = 0.5f;
+        bool cullBackFaces = true;
+        bool cullFrontFaces = false;
+        bool frontFaceCounterClockwise = true;
+        bool depthTest = true;
+        bool depthWrite = true;
+    };
+
+    // Output of the vertex stage
+    struct SoftwareVertex
+    {
+        glm::vec4 position; // Clip space
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+    };
+
+    // Screen space plane, value(x, y) = dx * x + dy * y + c
+    struct SoftwarePlane
+    {
+        float dx = 0.0f;
+        float dy = 0.0f;
+        float c = 0.0f;
+    };
+
+    struct SoftwareTriangle
+    {
+        // Pixels are inside where every edge is >= 0, or > 0 for edges that are neither top nor left edges
+        std::array<SoftwarePlane, 3> edges;
+        uint32_t topLeftMask = 0;
+
+        SoftwarePlane depth;
+        SoftwarePlane invW;
+        std::array<SoftwarePlane, c_softwareAttributeCount> attributes;
+
+        // Object space, for normal mapping
+        glm::vec3 tangent;
+        glm::vec3 bitangent;
+
+        // Inclusive pixel bounds, clamped to the target
+        int32_t minX = 0;
+        int32_t minY = 0;
+        int32_t maxX = 0;
+        int32_t maxY = 0;
+
+        float minDepth = 0.0f;
+        // log2 of the texture coordinate footprint of a pixel, the mip level is this plus log2 of the texture size
+        float lod = 0.0f;
+        const SoftwareMaterial *material = nullptr;
+    };
+
+    // Color and depth with rows padded to a multiple of the block size, color in sRGB RGBA8
+    struct SoftwareTarget
+    {
+        uint32_t *color = nullptr;
+        float *depth = nullptr;
+        float *blockMaxDepth = nullptr; // Farthest depth of each block, for rejecting whole blocks
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t stride = 0;
+        uint32_t paddedHeight = 0;
+        uint32_t blockCountX = 0;
+    };
+
+    // Clips against the near plane, culls and sets up a triangle. Writes up to two triangles to out and returns how many.
+    uint32_t SetupSoftwareTriangle(const std::array<SoftwareVertex, 3> &vertices, const glm::vec3 &tangent, const glm::vec3 &bitangent,
+                                   const SoftwareMaterial &material, uint32_t width, uint32_t height, SoftwareTriangle *out);
+
+    // Rasterizes and shades the part of the triangle in the block aligned rectangle [x0, x1) x [y0, y1)
+    void RasterizeSoftwareTriangle(const SoftwareTriangle &triangle, const SoftwareTarget &target, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                                   const glm::vec3 &lightDirection);
+
+    // Clears whole block rows [firstRow, firstRow + rowCount) to black and the far plane
+    void ClearSoftwareTarget(const SoftwareTarget &target, uint32_t firstRow, uint32_t rowCount);
+}
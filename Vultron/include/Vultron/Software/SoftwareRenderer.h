@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Vultron/Core/Core.h"
+#include "Vultron/RenderBackend.h"
+#include "Vultron/Software/SoftwareRasterizer.h"
+#include "Vultron/Vulkan/VulkanRenderer.h"
+
+#include <array>
+#include <vector>
+
+namespace Vultron
+{
+    // Upper bound for the triangles set up before they are rasterized, bounds the memory used by the bins
+    constexpr uint32_t c_softwareTrianglesPerPass = 1 << 18;
+    // Setup splits a pass into at most this many chunks, each with its own bins so no locking is needed
+    constexpr uint32_t c_softwareMaxSetupChunks = 64;
+    constexpr uint32_t c_softwareMinChunkTriangles = 1024;
+    // One color buffer can be read back while the next frame is drawn into the other
+    constexpr uint32_t c_softwareColorBufferCount = 2;
+
+    struct SoftwareMesh
+    {
+        std::vector<StaticMeshVertex> vertices;
+        std::vector<uint32_t> indices;
+        // Per triangle, the tangent frame for normal mapping
+        std::vector<glm::vec3> tangents;
+        std::vector<glm::vec3> bitangents;
+        glm::vec3 boundsCenter = glm::vec3(0.0f);
+        float boundsRadius = 0.0f;
+
+        uint32_t GetTriangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+    };
+
+    // One visible instance of a batch
+    struct SoftwareDraw
+    {
+        const SoftwareMesh *mesh = nullptr;
+        const SoftwareMaterial *material = nullptr;
+        glm::mat4 modelViewProj = glm::mat4(1.0f);
+        // Index of the first triangle of this draw in the frame
+        uint64_t firstTriangle = 0;
+    };
+
+    // Triangles one setup job produced, binned by the tiles they touch
+    struct SoftwareSetupChunk
+    {
+        std::vector<SoftwareTriangle> triangles;
+        std::vector<std::vector<uint32_t>> bins;
+        // Triangles rejected by setup, back facing, outside the screen or clipped away
+        uint64_t culledTriangles = 0;
+    };
+
+    // Renders on the CPU with the job system: triangles are set up and binned into tiles in parallel,
+    // then every tile is rasterized by one job. Output is deterministic regardless of the thread count.
+    // Only renders headless, frames are read back through the readback callback or GetColorBuffer.
+    class SoftwareRenderer : public RenderBackend
+    {
+    private:
+        JobSystem *m_jobSystem = nullptr;
+
+        // Target
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+        uint32_t m_stride = 0;
+        uint32_t m_paddedHeight = 0;
+        uint32_t m_tileCountX = 0;
+        uint32_t m_tileCountY = 0;
+        std::array<std::vector<uint32_t>, c_softwareColorBufferCount> m_colorBuffers;
+        std::vector<float> m_depthBuffer;
+        std::vector<float> m_blockMaxDepth;
+        uint32_t m_currentColorBuffer = 0;
+
+        // Readback, a callback reads a color buffer until its counter is done
+        ReadbackCallback m_readbackCallback;
+        std::array<JobCounter, c_softwareColorBufferCount> m_readbackCounters;
+        std::array<std::vector<uint32_t>, c_softwareColorBufferCount> m_readbackRows;
+        float m_readbackStallTime = 0.0f;
+
+        // Resources, handles are indices plus one
+        std::vector<Ptr<SoftwareMesh>> m_meshes;
+        std::vector<Ptr<SoftwareTexture>> m_textures;
+        std::vector<Ptr<SoftwareMaterial>> m_materials;
+
+        // Frame state
+        std::vector<SoftwareDraw> m_draws;
+        std::array<SoftwareSetupChunk, c_softwareMaxSetupChunks> m_chunks;
+        uint64_t m_frameNumber = 0;
+        uint64_t m_triangleCount = 0;
+        float m_setupTime = 0.0f;
+        float m_rasterTime = 0.0f;
+        float m_latency = 0.0f;
+        RenderStats m_stats = {};
+
+        SoftwareTarget GetTarget() const;
+
+        // Frustum culls the instances of every batch into m_draws, returns the triangle count
+        uint64_t CollectDraws(const glm::mat4 &viewProj, const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances);
+        // Sets up and bins triangles [firstTriangle, firstTriangle + count) of the frame, returns the chunks used
+        uint32_t SetupTriangles(uint64_t firstTriangle, uint64_t count);
+        void RasterizeTiles(uint32_t chunkCount, const glm::vec3 &lightDirection);
+        void RunReadbackCallback(uint32_t bufferIndex, uint64_t frameNumber);
+
+    public:
+        SoftwareRenderer() = default;
+        ~SoftwareRenderer() = default;
+
+        // Windowed output is not supported, fails so the caller can pick another backend
+        bool Initialize(const Window &window, JobSystem &jobSystem) override;
+        bool InitializeHeadless(uint32_t width, uint32_t height, JobSystem &jobSystem) override;
+        void Shutdown() override;
+        bool IsHeadless() const override { return true; }
+
+        void Draw(const Camera &camera, const DirectionalLight &light, const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances,
+                  const std::vector<InstanceRange> &dirtyInstances, std::chrono::high_resolution_clock::time_point inputTime) override;
+
+        RenderHandle LoadMesh(const std::string &filepath) override;
+        RenderHandle LoadImage(const std::string &filepath) override;
+        RenderHandle CreateMaterial(const TexturedMaterial &material) override;
+
+        // Setup and rasterization time of the last frame in milliseconds, reported as recording time
+        float GetRecordingTime() const override { return m_setupTime + m_rasterTime; }
+        float GetSetupTime() const { return m_setupTime; }
+        float GetRasterTime() const { return m_rasterTime; }
+        // Triangles in the visible instances of the last frame, before clipping and culling
+        uint64_t GetTriangleCount() const { return m_triangleCount; }
+        // Every visible instance is one draw, culling counts are from the frustum test and triangle setup
+        RenderStats GetRenderStats() const override { return m_stats; }
+
+        // Milliseconds from input sampling to the finished frame
+        float GetLatency() const override { return m_latency; }
+
+        // Called on a worker after every frame, see VulkanRenderer::SetReadbackCallback
+        bool SetReadbackCallback(ReadbackCallback callback) override;
+        // Milliseconds the last frame waited for a readback callback to free its color buffer
+        float GetReadbackStallTime() const override { return m_readbackStallTime; }
+
+        // The last finished frame in sRGB RGBA8, rows are GetStride() pixels apart
+        const uint32_t *GetColorBuffer() const { return m_colorBuffers[(m_currentColorBuffer + c_softwareColorBufferCount - 1) % c_softwareColorBufferCount].data(); }
+        uint32_t GetStride() const { return m_stride; }
+    };
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Vultron/Core/JobSystem.h"
+#include "Vultron/SceneRenderer.h"
+#include "Vultron/Types.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Vultron
+{
+    class RetainedScene;
+
+    // Nodes of one level propagated by one job
+    constexpr uint32_t c_transformGrainSize = 256;
+
+    // Same as translate * mat4_cast(rotation) * scale, without building the intermediate matrices
+    inline glm::mat4 ComposeTransform(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale)
+    {
+        const float xx = rotation.x * rotation.x, yy = rotation.y * rotation.y, zz = rotation.z * rotation.z;
+        const float xy = rotation.x * rotation.y, xz = rotation.x * rotation.z, yz = rotation.y * rotation.z;
+        const float wx = rotation.w * rotation.x, wy = rotation.w * rotation.y, wz = rotation.w * rotation.z;
+
+        return glm::mat4(
+            glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x,
+            glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y,
+            glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z,
+            glm::vec4(position, 1.0f));
+    }
+
+    inline glm::mat4 ComposeTransform(const Transform &transform)
+    {
+        return ComposeTransform(transform.position, transform.rotation, transform.scale);
+    }
+
+    // The render side of the transform nodes. Local transforms are kept in arrays per component, sorted by depth so every
+    // level is one contiguous range whose parents are all in the levels before it. Update propagates the world matrices
+    // one level at a time, the nodes of a level in parallel, and only recomputes nodes whose local transform or parent changed.
+    // A node can drive one render object, whose instance is written straight from the node's world matrix.
+    class TransformHierarchy
+    {
+    private:
+        // Per node, indexed by the game thread's node number
+        std::vector<uint32_t> m_slots;
+
+        // Per slot, sorted by depth once the layout is rebuilt. New nodes are appended until then.
+        std::vector<uint32_t> m_nodes;
+        std::vector<uint32_t> m_parents;
+        std::vector<uint32_t> m_depths;
+        std::vector<glm::vec3> m_positions;
+        std::vector<glm::quat> m_rotations;
+        std::vector<glm::vec3> m_scales;
+        std::vector<glm::mat4> m_worlds;
+        std::vector<uint32_t> m_objects;
+        std::vector<uint8_t> m_localDirty;
+        // Update number in which the world matrix last changed, so flags never have to be cleared
+        std::vector<uint32_t> m_changed;
+
+        // First slot of every level, plus the end of the last one
+        std::vector<uint32_t> m_levels;
+        // Whether any node of a depth has a dirty local transform
+        std::vector<uint8_t> m_dirtyDepths;
+        // Slots that drive a render object and changed in the last Update, filled during propagation in any order.
+        // Sized for every slot that drives a render object.
+        std::vector<uint32_t> m_changedObjectSlots;
+        uint32_t m_changedObjectCount = 0;
+
+        uint32_t m_nodeCount = 0;
+        uint32_t m_updateNumber = 0;
+        uint32_t m_updatedCount = 0;
+        bool m_layoutDirty = false;
+        bool m_objectsDirty = false;
+
+        void MarkDirty(uint32_t slot);
+        // Sorts the live nodes by depth and drops destroyed ones
+        void RebuildLayout();
+        // Returns the number of nodes whose world matrix changed, the ones that drive a render object are added to m_changedObjectSlots
+        uint32_t PropagateLevel(uint32_t first, uint32_t last, std::atomic<uint32_t> &changedObjectCount);
+
+    public:
+        TransformHierarchy() = default;
+        ~TransformHierarchy() = default;
+
+        // Commands are applied in order, nodes are numbered by the game thread and parents are created before their children
+        void Apply(const std::vector<TransformCommand> &commands);
+        // Recomputes the world matrices that changed, call once per frame after Apply
+        void Update(JobSystem &jobSystem);
+        // Writes the world matrices that changed in the last Update to the instances of their render objects, call after
+        // the render objects of the frame were applied
+        void WriteInstances(RetainedScene &scene, JobSystem &jobSystem) const;
+
+        const glm::mat4 &GetWorld(uint32_t node) const { return m_worlds[m_slots[node]]; }
+        uint32_t GetNodeCount() const { return m_nodeCount; }
+        // Nodes whose world matrix changed in the last Update
+        uint32_t GetUpdatedCount() const { return m_updatedCount; }
+    };
+}
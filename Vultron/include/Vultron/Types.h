@@ -4,6 +4,7 @@
 #include "Vultron/Vulkan/VulkanImage.h"
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <vector>
 
@@ -13,17 +14,136 @@
 #define VLT_ASSETS_DIR "assets"
 #endif
 
+#ifndef VLT_CACHE_DIR
+#define VLT_CACHE_DIR "cache"
+#endif
+
 namespace Vultron
 {
 
     // TODO: Make indecies instead of pointers in the future
     using RenderHandle = uint64_t;
 
+    // Small per-batch values that reach the shaders through push constants
+    struct DrawParameters
+    {
+        uint32_t lod = 0;
+        uint32_t flags = 0;
+    };
+
     struct RenderBatch
     {
         RenderHandle mesh;
         RenderHandle material;
         uint32_t firstInstance;
         uint32_t instanceCount;
+        DrawParameters parameters = {};
+    };
+
+    // Dirty instances are tracked in pages of this many instances, 4 KiB of transforms
+    constexpr uint32_t c_instancePageSize = 64;
+
+    // Instances that changed since the previous frame
+    struct InstanceRange
+    {
+        uint32_t firstInstance = 0;
+        uint32_t instanceCount = 0;
+    };
+
+    // Counted by the GPU, resolved a few frames after the frame they belong to
+    struct PipelineStatistics
+    {
+        // Frame the statistics were collected in, zero until the first frame is resolved
+        uint64_t frameNumber = 0;
+        uint64_t inputAssemblyPrimitives = 0;
+        uint64_t vertexShaderInvocations = 0;
+        uint64_t clippingInvocations = 0;
+        uint64_t clippingPrimitives = 0;
+        uint64_t fragmentShaderInvocations = 0;
+    };
+
+    // Counters of one frame. Backends fill what applies to them, the rest stays zero.
+    struct RenderStats
+    {
+        uint64_t frameNumber = 0;
+
+        // Frontend
+        uint64_t submittedJobs = 0;
+        uint64_t batches = 0;
+        // Render objects that exist and the changes made to them for this frame
+        uint64_t renderObjects = 0;
+        uint64_t objectCommands = 0;
+        // Transform nodes that exist and the nodes whose world matrix was recomputed
+        uint64_t transformNodes = 0;
+        uint64_t transformsUpdated = 0;
+
+        // Recording, triangles are before culling and clipping
+        uint64_t drawCalls = 0;
+        uint64_t instances = 0;
+        uint64_t triangles = 0;
+        uint64_t pipelineBinds = 0;
+        uint64_t descriptorBinds = 0;
+        // Batches left out because their pipeline is still compiling
+        uint64_t skippedBatches = 0;
+
+        // Bytes written to GPU visible buffers
+        uint64_t instanceBytesUploaded = 0;
+        uint64_t uniformBytesUploaded = 0;
+
+        // CPU culling, only done by backends that cull
+        uint64_t culledInstances = 0;
+        uint64_t culledTriangles = 0;
+
+        // Frames not read back because callbacks still held every readback buffer
+        uint64_t skippedReadbacks = 0;
+
+        bool pipelineStatisticsSupported = false;
+        PipelineStatistics pipelineStatistics = {};
+
+        // Sums the per frame counters, used to merge what each thread counted
+        RenderStats &operator+=(const RenderStats &other)
+        {
+            submittedJobs += other.submittedJobs;
+            batches += other.batches;
+            renderObjects += other.renderObjects;
+            objectCommands += other.objectCommands;
+            transformNodes += other.transformNodes;
+            transformsUpdated += other.transformsUpdated;
+            drawCalls += other.drawCalls;
+            instances += other.instances;
+            triangles += other.triangles;
+            pipelineBinds += other.pipelineBinds;
+            descriptorBinds += other.descriptorBinds;
+            skippedBatches += other.skippedBatches;
+            instanceBytesUploaded += other.instanceBytesUploaded;
+            uniformBytesUploaded += other.uniformBytesUploaded;
+            culledInstances += other.culledInstances;
+            culledTriangles += other.culledTriangles;
+            skippedReadbacks += other.skippedReadbacks;
+            return *this;
+        }
+    };
+
+    struct Camera
+    {
+        glm::vec3 position = glm::vec3(0.0f, 4.0f, 3.0f);
+        glm::vec3 direction = glm::normalize(glm::vec3(0.0f, -1.0f, -0.3f));
+        glm::vec3 up = glm::vec3(0.0f, 0.0f, 1.0f);
+        float fov = 45.0f; // Vertical, in degrees
+        float nearPlane = 0.1f;
+        float farPlane = 10000.0f;
+    };
+
+    struct DirectionalLight
+    {
+        glm::vec3 direction = glm::vec3(0.0f, 0.0f, 1.0f);
+    };
+
+    // Local transform of a transform node, applied as scale, then rotation, then translation
+    struct Transform
+    {
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 scale = glm::vec3(1.0f);
     };
 }
\ No newline at end of file
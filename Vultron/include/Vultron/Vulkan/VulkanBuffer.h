@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Vultron/Core/Core.h"
+#include "Vultron/Vulkan/VulkanMemory.h"
 #include "Vultron/Vulkan/VulkanUtils.h"
 
 #include "vulkan/vulkan.h"
@@ -36,6 +37,7 @@ namespace Vultron
             VkBufferUsageFlags usage = 0;
             size_t size = 0;
             VmaMemoryUsage allocationUsage = VMA_MEMORY_USAGE_AUTO;
+            MemoryCategory category = MemoryCategory::Other;
         };
         static Ptr<VulkanBuffer> CreatePtr(const BufferCreateInfo &createInfo);
         static VulkanBuffer Create(const BufferCreateInfo &createInfo);
@@ -66,18 +68,19 @@ namespace Vultron
         void CopyData(T *data, size_t size, size_t offset = 0) const
         {
             assert(mapped != nullptr && "Buffer is not mapped.");
-            std::memcpy(mapped, data, size);
+            assert(offset + size <= m_size && "Copy is out of the buffer.");
+            std::memcpy(static_cast<uint8_t *>(mapped) + offset, data, size);
         }
 
         template <typename T>
         void UploadStaged(VkDevice device, VkCommandPool commandPool, VkQueue queue, VmaAllocator allocator, T *data, size_t size, size_t offset = 0)
         {
-            VulkanBuffer stagingBuffer = Create({.allocator = allocator, .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT, .size = size, .allocationUsage = VMA_MEMORY_USAGE_CPU_TO_GPU});
+            VulkanBuffer stagingBuffer = Create({.allocator = allocator, .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT, .size = size, .allocationUsage = VMA_MEMORY_USAGE_CPU_TO_GPU, .category = MemoryCategory::Staging});
             stagingBuffer.Write(allocator, data, size);
 
             VkUtil::CopyBuffer(device, commandPool, queue, stagingBuffer.GetBuffer(), m_buffer, size);
 
-            vmaDestroyBuffer(allocator, stagingBuffer.GetBuffer(), stagingBuffer.GetAllocation());
+            stagingBuffer.Destroy(allocator);
         }
 
         template <typename T>
@@ -15,8 +15,16 @@ namespace Vultron
 #if __APPLE__
             "VK_KHR_portability_subset",
 #endif
-            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME};
+    // Only required when rendering to a window
+    const std::vector<const char *> c_swapchainExtensions = {
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    // Enabled when the device supports them
+    const std::vector<const char *> c_presentWaitExtensions = {
+        VK_KHR_PRESENT_ID_EXTENSION_NAME,
+        VK_KHR_PRESENT_WAIT_EXTENSION_NAME};
+    const std::vector<const char *> c_memoryBudgetExtensions = {
+        VK_EXT_MEMORY_BUDGET_EXTENSION_NAME};
     constexpr std::array<const char *, 1> c_validationLayers = {"VK_LAYER_KHRONOS_validation"};
     constexpr bool c_validationLayersEnabled = false;
 
@@ -32,22 +40,38 @@ namespace Vultron
         VkQueue m_presentQueue;
         VkSurfaceKHR m_surface;
         VmaAllocator m_allocator;
+        bool m_headless = false;
 
-        bool InitializeInstance(const Window &window);
+        // Optional features
+        bool m_presentWaitSupported = false;
+        PFN_vkWaitForPresentKHR m_waitForPresent = nullptr;
+        bool m_debugUtilsSupported = false;
+        PFN_vkCmdBeginDebugUtilsLabelEXT m_cmdBeginDebugLabel = nullptr;
+        PFN_vkCmdEndDebugUtilsLabelEXT m_cmdEndDebugLabel = nullptr;
+        bool m_pipelineStatisticsSupported = false;
+        bool m_inheritedQueriesSupported = false;
+        bool m_memoryBudgetSupported = false;
+
+        bool InitializeInstance(const std::vector<const char *> &windowExtensions);
         bool InitializeSurface(const Window &window);
+        bool InitializeDevice();
         bool InitializePhysicalDevice();
         bool InitializeLogicalDevice();
         bool InitializeAllocator();
 
         // Device context
         bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+        bool CheckDeviceExtensionSupport(VkPhysicalDevice device, const std::vector<const char *> &extensions);
         bool CheckValidationLayerSupport();
+        bool CheckInstanceExtensionSupport(const char *extension);
 
     public:
         VulkanContext() = default;
         ~VulkanContext() = default;
 
         bool Initialize(const Window &window);
+        // No surface or swapchain, for rendering offscreen on machines without a display
+        bool InitializeHeadless();
         void Destroy();
 
         inline VkInstance GetInstance() const { return m_instance; }
@@ -59,5 +83,24 @@ namespace Vultron
         inline VkQueue GetPresentQueue() const { return m_presentQueue; }
         inline VkSurfaceKHR GetSurface() const { return m_surface; }
         inline VmaAllocator GetAllocator() const { return m_allocator; }
+        inline bool IsHeadless() const { return m_headless; }
+
+        // VK_KHR_present_id and VK_KHR_present_wait
+        inline bool IsPresentWaitSupported() const { return m_presentWaitSupported; }
+        VkResult WaitForPresent(VkSwapchainKHR swapchain, uint64_t presentId, uint64_t timeout) const;
+
+        // pipelineStatisticsQuery, enabled when the device has it
+        inline bool IsPipelineStatisticsSupported() const { return m_pipelineStatisticsSupported; }
+        // inheritedQueries, needed to keep a query active across vkCmdExecuteCommands
+        inline bool IsInheritedQueriesSupported() const { return m_inheritedQueriesSupported; }
+
+        // VK_EXT_memory_budget, without it VMA estimates the heap budgets from its own allocations
+        inline bool IsMemoryBudgetSupported() const { return m_memoryBudgetSupported; }
+
+        // VK_EXT_debug_utils, labels show up in captures from RenderDoc, Nsight and similar tools
+        inline bool IsDebugUtilsSupported() const { return m_debugUtilsSupported; }
+        // No-ops when debug utils are not supported
+        void BeginDebugLabel(VkCommandBuffer commandBuffer, const char *name) const;
+        void EndDebugLabel(VkCommandBuffer commandBuffer) const;
     };
 }
\ No newline at end of file
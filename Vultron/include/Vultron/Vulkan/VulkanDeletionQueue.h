@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+
+namespace Vultron
+{
+    // Destroys resources once the GPU has passed the frame timeline value that last used them.
+    class VulkanDeletionQueue
+    {
+    private:
+        std::deque<std::pair<uint64_t, std::function<void()>>> m_entries;
+
+    public:
+        VulkanDeletionQueue() = default;
+        ~VulkanDeletionQueue() = default;
+
+        // Values must not decrease between calls
+        void Push(uint64_t timelineValue, std::function<void()> destroy)
+        {
+            m_entries.emplace_back(timelineValue, std::move(destroy));
+        }
+
+        void Flush(uint64_t completedValue)
+        {
+            while (!m_entries.empty() && m_entries.front().first <= completedValue)
+            {
+                m_entries.front().second();
+                m_entries.pop_front();
+            }
+        }
+
+        // Only when the device is idle
+        void FlushAll()
+        {
+            for (auto &[value, destroy] : m_entries)
+            {
+                destroy();
+            }
+            m_entries.clear();
+        }
+
+        bool IsEmpty() const { return m_entries.empty(); }
+    };
+}
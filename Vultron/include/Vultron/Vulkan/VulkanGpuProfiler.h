@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Vultron/Vulkan/VulkanContext.h"
+
+#include "vulkan/vulkan.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Vultron
+{
+    // Scopes a frame can record, each uses two timestamp queries
+    constexpr uint32_t c_maxGpuScopes = 1024;
+    constexpr uint32_t c_maxGpuScopeDepth = 16;
+    constexpr uint32_t c_invalidGpuScope = ~0u;
+
+    // A resolved scope, scopes are in the order they were begun and a scope's children follow it
+    struct GpuScope
+    {
+        const char *name = nullptr;
+        uint32_t depth = 0;
+        // Distinguishes scopes sharing a name, e.g. the batch index
+        uint32_t index = 0;
+        // Milliseconds
+        float time = 0.0f;
+    };
+
+    // Times nested scopes of a frame with timestamp queries and labels them with debug utils.
+    // Every frame in flight has its own query pool, results are read only once the GPU has finished
+    // the frame, so they are a few frames late but never wait on the GPU.
+    class VulkanGpuProfiler
+    {
+    private:
+        struct Scope
+        {
+            const char *name = nullptr;
+            uint32_t depth = 0;
+            uint32_t index = 0;
+        };
+
+        struct Frame
+        {
+            VkQueryPool queryPool = VK_NULL_HANDLE;
+            std::vector<Scope> scopes;
+            // Frame timeline value signaled once the GPU is done with the frame
+            uint64_t timelineValue = 0;
+            bool pending = false;
+        };
+
+        const VulkanContext *m_context = nullptr;
+        bool m_timestampsSupported = false;
+        double m_timestampPeriod = 0.0;
+        uint64_t m_timestampMask = 0;
+
+        std::vector<Frame> m_frames;
+        Frame *m_recordingFrame = nullptr;
+        std::array<uint32_t, c_maxGpuScopeDepth> m_scopeStack{};
+        uint32_t m_scopeDepth = 0;
+
+        std::vector<uint64_t> m_timestamps;
+        std::vector<GpuScope> m_results;
+        uint64_t m_resultFrame = 0;
+
+    public:
+        VulkanGpuProfiler() = default;
+        ~VulkanGpuProfiler() = default;
+
+        // One query pool per frame slot. Succeeds without timestamp support, scopes are then only labeled.
+        bool Initialize(const VulkanContext &context, uint32_t frameCount);
+        void Destroy(const VulkanContext &context);
+
+        bool IsTimestampSupported() const { return m_timestampsSupported; }
+
+        // Resolves the newest finished frame, never blocks
+        void Resolve(const VulkanContext &context, uint64_t completedValue);
+
+        // Starts recording the scopes of the given frame slot, outside of a render pass.
+        // Unresolved results of the slot are dropped.
+        void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t timelineValue);
+        void EndFrame();
+
+        // Nested scopes on the recording thread, name must outlive the profiler
+        void BeginScope(VkCommandBuffer commandBuffer, const char *name, uint32_t index = 0);
+        void EndScope(VkCommandBuffer commandBuffer);
+
+        // Reserves count consecutive scopes one level below the current scope, so they can be written from
+        // other threads, e.g. into secondary command buffers. Returns c_invalidGpuScope if there is no room left.
+        uint32_t ReserveScopes(const char *name, uint32_t count);
+        // Thread safe for distinct scopes, label may be temporary
+        void BeginReservedScope(VkCommandBuffer commandBuffer, uint32_t scope, const char *label) const;
+        void EndReservedScope(VkCommandBuffer commandBuffer, uint32_t scope) const;
+
+        // Scopes of the most recently resolved frame
+        const std::vector<GpuScope> &GetScopes() const { return m_results; }
+        // Frame number of GetScopes
+        uint64_t GetResultFrame() const { return m_resultFrame; }
+        // Sum of the top level scopes in milliseconds
+        float GetFrameTime() const;
+    };
+}
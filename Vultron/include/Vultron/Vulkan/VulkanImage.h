@@ -2,6 +2,7 @@
 
 #include "Vultron/Core/Core.h"
 #include "Vultron/Vulkan/VulkanContext.h"
+#include "Vultron/Vulkan/VulkanMemory.h"
 
 #include "vk_mem_alloc.h"
 #include "vulkan/vulkan.h"
@@ -30,6 +31,21 @@ namespace Vultron
         void *data = nullptr;
     };
 
+    // Contents of an image file, see VulkanImage::ReadFile
+    struct ImageFileData
+    {
+        struct Mip
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<uint8_t> data;
+        };
+
+        uint32_t numChannels = 0;
+        uint32_t numBytesPerChannel = 0;
+        std::vector<Mip> mips;
+    };
+
     class VulkanImage
     {
     public:
@@ -56,6 +72,7 @@ namespace Vultron
             ImageInfo info = {};
             VkImageAspectFlags aspectFlags = VK_IMAGE_ASPECT_COLOR_BIT;
             VkImageUsageFlags additionalUsageFlags = 0;
+            MemoryCategory category = MemoryCategory::Texture;
         };
 
         static VulkanImage Create(const ImageCreateInfo &createInfo);
@@ -71,6 +88,9 @@ namespace Vultron
             const std::string &filepath;
         };
 
+        // Parses an image file without touching the GPU
+        static ImageFileData ReadFile(const std::string &filepath);
+
         static VulkanImage CreateFromFile(const ImageFromFileCreateInfo &createInfo);
         static Ptr<VulkanImage> CreatePtrFromFile(const ImageFromFileCreateInfo &createInfo);
 
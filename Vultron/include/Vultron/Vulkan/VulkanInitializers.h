@@ -11,5 +11,7 @@
 namespace Vultron::VkInit
 {
     VkDescriptorSet CreateDescriptorSet(VkDevice device, VkDescriptorPool descriptorPool, VkDescriptorSetLayout layout, const std::vector<DescriptorSetBinding> &bindings);
+    // The set must not be in use by the GPU
+    void UpdateDescriptorSet(VkDevice device, VkDescriptorSet descriptorSet, const std::vector<DescriptorSetBinding> &bindings);
     VkDescriptorSetLayout CreateDescriptorSetLayout(VkDevice device, const std::vector<DescriptorSetLayoutBinding> &bindingLayouts);
 }
\ No newline at end of file
@@ -2,31 +2,49 @@
 
 #include "Vultron/Types.h"
 #include "Vultron/Vulkan/VulkanTypes.h"
+#include "Vultron/Vulkan/VulkanPipelineManager.h"
 #include "Vultron/Vulkan/VulkanRenderPass.h"
-#include "Vultron/Vulkan/VulkanSwapchain.h"
 #include "Vultron/Vulkan/VulkanShader.h"
 
 #include "vulkan/vulkan.h"
 
+#include <cassert>
 #include <string>
+#include <type_traits>
 
 namespace Vultron
 {
+    // Guaranteed minimum for maxPushConstantsSize, the material layout reserves all of it
+    constexpr uint32_t c_maxPushConstantSize = 128;
+
+    // Per-batch data, must match the push_constant block in the shaders
+    struct DrawPushConstants
+    {
+        uint32_t baseInstance = 0;
+        uint32_t materialIndex = 0;
+        uint32_t lod = 0;
+        uint32_t flags = 0;
+    };
+
+    constexpr VkShaderStageFlags c_pushConstantStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
     class VulkanMaterialPipeline
     {
     private:
         VulkanShader m_vertexShader{};
         VulkanShader m_fragmentShader{};
+        VkRenderPass m_renderPass{VK_NULL_HANDLE};
+        PipelineState m_defaultState{};
         VkPipeline m_pipeline{VK_NULL_HANDLE};
         VkPipelineLayout m_pipelineLayout{VK_NULL_HANDLE};
         VkDescriptorSetLayout m_descriptorSetLayout{VK_NULL_HANDLE};
 
-        bool InitializeGraphicsPipeline(const VulkanContext &context, const VulkanSwapchain &swapchain, const VulkanRenderPass &renderPass, VkDescriptorSetLayout sceneDescriptorSetLayout);
+        bool InitializePipelineLayout(const VulkanContext &context, VkDescriptorSetLayout sceneDescriptorSetLayout);
         bool InitializeDescriptorSetLayout(const VulkanContext &context, const std::vector<DescriptorSetLayoutBinding> &descriptorSetLayoutBindings);
 
     public:
-        VulkanMaterialPipeline(const VulkanShader &vertexShader, const VulkanShader &fragmentShader)
-            : m_vertexShader(vertexShader), m_fragmentShader(fragmentShader)
+        VulkanMaterialPipeline(const VulkanShader &vertexShader, const VulkanShader &fragmentShader, VkRenderPass renderPass, const PipelineState &defaultState)
+            : m_vertexShader(vertexShader), m_fragmentShader(fragmentShader), m_renderPass(renderPass), m_defaultState(defaultState)
         {
         }
         VulkanMaterialPipeline() = default;
@@ -38,11 +56,26 @@ namespace Vultron
             const VulkanShader &fragmentShader;
             VkDescriptorSetLayout sceneDescriptorSetLayout;
             const std::vector<DescriptorSetLayoutBinding> &bindings;
+            PipelineState defaultState = {};
         };
 
-        static VulkanMaterialPipeline Create(const VulkanContext &context, const VulkanSwapchain &swapchain, const VulkanRenderPass &renderPass, const MaterialCreateInfo &createInfo);
+        // The default pipeline is compiled synchronously, it is also the fallback while variants compile.
+        static VulkanMaterialPipeline Create(const VulkanContext &context, const VulkanRenderPass &renderPass, VulkanPipelineManager &pipelineManager, const MaterialCreateInfo &createInfo);
+        // Pipelines are owned by the pipeline manager, this only destroys the layouts.
         void Destroy(const VulkanContext &context);
 
+        PipelineDescription GetPipelineDescription(const PipelineState &state, const ShaderVariant &variant = {}) const;
+
+        // Writes small per-draw data without touching buffers or descriptor sets
+        template <typename T>
+        void PushConstants(VkCommandBuffer commandBuffer, const T &data, uint32_t offset = 0) const
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Push constants must be trivially copyable.");
+            static_assert(sizeof(T) % 4 == 0 && sizeof(T) <= c_maxPushConstantSize, "Push constants must be a multiple of 4 bytes and fit in 128 bytes.");
+            assert(offset % 4 == 0 && offset + sizeof(T) <= c_maxPushConstantSize);
+            vkCmdPushConstants(commandBuffer, m_pipelineLayout, c_pushConstantStages, offset, sizeof(T), &data);
+        }
+
         VulkanShader GetVertexShader() const { return m_vertexShader; }
         VulkanShader GetFragmentShader() const { return m_fragmentShader; }
         VkPipeline GetPipeline() const { return m_pipeline; }
@@ -54,10 +87,13 @@ namespace Vultron
     {
     private:
         VkDescriptorSet m_descriptorSet;
+        PipelineDescription m_pipelineDescription{};
+        // Resolved lazily once the pipeline manager has compiled it
+        VkPipeline m_pipeline{VK_NULL_HANDLE};
 
     public:
-        VulkanMaterialInstance(VkDescriptorSet descriptorSet)
-            : m_descriptorSet(descriptorSet)
+        VulkanMaterialInstance(VkDescriptorSet descriptorSet, const PipelineDescription &pipelineDescription)
+            : m_descriptorSet(descriptorSet), m_pipelineDescription(pipelineDescription)
         {
         }
         VulkanMaterialInstance() = default;
@@ -66,10 +102,15 @@ namespace Vultron
         struct MaterialInstanceCreateInfo
         {
             const std::vector<DescriptorSetBinding> &bindings;
+            PipelineState pipelineState = {};
+            ShaderVariant variant = {};
         };
 
         static VulkanMaterialInstance Create(const VulkanContext &context, VkDescriptorPool descriptorPool, const VulkanMaterialPipeline &pipeline, const MaterialInstanceCreateInfo &createInfo);
 
         VkDescriptorSet GetDescriptorSet() const { return m_descriptorSet; }
+        const PipelineDescription &GetPipelineDescription() const { return m_pipelineDescription; }
+        VkPipeline GetPipeline() const { return m_pipeline; }
+        void SetPipeline(VkPipeline pipeline) { m_pipeline = pipeline; }
     };
 }
\ No newline at end of file
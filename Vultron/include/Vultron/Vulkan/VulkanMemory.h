@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Vultron/Vulkan/VulkanContext.h"
+
+#include "vulkan/vulkan.h"
+#include "vk_mem_alloc.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Vultron
+{
+    // What an allocation is used for, kept in the allocation's user data and shown as its name in detailed dumps
+    enum class MemoryCategory : uint8_t
+    {
+        Other = 0,
+        Mesh,         // Vertex and index buffers
+        Texture,      // Images loaded from files
+        RenderTarget, // Depth and offscreen color images
+        Instance,     // Per frame instance data
+        Uniform,      // Per frame uniform data
+        Staging,      // Upload buffers, freed once the copy is done
+        Readback,     // Frames copied back to the CPU
+        Count,
+    };
+
+    constexpr size_t c_memoryCategoryCount = static_cast<size_t>(MemoryCategory::Count);
+
+    // Fraction of a heap's budget at which the budget callback reports MemoryPressure::Warning
+    constexpr float c_defaultMemoryWarningFraction = 0.9f;
+    // Usage has to drop this far below the warning fraction before the pressure goes back to normal
+    constexpr float c_memoryPressureHysteresis = 0.05f;
+
+    const char *GetMemoryCategoryName(MemoryCategory category);
+
+    // Counts an allocation towards its category, call right after creating it. The totals are shared by every allocator.
+    void TagAllocation(VmaAllocator allocator, VmaAllocation allocation, MemoryCategory category);
+    // Call right before freeing a tagged allocation, untagged ones are ignored
+    void UntagAllocation(VmaAllocator allocator, VmaAllocation allocation);
+
+    struct MemoryCategoryStats
+    {
+        uint64_t bytes = 0;
+        uint32_t allocations = 0;
+    };
+
+    struct MemoryHeapStats
+    {
+        // Bytes the process can use before allocations start to fail or the driver starts evicting.
+        // With VK_EXT_memory_budget this comes from the driver, otherwise it is an estimate.
+        uint64_t budget = 0;
+        // Bytes the process uses, with VK_EXT_memory_budget this includes memory allocated outside of VMA
+        uint64_t usage = 0;
+        // Bytes of the device memory blocks VMA allocated, and the part of them in use by allocations
+        uint64_t blockBytes = 0;
+        uint64_t allocationBytes = 0;
+        uint32_t allocationCount = 0;
+        bool deviceLocal = false;
+    };
+
+    enum class MemoryPressure : uint8_t
+    {
+        Normal = 0,
+        Warning,    // Usage passed the warning fraction of the budget, time to free memory
+        OverBudget, // Usage passed the budget, allocations may fail or get evicted
+    };
+
+    struct MemoryStats
+    {
+        // Frame the heap budgets were read in
+        uint64_t frameNumber = 0;
+        bool budgetExtensionEnabled = false;
+        std::vector<MemoryHeapStats> heaps;
+        std::array<MemoryCategoryStats, c_memoryCategoryCount> categories = {};
+        // Highest pressure of the device local heaps
+        MemoryPressure pressure = MemoryPressure::Normal;
+    };
+
+    struct MemoryBudgetEvent
+    {
+        uint32_t heapIndex = 0;
+        MemoryPressure pressure = MemoryPressure::Normal;
+        MemoryPressure previousPressure = MemoryPressure::Normal;
+        uint64_t usage = 0;
+        uint64_t budget = 0;
+        bool deviceLocal = false;
+    };
+
+    using MemoryBudgetCallback = std::function<void(const MemoryBudgetEvent &event)>;
+
+    // Reads the heap budgets of the allocator once per frame and reports heaps that run low on memory.
+    // Reading the budgets is cheap, with VK_EXT_memory_budget VMA refreshes them from the driver when the frame index changes.
+    class VulkanMemoryBudget
+    {
+    private:
+        VmaAllocator m_allocator = VK_NULL_HANDLE;
+        bool m_budgetExtensionEnabled = false;
+        std::vector<VmaBudget> m_budgets;
+        std::vector<MemoryPressure> m_heapPressure;
+
+        MemoryBudgetCallback m_callback;
+        float m_warningFraction = c_defaultMemoryWarningFraction;
+
+        std::string m_dumpDirectory;
+        uint32_t m_dumpInterval = 0;
+
+        // Read from any thread
+        mutable std::mutex m_statsMutex;
+        MemoryStats m_stats = {};
+
+        MemoryPressure GetPressure(MemoryPressure current, uint64_t usage, uint64_t budget) const;
+
+    public:
+        VulkanMemoryBudget() = default;
+        ~VulkanMemoryBudget() = default;
+
+        bool Initialize(const VulkanContext &context);
+        void Destroy();
+
+        // Once per frame on the thread that draws. Invokes the callback for every heap whose pressure changed
+        // and writes the periodic dump when one is due.
+        void Update(uint64_t frameNumber);
+
+        // Stats of the last update, thread safe
+        MemoryStats GetStats() const;
+
+        // Called from Update on the thread that draws, so a texture streamer can drop mips before allocations fail.
+        // An empty callback disables it.
+        void SetBudgetCallback(MemoryBudgetCallback callback, float warningFraction = c_defaultMemoryWarningFraction);
+
+        // Writes a summary to directory/memory_<frame>.json every frames frames, 0 disables it.
+        // Written on the thread that draws, keep the interval long.
+        void SetDumpInterval(const std::string &directory, uint32_t frames);
+
+        // Heap budgets, category totals and the output of vmaBuildStatsString as one JSON document.
+        // The detailed dump lists every allocation and can get large.
+        bool WriteStats(const std::string &filepath, bool detailed) const;
+    };
+}
@@ -90,6 +90,9 @@ namespace Vultron
             const std::string &filepath;
         };
 
+        // Parses a mesh file without touching the GPU
+        static void ReadFile(const std::string &filepath, std::vector<StaticMeshVertex> &vertices, std::vector<uint32_t> &indices);
+
         static VulkanMesh CreateFromFile(const MeshFromFilesCreateInfo &createInfo);
         static Ptr<VulkanMesh> CreatePtrFromFile(const MeshFromFilesCreateInfo &createInfo);
 
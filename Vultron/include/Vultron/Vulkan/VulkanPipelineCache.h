@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Vultron/Vulkan/VulkanContext.h"
+
+#include "vulkan/vulkan.h"
+
+#include <string>
+#include <vector>
+
+namespace Vultron
+{
+    // Wraps a VkPipelineCache that is persisted to disk between runs.
+    class VulkanPipelineCache
+    {
+    private:
+        VkPipelineCache m_pipelineCache{VK_NULL_HANDLE};
+        std::string m_filepath;
+        bool m_warm = false;
+
+        static bool ReadCacheFile(const std::string &filepath, std::vector<char> &data);
+        static bool ValidateHeader(const VulkanContext &context, const std::vector<char> &data);
+
+    public:
+        VulkanPipelineCache(VkPipelineCache pipelineCache, const std::string &filepath, bool warm)
+            : m_pipelineCache(pipelineCache), m_filepath(filepath), m_warm(warm)
+        {
+        }
+        VulkanPipelineCache() = default;
+        ~VulkanPipelineCache() = default;
+
+        struct PipelineCacheCreateInfo
+        {
+            const std::string &filepath;
+        };
+
+        static VulkanPipelineCache Create(const VulkanContext &context, const PipelineCacheCreateInfo &createInfo);
+
+        // Writes the cache to a temporary file and renames it over the old one.
+        bool Save(const VulkanContext &context) const;
+        void Destroy(const VulkanContext &context);
+
+        VkPipelineCache GetPipelineCache() const { return m_pipelineCache; }
+        // True if valid cache data was loaded from disk.
+        bool IsWarm() const { return m_warm; }
+    };
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "Vultron/Vulkan/VulkanContext.h"
+
+#include "vulkan/vulkan.h"
+
+#include <array>
+#include <bit>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Vultron
+{
+    enum class VertexLayout : uint8_t
+    {
+        StaticMesh = 0,
+    };
+
+    enum class BlendMode : uint8_t
+    {
+        Opaque = 0,
+        AlphaBlend,
+        Additive,
+    };
+
+    // Fixed function state that materials are allowed to change.
+    struct PipelineState
+    {
+        VertexLayout vertexLayout = VertexLayout::StaticMesh;
+        VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+        VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+        bool depthTest = true;
+        bool depthWrite = true;
+        VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+        BlendMode blendMode = BlendMode::Opaque;
+
+        bool operator==(const PipelineState &other) const = default;
+    };
+
+    // Specialization constants shared by all shader stages, the value is the constant_id in GLSL.
+    enum class ShaderConstant : uint32_t
+    {
+        NormalMapping = 0,
+        AlphaTest,
+        AlphaCutoff,
+        Count
+    };
+
+    // Feature toggles that are constant folded when the pipeline is compiled.
+    struct ShaderVariant
+    {
+        static constexpr uint32_t c_constantCount = static_cast<uint32_t>(ShaderConstant::Count);
+
+        // Every constant is 32 bits, bools are stored as VkBool32 and floats by their bit pattern
+        std::array<uint32_t, c_constantCount> values = {
+            VK_FALSE,                      // NormalMapping
+            VK_FALSE,                      // AlphaTest
+            std::bit_cast<uint32_t>(0.5f), // AlphaCutoff
+        };
+
+        ShaderVariant &Set(ShaderConstant constant, bool value)
+        {
+            values[static_cast<uint32_t>(constant)] = value ? VK_TRUE : VK_FALSE;
+            return *this;
+        }
+
+        ShaderVariant &Set(ShaderConstant constant, float value)
+        {
+            values[static_cast<uint32_t>(constant)] = std::bit_cast<uint32_t>(value);
+            return *this;
+        }
+
+        ShaderVariant &Set(ShaderConstant constant, uint32_t value)
+        {
+            values[static_cast<uint32_t>(constant)] = value;
+            return *this;
+        }
+
+        bool operator==(const ShaderVariant &other) const = default;
+
+        uint64_t GetHash() const;
+        static std::array<VkSpecializationMapEntry, c_constantCount> GetMapEntries();
+    };
+
+    // Everything needed to build a VkPipeline, two equal descriptions share one pipeline.
+    struct PipelineDescription
+    {
+        VkShaderModule vertexShader = VK_NULL_HANDLE;
+        VkShaderModule fragmentShader = VK_NULL_HANDLE;
+        // SPIR-V hashes of the modules above, see VulkanShader::GetCodeHash
+        uint64_t vertexShaderHash = 0;
+        uint64_t fragmentShaderHash = 0;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        PipelineState state = {};
+        ShaderVariant variant = {};
+
+        bool operator==(const PipelineDescription &other) const = default;
+
+        // Stable across runs, handles are left out and only told apart by operator==
+        uint64_t GetHash() const;
+    };
+
+    struct PipelineDescriptionHasher
+    {
+        size_t operator()(const PipelineDescription &description) const { return static_cast<size_t>(description.GetHash()); }
+    };
+
+    constexpr uint32_t c_pipelineCompileThreads = 2;
+
+    class VulkanPipelineManager
+    {
+    private:
+        VkDevice m_device = VK_NULL_HANDLE;
+        VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+
+        std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::condition_variable m_pipelineReady;
+        std::unordered_map<PipelineDescription, VkPipeline, PipelineDescriptionHasher> m_pipelines;
+        std::unordered_set<PipelineDescription, PipelineDescriptionHasher> m_pending;
+        std::deque<PipelineDescription> m_queue;
+        std::vector<std::thread> m_workers;
+        bool m_running = false;
+
+        void WorkerLoop();
+
+    public:
+        VulkanPipelineManager() = default;
+        ~VulkanPipelineManager() = default;
+
+        bool Initialize(const VulkanContext &context, VkPipelineCache pipelineCache, uint32_t workerCount = c_pipelineCompileThreads);
+        void Destroy(const VulkanContext &context);
+
+        // Returns the pipeline, compiling it on the calling thread if it has not been seen yet.
+        VkPipeline GetPipeline(const PipelineDescription &description);
+        // Returns the pipeline if it is ready, otherwise queues it for compilation on a worker and returns VK_NULL_HANDLE.
+        VkPipeline RequestPipeline(const PipelineDescription &description);
+
+        size_t GetPipelineCount();
+        size_t GetPendingCount();
+
+        static VkPipeline CreateGraphicsPipeline(VkDevice device, VkPipelineCache pipelineCache, const PipelineDescription &description);
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Vultron/Types.h"
+#include "Vultron/Vulkan/VulkanContext.h"
+
+#include "vulkan/vulkan.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Vultron
+{
+    // Counters collected by the query, in the order the results are written
+    constexpr VkQueryPipelineStatisticFlags c_pipelineStatisticFlags =
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+    // One pipeline statistics query per frame, with a pool per frame slot. Like the GPU profiler, results are
+    // read only once the GPU has finished the frame, so they never wait on the GPU.
+    class VulkanPipelineStatistics
+    {
+    private:
+        struct Frame
+        {
+            VkQueryPool queryPool = VK_NULL_HANDLE;
+            uint64_t timelineValue = 0;
+            bool pending = false;
+        };
+
+        bool m_supported = false;
+        bool m_inheritedQueriesSupported = false;
+        // The last frame was recorded without the query, the results are from an older frame then
+        bool m_skipped = false;
+        std::vector<Frame> m_frames;
+        Frame *m_recordingFrame = nullptr;
+        PipelineStatistics m_results = {};
+
+    public:
+        VulkanPipelineStatistics() = default;
+        ~VulkanPipelineStatistics() = default;
+
+        // Succeeds without device support, nothing is recorded then
+        bool Initialize(const VulkanContext &context, uint32_t frameCount);
+        void Destroy(const VulkanContext &context);
+
+        bool IsSupported() const { return m_supported; }
+        // Whether the query is active, secondary command buffers recorded now have to inherit c_pipelineStatisticFlags
+        bool IsRecording() const { return m_recordingFrame != nullptr; }
+        bool WasSkipped() const { return m_skipped; }
+
+        // Resolves the newest finished frame, never blocks
+        void Resolve(const VulkanContext &context, uint64_t completedValue);
+
+        // Outside of a render pass. With secondary command buffers the query is skipped unless the device supports
+        // inheritedQueries, see IsRecording.
+        void Begin(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t timelineValue, bool secondaryCommandBuffers);
+        void End(VkCommandBuffer commandBuffer);
+
+        const PipelineStatistics &GetResults() const { return m_results; }
+    };
+}
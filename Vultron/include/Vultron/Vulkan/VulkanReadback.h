@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Vultron/Core/JobSystem.h"
+#include "Vultron/Vulkan/VulkanBuffer.h"
+#include "Vultron/Vulkan/VulkanContext.h"
+
+#include "vulkan/vulkan.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+namespace Vultron
+{
+    // Readback buffers, a few more than frames in flight so a slow callback does not hold up the GPU
+    constexpr uint32_t c_readbackRingSize = 6;
+
+    // Pixels of a finished frame, tightly packed rows. Only valid during the callback.
+    struct ReadbackFrame
+    {
+        uint64_t frameNumber = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+    };
+
+    // Runs on a job system worker, callbacks for different frames may run at the same time
+    using ReadbackCallback = std::function<void(const ReadbackFrame &frame)>;
+
+    // Copies the color target into a ring of host cached buffers and hands finished frames to a callback.
+    class VulkanReadback
+    {
+    private:
+        struct Slot
+        {
+            VulkanBuffer buffer;
+            // Frame timeline value signaled once the copy into this slot is done
+            uint64_t timelineValue = 0;
+            bool copyPending = false;
+            JobCounter callbackCounter;
+        };
+
+        std::array<Slot, c_readbackRingSize> m_slots;
+        uint32_t m_nextSlot = 0;
+
+        JobSystem *m_jobSystem = nullptr;
+        ReadbackCallback m_callback;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+        VkFormat m_format = VK_FORMAT_UNDEFINED;
+        size_t m_frameSize = 0;
+
+        void Dispatch(const VulkanContext &context, Slot &slot);
+
+    public:
+        VulkanReadback() = default;
+        ~VulkanReadback() = default;
+
+        // Formats with 4 bytes per pixel only
+        bool Initialize(const VulkanContext &context, JobSystem &jobSystem, uint32_t width, uint32_t height, VkFormat format, ReadbackCallback callback);
+        // Waits for running callbacks, pending copies must have been polled first
+        void Destroy(const VulkanContext &context);
+
+        bool IsInitialized() const { return m_jobSystem != nullptr; }
+
+        // Hands every slot whose copy the GPU has finished to the callback, never blocks
+        void Poll(const VulkanContext &context, uint64_t completedValue);
+
+        // False while the callback of the slot the next copy goes to is still running, checked before recording
+        bool IsSlotAvailable() const { return m_slots[m_nextSlot].callbackCounter.IsDone(); }
+
+        // Records the copy of an image in TRANSFER_SRC_OPTIMAL layout, after the render pass that wrote it.
+        // Never waits, only call it while IsSlotAvailable.
+        void RecordCopy(VkCommandBuffer commandBuffer, VkImage image, uint64_t timelineValue);
+    };
+}
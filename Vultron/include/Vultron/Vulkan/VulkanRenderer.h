@@ -1,24 +1,36 @@
 #pragma once
 
 #include "Vultron/Core/Core.h"
+#include "Vultron/Core/JobSystem.h"
+#include "Vultron/RenderBackend.h"
 #include "Vultron/Types.h"
 #include "Vultron/Window.h"
 #include "Vultron/Vulkan/VulkanTypes.h"
 #include "Vultron/Vulkan/VulkanUtils.h"
 #include "Vultron/Vulkan/VulkanContext.h"
+#include "Vultron/Vulkan/VulkanDeletionQueue.h"
+#include "Vultron/Vulkan/VulkanGpuProfiler.h"
 #include "Vultron/Vulkan/VulkanMaterial.h"
+#include "Vultron/Vulkan/VulkanMemory.h"
 #include "Vultron/Vulkan/VulkanBuffer.h"
 #include "Vultron/Vulkan/VulkanImage.h"
 #include "Vultron/Vulkan/VulkanMesh.h"
+#include "Vultron/Vulkan/VulkanPipelineCache.h"
+#include "Vultron/Vulkan/VulkanPipelineManager.h"
+#include "Vultron/Vulkan/VulkanPipelineStatistics.h"
+#include "Vultron/Vulkan/VulkanReadback.h"
 #include "Vultron/Vulkan/VulkanRenderPass.h"
 #include "Vultron/Vulkan/VulkanResourcePool.h"
 #include "Vultron/Vulkan/VulkanShader.h"
+#include "Vultron/Vulkan/VulkanShaderBundle.h"
 #include "Vultron/Vulkan/VulkanSwapchain.h"
 
 #include "vk_mem_alloc.h"
 #include "vulkan/vulkan.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <optional>
 
 namespace Vultron
@@ -26,10 +38,16 @@ namespace Vultron
     struct TexturedMaterial
     {
         RenderHandle texture;
+        std::optional<RenderHandle> normalTexture = std::nullopt;
+        bool alphaTest = false;
+        float alphaCutoff = 0.5f;
+        PipelineState pipelineState = {};
 
         std::vector<DescriptorSetBinding> GetBindings(const ResourcePool &pool, VkSampler sampler) const
         {
             const auto &image = pool.GetImage(texture);
+            // The normal map slot always needs a valid view, it is never sampled unless normal mapping is on
+            const auto &normalImage = pool.GetImage(normalTexture.value_or(texture));
             return {
                 {
                     .binding = 0,
@@ -37,23 +55,53 @@ namespace Vultron
                     .imageView = image.GetImageView(),
                     .sampler = sampler,
                 },
+                {
+                    .binding = 1,
+                    .type = DescriptorType::CombinedImageSampler,
+                    .imageView = normalImage.GetImageView(),
+                    .sampler = sampler,
+                },
             };
         }
+
+        ShaderVariant GetShaderVariant() const
+        {
+            ShaderVariant variant = ShaderVariant()
+                                        .Set(ShaderConstant::NormalMapping, normalTexture.has_value())
+                                        .Set(ShaderConstant::AlphaTest, alphaTest);
+
+            // The cutoff is unused without alpha test, leaving it at the default keeps those materials on one pipeline
+            if (alphaTest)
+            {
+                variant.Set(ShaderConstant::AlphaCutoff, alphaCutoff);
+            }
+
+            return variant;
+        }
     };
 
+    constexpr uint32_t c_maxRecordingThreads = 16;
+
     struct FrameData
     {
         VkSemaphore imageAvailableSemaphore;
         VkSemaphore renderFinishedSemaphore;
-        VkFence inFlightFence;
+        // Frame timeline value signaled when the last submission using this frame data is done
+        uint64_t timelineValue = 0;
 
         VkCommandBuffer commandBuffer;
 
+        // One pool per recording thread so pools are never shared between threads
+        std::array<VkCommandPool, c_maxRecordingThreads> recordingPools{};
+        std::array<VkCommandBuffer, c_maxRecordingThreads> secondaryCommandBuffers{};
+
         // Global scene data resources
-        VulkanBuffer instanceBuffer;
-        uint32_t instanceCount = 0;
         VulkanBuffer uniformBuffer;
         VkDescriptorSet descriptorSet;
+        // Instance buffer the descriptor set points at, rebound after the instance buffer grew
+        VkBuffer boundInstanceBuffer = VK_NULL_HANDLE;
+        // Changed instances of this frame on their way to the instance buffer, grows to the largest upload
+        VulkanBuffer instanceStagingBuffer;
     };
 
     struct InstanceData
@@ -74,24 +122,70 @@ namespace Vultron
 
     static_assert(sizeof(UniformBufferData) % 16 == 0);
 
-    constexpr uint32_t c_maxSets = 10;
+    constexpr uint32_t c_maxSets = 16;
     constexpr uint32_t c_maxUniformBuffers = 10;
     constexpr uint32_t c_maxStorageBuffers = 10;
-    constexpr uint32_t c_maxCombinedImageSamplers = 10;
-    constexpr size_t c_maxInstances = 2000;
-    constexpr uint32_t c_frameOverlap = 2;
+    constexpr uint32_t c_maxCombinedImageSamplers = 20;
+    // Instances the instance buffer starts out with, it grows to fit the scene
+    constexpr size_t c_initialInstanceCapacity = 2048;
+    // Frame data is allocated for the maximum, SetFramesInFlight picks how many are cycled through
+    constexpr uint32_t c_maxFramesInFlight = 4;
+    constexpr uint32_t c_defaultFramesInFlight = 2;
+    static_assert(c_readbackRingSize >= c_maxFramesInFlight + 2, "Readback slots must outlast the frames in flight.");
+
+    // Color target format when rendering without a swapchain
+    constexpr VkFormat c_offscreenColorFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+    // Recent frames whose input time is kept for latency measurements
+    constexpr uint32_t c_latencyHistory = 8;
+    // Upper bound for present wait pacing, so a hidden window does not stall the frame loop
+    constexpr uint64_t c_presentWaitTimeout = 100'000'000;
+
+    // What to do with a batch whose pipeline is still compiling
+    enum class PipelineFallback
+    {
+        Default = 0, // Draw with the material's default pipeline
+        Skip,        // Skip the batch for this frame
+    };
 
-    class VulkanRenderer
+    class VulkanRenderer : public RenderBackend
     {
     private:
         VulkanContext m_context;
 
         // Swap chain
         VulkanSwapchain m_swapchain;
+        PresentPolicy m_presentPolicy = PresentPolicy::Throughput;
+        bool m_swapchainDirty = false;
+        VkExtent2D m_requestedExtent = {};
+
+        // Offscreen targets used instead of the swapchain when headless
+        VulkanImage m_colorImage;
+        VkFramebuffer m_offscreenFramebuffer = VK_NULL_HANDLE;
+        VulkanReadback m_readback;
+
+        // Resize latency, from the first Resize call to the first present on a matching swapchain
+        bool m_resizePending = false;
+        bool m_resizeRecreated = false;
+        std::chrono::high_resolution_clock::time_point m_resizeStartTime = {};
+        float m_resizeLatency = 0.0f;
+
+        // Frame pacing and latency
+        bool m_presentWaitEnabled = false;
+        float m_frameRateLimit = 0.0f;
+        std::chrono::high_resolution_clock::time_point m_nextFrameTime = {};
+        uint64_t m_lastPresentId = 0;
+        std::array<std::chrono::high_resolution_clock::time_point, c_latencyHistory> m_inputTimes = {};
+        float m_latency = 0.0f;
 
         // Render pass
         VulkanRenderPass m_renderPass;
 
+        // Pipeline cache, persisted between runs
+        VulkanPipelineCache m_pipelineCache;
+        VulkanPipelineManager m_pipelineManager;
+        PipelineFallback m_pipelineFallback = PipelineFallback::Default;
+
         // Material pipeline
         VulkanMaterialPipeline m_materialPipeline;
         VkDescriptorSetLayout m_descriptorSetLayout;
@@ -100,31 +194,73 @@ namespace Vultron
         // Material instance resources
         UniformBufferData m_uniformBufferData{};
         VulkanImage m_depthImage;
+        VkExtent2D m_depthExtent = {};
         VkSampler m_textureSampler;
         VkSampler m_depthSampler;
 
         // Command pool
         VkCommandPool m_commandPool;
 
+        // Parallel command recording on the engine job system, 1 records inline into the primary command buffer
+        JobSystem *m_jobSystem = nullptr;
+        uint32_t m_recordingThreadCount = 1;
+        std::vector<VkPipeline> m_batchPipelines;
+        float m_recordingTime = 0.0f;
+
         // Debugging
         VkDebugUtilsMessengerEXT m_debugMessenger;
 
+        // Device local instance buffer shared by all frames, copies from the frames' staging buffers are ordered by barriers
+        VulkanBuffer m_instanceBuffer;
+        size_t m_instanceCapacity = 0;
+        // One bit per c_instancePageSize instances that changed since they were last staged
+        std::vector<uint64_t> m_dirtyInstancePages;
+        std::vector<VkBufferCopy> m_instanceCopies;
+
         // Frame data
-        FrameData m_frames[c_frameOverlap];
+        FrameData m_frames[c_maxFramesInFlight];
         uint32_t m_currentFrameIndex = 0;
+        uint32_t m_framesInFlight = c_defaultFramesInFlight;
+
+        // Counts submitted frames, the GPU signals the frame number when it finishes a frame
+        VkSemaphore m_frameTimeline = VK_NULL_HANDLE;
+        uint64_t m_frameNumber = 0;
+        float m_frameWaitTime = 0.0f;
+
+        // GPU timing of passes and, when enabled, of every batch
+        VulkanGpuProfiler m_gpuProfiler;
+        bool m_gpuBatchScopesEnabled = false;
+
+        // Counters of the last frame, each recording thread counts into its own slot and they are summed after recording
+        RenderStats m_stats = {};
+        std::array<RenderStats, c_maxRecordingThreads> m_threadStats = {};
+        VulkanPipelineStatistics m_pipelineStatistics;
+
+        // Heap budgets and per category totals, read once per frame
+        VulkanMemoryBudget m_memoryBudget;
+
+        // Resources retired while frames may still use them
+        VulkanDeletionQueue m_deletionQueue;
 
         // Assets, will be removed in the future
+        VulkanShaderBundle m_shaderBundle;
         VulkanShader m_vertexShader;
         VulkanShader m_fragmentShader;
 
         // Permanent resources
         ResourcePool m_resourcePool;
 
+        // Everything after the context and swapchain, shared by windowed and headless renderers
+        bool InitializeResources();
+
         // Render pass
         bool InitializeRenderPass();
+        bool InitializeOffscreenTarget();
         bool InitializeFramebuffers();
 
         // Material pipeline
+        bool InitializePipelineCache();
+        bool InitializePipelineManager();
         bool InitializeDescriptorSetLayout();
         bool InitializeGraphicsPipeline();
 
@@ -147,38 +283,132 @@ namespace Vultron
         // Assets, will be removed in the future
         bool InitializeTestResources();
 
-        // Swapchain
-        void RecreateSwapchain(uint32_t width, uint32_t height);
+        // Size and format of the image being rendered to, the swapchain or the offscreen target
+        VkExtent2D GetTargetExtent() const { return m_context.IsHeadless() ? m_requestedExtent : m_swapchain.GetExtent(); }
+        VkFormat GetTargetFormat() const { return m_context.IsHeadless() ? c_offscreenColorFormat : m_swapchain.GetImageFormat(); }
+
+        // Swapchain, returns false if it cannot be created right now, e.g. while minimized
+        bool RecreateSwapchain();
 
         // Validation/debugging
         bool InitializeDebugMessenger();
 
+        // Returns VK_NULL_HANDLE if the batch should be skipped this frame
+        VkPipeline ResolvePipeline(VulkanMaterialInstance &material);
+
+        // CPU work that does not touch per-frame GPU resources, done before waiting on the frame
+        void PrepareBatches(const std::vector<RenderBatch> &batches);
+
+        // The instance buffer is kept between frames and only gets the pages that changed
+        void MarkInstancesDirty(const std::vector<InstanceRange> &dirtyInstances);
+        // Grows the instance buffer, the old one is destroyed once the frames using it are done
+        void ReserveInstances(size_t instanceCount);
+        // Writes the dirty pages into the frame's staging buffer and queues their copies, returns the bytes staged
+        size_t StageInstances(FrameData &frame, const std::vector<glm::mat4> &instances);
+        // Copies the staged instances, between the previous frames' and this frame's vertex shaders
+        void RecordInstanceCopies(VkCommandBuffer commandBuffer, const FrameData &frame) const;
+
         // Command buffer
-        void WriteCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<RenderBatch> &batches);
+        void WriteCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<RenderBatch> &batches, bool copyReadback);
+        // firstScope is the profiler scope of the first batch, or c_invalidGpuScope to not time the batches. Adds what was recorded to stats.
+        void RecordBatches(VkCommandBuffer commandBuffer, const FrameData &frame, const RenderBatch *batches, const VkPipeline *pipelines, size_t count, uint32_t firstScope,
+                           RenderStats &stats) const;
 
     public:
         VulkanRenderer() = default;
         ~VulkanRenderer() = default;
 
-        bool Initialize(const Window &window);
-        void Draw(const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances);
-        void Shutdown();
+        bool Initialize(const Window &window, JobSystem &jobSystem) override;
+        // Renders into an offscreen color target of the given size, needs no window, surface or display
+        bool InitializeHeadless(uint32_t width, uint32_t height, JobSystem &jobSystem) override;
+        bool IsHeadless() const override { return m_context.IsHeadless(); }
+        // inputTime is when the input for this frame was sampled, used for the latency measurement
+        void Draw(const Camera &camera, const DirectionalLight &light, const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances,
+                  const std::vector<InstanceRange> &dirtyInstances, std::chrono::high_resolution_clock::time_point inputTime) override;
+        void Shutdown() override;
 
-        RenderHandle LoadMesh(const std::string &filepath);
-        RenderHandle LoadImage(const std::string &filepath);
+        RenderHandle LoadMesh(const std::string &filepath) override;
+        RenderHandle LoadImage(const std::string &filepath) override;
 
-        template <typename T>
-        RenderHandle CreateMaterial(const T &materialCreateInfo)
+        RenderHandle CreateMaterial(const TexturedMaterial &materialCreateInfo) override
         {
             std::vector<DescriptorSetBinding> bindings = materialCreateInfo.GetBindings(m_resourcePool, m_textureSampler);
             auto materialInstance = VulkanMaterialInstance::Create(
                 m_context, m_descriptorPool, m_materialPipeline,
                 {
-                    bindings,
+                    .bindings = bindings,
+                    .pipelineState = materialCreateInfo.pipelineState,
+                    .variant = materialCreateInfo.GetShaderVariant(),
                 });
 
+            // Start compiling the variant in the background right away
+            materialInstance.SetPipeline(m_pipelineManager.RequestPipeline(materialInstance.GetPipelineDescription()));
+
             return m_resourcePool.AddMaterialInstance(materialInstance);
         }
+
+        void SetPipelineFallback(PipelineFallback fallback) { m_pipelineFallback = fallback; }
+
+        // Number of threads that record the batches of a frame, clamped to [1, c_maxRecordingThreads]
+        void SetRecordingThreadCount(uint32_t count) override { m_recordingThreadCount = std::clamp(count, 1u, c_maxRecordingThreads); }
+        uint32_t GetRecordingThreadCount() const { return m_recordingThreadCount; }
+
+        // CPU time spent recording the last frame in milliseconds
+        float GetRecordingTime() const override { return m_recordingTime; }
+
+        // Frames the CPU may run ahead of the GPU, clamped to [1, c_maxFramesInFlight]
+        void SetFramesInFlight(uint32_t count) override { m_framesInFlight = std::clamp(count, 1u, c_maxFramesInFlight); }
+        uint32_t GetFramesInFlight() const { return m_framesInFlight; }
+
+        // Milliseconds the last frame blocked waiting for the GPU to release its frame data
+        float GetFrameWaitTime() const override { return m_frameWaitTime; }
+
+        // GPU milliseconds of the most recently finished frame, zero when timestamps are not supported
+        float GetGpuTime() const override { return m_gpuProfiler.GetFrameTime(); }
+        // Per pass GPU times of the most recently finished frame, a few frames behind
+        std::vector<GpuScope> GetGpuScopes() const override { return m_gpuProfiler.GetScopes(); }
+        // Also times and labels every batch, costs two timestamps per batch
+        void SetGpuBatchScopesEnabled(bool enabled) override { m_gpuBatchScopesEnabled = enabled; }
+
+        // Counters of the last frame, pipeline statistics are from the most recently finished frame
+        RenderStats GetRenderStats() const override;
+
+        // Heap budgets of the last frame and bytes per category, thread safe
+        MemoryStats GetMemoryStats() const override { return m_memoryBudget.GetStats(); }
+        // Called on the drawing thread when a heap passes warningFraction of its budget, goes over it or recovers
+        void SetMemoryBudgetCallback(MemoryBudgetCallback callback, float warningFraction) override { m_memoryBudget.SetBudgetCallback(std::move(callback), warningFraction); }
+        // Writes a summary to directory every frames frames, 0 disables it
+        void SetMemoryDumpInterval(const std::string &directory, uint32_t frames) override { m_memoryBudget.SetDumpInterval(directory, frames); }
+        // Thread safe, detailed also lists every allocation
+        bool WriteMemoryStats(const std::string &filepath, bool detailed) const override { return m_memoryBudget.WriteStats(filepath, detailed); }
+
+        // Copies every frame back to the CPU and hands it to the callback on a worker a few frames later.
+        // Frames are skipped, never waited for, while callbacks hold every buffer. See RenderStats::skippedReadbacks.
+        // Headless only, returns false otherwise. An empty callback stops the readback.
+        bool SetReadbackCallback(ReadbackCallback callback) override;
+
+        // New window framebuffer size, the swapchain is recreated before the next frame. A zero size skips frames.
+        // Ignored when headless, the offscreen target keeps its size.
+        void Resize(uint32_t width, uint32_t height) override;
+        // Milliseconds from the last resize to the first frame presented at the new size
+        float GetResizeLatency() const override { return m_resizeLatency; }
+
+        // The swapchain is recreated with the new policy before the next frame
+        void SetPresentPolicy(PresentPolicy policy) override;
+        PresentPolicy GetPresentPolicy() const { return m_presentPolicy; }
+
+        // Frames per second for the CPU frame limiter, 0 disables it
+        void SetFrameRateLimit(float framesPerSecond) override { m_frameRateLimit = std::max(framesPerSecond, 0.0f); }
+        // Start a frame only once the previous one is on screen, needs VK_KHR_present_wait
+        void SetPresentWaitEnabled(bool enabled) override { m_presentWaitEnabled = enabled; }
+        bool IsPresentWaitSupported() const override { return m_context.IsPresentWaitSupported(); }
+
+        // Blocks according to the frame limiter and present wait settings, call before sampling input
+        void PaceFrame() override;
+
+        // Milliseconds from input sampling to present of the most recently measured frame.
+        // With present wait this is when the image was shown, otherwise when it was queued for presentation.
+        float GetLatency() const override { return m_latency; }
     };
 
 }
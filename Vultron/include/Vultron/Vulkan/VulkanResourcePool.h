@@ -46,6 +46,7 @@ namespace Vultron
         const VulkanMesh &GetMesh(RenderHandle id) const { return m_meshes.at(id); }
         const VulkanImage &GetImage(RenderHandle id) const { return m_images.at(id); }
         const VulkanMaterialInstance &GetMaterialInstance(RenderHandle id) const { return m_materialInstances.at(id); }
+        VulkanMaterialInstance &GetMaterialInstance(RenderHandle id) { return m_materialInstances.at(id); }
 
         void Destroy(const VulkanContext &context)
         {
@@ -14,13 +14,16 @@ namespace Vultron
     {
     private:
         VkShaderModule m_ShaderModule;
+        uint64_t m_CodeHash = 0;
 
     public:
-        VulkanShader(VkShaderModule shaderModule) : m_ShaderModule(shaderModule) {}
+        VulkanShader(VkShaderModule shaderModule, uint64_t codeHash = 0) : m_ShaderModule(shaderModule), m_CodeHash(codeHash) {}
         VulkanShader() = default;
         ~VulkanShader() = default;
 
         VkShaderModule GetShaderModule() const { return m_ShaderModule; }
+        // Hash of the SPIR-V the module was created from, the same across runs unlike the handle
+        uint64_t GetCodeHash() const { return m_CodeHash; }
 
         struct ShaderCreateInfo
         {
@@ -30,6 +33,15 @@ namespace Vultron
         static VulkanShader Create(const ShaderCreateInfo &createInfo);
         static Ptr<VulkanShader> CreatePtr(const ShaderCreateInfo &createInfo);
 
+        // Creates the module straight from SPIR-V words without copying them
+        struct ShaderFromCodeCreateInfo
+        {
+            VkDevice device = VK_NULL_HANDLE;
+            const uint32_t *code = nullptr;
+            size_t codeSize = 0; // In bytes
+        };
+        static VulkanShader CreateFromCode(const ShaderFromCodeCreateInfo &createInfo);
+
         struct ShaderFromFileCreateInfo
         {
             VkDevice device = VK_NULL_HANDLE;
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Vultron/Core/MappedFile.h"
+#include "Vultron/Vulkan/VulkanContext.h"
+#include "Vultron/Vulkan/VulkanShader.h"
+
+#include "vulkan/vulkan.h"
+
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Vultron
+{
+    // Layout of the file written by tools/pack_shaders.py, all values little endian.
+    constexpr uint32_t c_shaderBundleMagic = 0x31425356; // "VSB1"
+    constexpr uint32_t c_shaderBundleVersion = 1;
+
+    struct ShaderBundleHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t reserved;
+    };
+
+    struct ShaderBundleEntry
+    {
+        uint64_t nameHash;
+        uint64_t variantHash;
+        uint64_t offset;
+        uint64_t size;
+        char name[64];
+    };
+
+    static_assert(sizeof(ShaderBundleHeader) == 16);
+    static_assert(sizeof(ShaderBundleEntry) == 96);
+
+    // Precompiled SPIR-V modules mapped from a single file, modules are created on first use.
+    class VulkanShaderBundle
+    {
+    private:
+        VkDevice m_device = VK_NULL_HANDLE;
+        MappedFile m_file;
+        const ShaderBundleEntry *m_entries = nullptr;
+        uint32_t m_entryCount = 0;
+
+        std::mutex m_mutex;
+        std::unordered_map<uint64_t, VulkanShader> m_shaders;
+
+        static uint64_t GetKey(uint64_t nameHash, uint64_t variantHash);
+        const ShaderBundleEntry *FindEntry(uint64_t nameHash, uint64_t variantHash) const;
+
+    public:
+        VulkanShaderBundle() = default;
+        ~VulkanShaderBundle() = default;
+
+        struct ShaderBundleCreateInfo
+        {
+            const std::string &filepath;
+        };
+
+        bool Initialize(const VulkanContext &context, const ShaderBundleCreateInfo &createInfo);
+        void Destroy(const VulkanContext &context);
+
+        bool IsLoaded() const { return m_file.IsOpen(); }
+        bool Contains(std::string_view name, uint64_t variantHash = 0) const;
+
+        // The bundle owns the returned module, do not destroy it.
+        VulkanShader GetShader(std::string_view name, uint64_t variantHash = 0);
+    };
+}
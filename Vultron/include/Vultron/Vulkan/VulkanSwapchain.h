@@ -9,6 +9,13 @@
 
 namespace Vultron
 {
+    enum class PresentPolicy
+    {
+        LowLatency = 0, // IMMEDIATE or MAILBOX with as few images as the surface allows
+        Throughput,     // MAILBOX with an extra image, FIFO when unavailable
+        VSync,          // FIFO, never tears
+    };
+
     class VulkanSwapchain
     {
     private:
@@ -18,15 +25,17 @@ namespace Vultron
         std::vector<VkFramebuffer> m_swapchainFramebuffers;
         VkFormat m_swapchainImageFormat;
         VkExtent2D m_swapchainExtent;
+        VkPresentModeKHR m_presentMode;
 
-        bool InitializeSwapChain(const VulkanContext &context, uint32_t width, uint32_t height);
+        bool InitializeSwapChain(const VulkanContext &context, uint32_t width, uint32_t height, PresentPolicy policy, VkSwapchainKHR oldSwapchain);
         bool InitializeImageViews(const VulkanContext &context);
 
     public:
         VulkanSwapchain() = default;
         ~VulkanSwapchain() = default;
 
-        bool Initialize(const VulkanContext &context, uint32_t width, uint32_t height);
+        // Passing the swapchain being replaced lets presentation continue while the new one is created
+        bool Initialize(const VulkanContext &context, uint32_t width, uint32_t height, PresentPolicy policy = PresentPolicy::Throughput, VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
         void Destroy(const VulkanContext &context);
 
         inline VkSwapchainKHR GetSwapchain() const { return m_swapchain; }
@@ -36,5 +45,6 @@ namespace Vultron
         inline std::vector<VkFramebuffer> &GetFramebuffers() { return m_swapchainFramebuffers; }
         inline VkFormat GetImageFormat() const { return m_swapchainImageFormat; }
         inline VkExtent2D GetExtent() const { return m_swapchainExtent; }
+        inline VkPresentModeKHR GetPresentMode() const { return m_presentMode; }
     };
 }
\ No newline at end of file
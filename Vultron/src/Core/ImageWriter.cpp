@@ -0,0 +1,129 @@
+#include "Vultron/Core/ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <vector>
+
+namespace Vultron
+{
+    // Largest payload of a stored deflate block
+    constexpr size_t c_maxStoredBlockSize = 65535;
+
+    static const std::array<uint32_t, 256> s_crcTable = []()
+    {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (uint32_t bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    static uint32_t UpdateCrc(uint32_t crc, const uint8_t *data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            crc = s_crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    static void AppendBigEndian(std::vector<uint8_t> &out, uint32_t value)
+    {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static void AppendChunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data)
+    {
+        AppendBigEndian(out, static_cast<uint32_t>(data.size()));
+        const size_t typeOffset = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        AppendBigEndian(out, UpdateCrc(0xFFFFFFFFu, out.data() + typeOffset, data.size() + 4) ^ 0xFFFFFFFFu);
+    }
+
+    bool WriteImageRaw(const std::string &filepath, const uint8_t *data, size_t size)
+    {
+        std::ofstream file(filepath, std::ios::out | std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char *>(data), size);
+        return file.good();
+    }
+
+    bool WriteImagePNG(const std::string &filepath, uint32_t width, uint32_t height, const uint8_t *rgba)
+    {
+        const size_t rowSize = static_cast<size_t>(width) * 4;
+
+        // Scanlines with a leading filter byte, filter type 0 keeps encoding a plain copy
+        std::vector<uint8_t> scanlines(static_cast<size_t>(height) * (rowSize + 1));
+        for (uint32_t y = 0; y < height; y++)
+        {
+            uint8_t *row = scanlines.data() + y * (rowSize + 1);
+            row[0] = 0;
+            std::copy(rgba + y * rowSize, rgba + (y + 1) * rowSize, row + 1);
+        }
+
+        // zlib stream of stored blocks
+        std::vector<uint8_t> idat;
+        idat.reserve(scanlines.size() + scanlines.size() / c_maxStoredBlockSize * 5 + 16);
+        idat.push_back(0x78);
+        idat.push_back(0x01);
+
+        uint32_t adlerA = 1;
+        uint32_t adlerB = 0;
+        for (size_t offset = 0;; offset += c_maxStoredBlockSize)
+        {
+            const size_t blockSize = std::min(c_maxStoredBlockSize, scanlines.size() - offset);
+            const bool last = offset + blockSize == scanlines.size();
+
+            idat.push_back(last ? 1 : 0);
+            idat.push_back(static_cast<uint8_t>(blockSize));
+            idat.push_back(static_cast<uint8_t>(blockSize >> 8));
+            idat.push_back(static_cast<uint8_t>(~blockSize));
+            idat.push_back(static_cast<uint8_t>(~blockSize >> 8));
+            idat.insert(idat.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+
+            for (size_t i = offset; i < offset + blockSize; i++)
+            {
+                adlerA = (adlerA + scanlines[i]) % 65521;
+                adlerB = (adlerB + adlerA) % 65521;
+            }
+
+            if (last)
+            {
+                break;
+            }
+        }
+        AppendBigEndian(idat, (adlerB << 16) | adlerA);
+
+        std::vector<uint8_t> header;
+        AppendBigEndian(header, width);
+        AppendBigEndian(header, height);
+        header.push_back(8); // Bit depth
+        header.push_back(6); // RGBA
+        header.push_back(0); // Deflate
+        header.push_back(0); // Adaptive filtering
+        header.push_back(0); // No interlace
+
+        std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        png.reserve(idat.size() + 64);
+        AppendChunk(png, "IHDR", header);
+        AppendChunk(png, "IDAT", idat);
+        AppendChunk(png, "IEND", {});
+
+        return WriteImageRaw(filepath, png.data(), png.size());
+    }
+}
@@ -0,0 +1,374 @@
+#include "Vultron/Core/JobSystem.h"
+
+#include "Vultron/Core/Profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <iostream>
+#include <limits>
+
+namespace Vultron
+{
+    constexpr uint32_t c_noQueue = (std::numeric_limits<uint32_t>::max)();
+    // Yields before an idle worker goes to sleep
+    constexpr uint32_t c_idleSpinCount = 64;
+
+    // Queue of the current thread, workers use indices after the external threads
+    thread_local uint32_t t_queueIndex = c_noQueue;
+
+    bool JobSystem::Initialize(uint32_t workerCount)
+    {
+        if (workerCount == 0)
+        {
+            workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        }
+
+        for (uint32_t i = 0; i < c_maxExternalThreads + workerCount; i++)
+        {
+            m_queues.push_back(std::make_unique<ThreadQueue>());
+        }
+
+        m_running = true;
+        RegisterThread();
+
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            m_workers.emplace_back(&JobSystem::WorkerLoop, this, c_maxExternalThreads + i);
+        }
+
+        std::cout << "Started job system with " << workerCount << " workers." << std::endl;
+
+        return true;
+    }
+
+    void JobSystem::Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_running = false;
+        }
+        m_wakeCondition.notify_all();
+
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+
+        m_workers.clear();
+        m_queues.clear();
+        for (Job *job : m_backgroundJobs)
+        {
+            delete job;
+        }
+        m_backgroundJobs.clear();
+        m_externalThreadMask = 0;
+        t_queueIndex = c_noQueue;
+    }
+
+    void JobSystem::RegisterThread()
+    {
+        if (t_queueIndex != c_noQueue)
+        {
+            return;
+        }
+
+        uint32_t mask = m_externalThreadMask.load();
+        uint32_t index = 0;
+        do
+        {
+            index = static_cast<uint32_t>(std::countr_one(mask));
+            assert(index < c_maxExternalThreads && "Too many threads registered with the job system.");
+        } while (!m_externalThreadMask.compare_exchange_weak(mask, mask | (1u << index)));
+
+        t_queueIndex = index;
+    }
+
+    void JobSystem::UnregisterThread()
+    {
+        if (t_queueIndex == c_noQueue || t_queueIndex >= c_maxExternalThreads)
+        {
+            return;
+        }
+
+        assert(m_queues[t_queueIndex]->queue.IsEmpty() && "Thread still has jobs queued.");
+        m_externalThreadMask &= ~(1u << t_queueIndex);
+        t_queueIndex = c_noQueue;
+    }
+
+    JobSystem::ThreadQueue &JobSystem::GetThreadQueue()
+    {
+        assert(t_queueIndex != c_noQueue && "Thread is not registered with the job system.");
+        return *m_queues[t_queueIndex];
+    }
+
+    void JobSystem::Push(ThreadQueue &threadQueue, Job *job)
+    {
+        // Help out until there is room again
+        while (!threadQueue.queue.Push(job))
+        {
+            if (Job *other = GetJob(t_queueIndex))
+            {
+                Execute(other);
+            }
+        }
+
+        m_pendingJobs++;
+        if (m_sleepingWorkers > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_wakeCondition.notify_one();
+        }
+    }
+
+    Job *JobSystem::GetJob(uint32_t queueIndex)
+    {
+        Job *job = m_queues[queueIndex]->queue.Pop();
+
+        // Steal from the others, starting after ourselves so thieves spread out
+        for (size_t i = 1; job == nullptr && i < m_queues.size(); i++)
+        {
+            job = m_queues[(queueIndex + i) % m_queues.size()]->queue.Steal();
+        }
+
+        if (job != nullptr)
+        {
+            m_pendingJobs--;
+        }
+
+        return job;
+    }
+
+    bool JobSystem::ParkIfBlocked(Job *job)
+    {
+        if (job->dependency == nullptr || job->dependency->IsDone())
+        {
+            return false;
+        }
+
+        // Counted before checking again, so either this sees the dependency done or the thread finishing it sees the
+        // count in Execute. Both sides are sequentially consistent for that.
+        std::lock_guard<std::mutex> lock(m_parkedMutex);
+        m_parkedCount++;
+        if (job->dependency->m_value.load() == 0)
+        {
+            m_parkedCount--;
+            return false;
+        }
+
+        m_parkedJobs.push_back(job);
+        return true;
+    }
+
+    void JobSystem::ReleaseParkedJobs()
+    {
+        std::vector<Job *> ready;
+        {
+            std::lock_guard<std::mutex> lock(m_parkedMutex);
+            auto blocked = std::partition(m_parkedJobs.begin(), m_parkedJobs.end(), [](const Job *job)
+                                          { return !job->dependency->IsDone(); });
+            ready.assign(blocked, m_parkedJobs.end());
+            m_parkedJobs.erase(blocked, m_parkedJobs.end());
+            m_parkedCount -= static_cast<uint32_t>(ready.size());
+        }
+
+        for (Job *job : ready)
+        {
+            Push(GetThreadQueue(), job);
+        }
+    }
+
+    Job *JobSystem::GetBackgroundJob()
+    {
+        std::lock_guard<std::mutex> lock(m_backgroundMutex);
+        if (m_backgroundJobs.empty())
+        {
+            return nullptr;
+        }
+
+        Job *job = m_backgroundJobs.front();
+        m_backgroundJobs.pop_front();
+        m_pendingJobs--;
+        return job;
+    }
+
+    void JobSystem::Execute(Job *job)
+    {
+        // Waiting here instead would deadlock once every thread holds a job whose dependency is queued behind it
+        if (ParkIfBlocked(job))
+        {
+            return;
+        }
+
+        {
+            VLT_PROFILE_ZONE("Job");
+            job->function();
+        }
+        job->function = nullptr;
+
+        // The slot may be reused as soon as the job is marked finished, so the counter is read before
+        JobCounter *counter = job->counter;
+        if (job->heapAllocated)
+        {
+            delete job;
+        }
+        else
+        {
+            job->finished.store(true, std::memory_order_release);
+        }
+        if (counter->m_value.fetch_sub(1) == 1 && m_parkedCount > 0)
+        {
+            ReleaseParkedJobs();
+        }
+    }
+
+    void JobSystem::Run(std::function<void()> function, JobCounter &counter, const JobCounter *dependency)
+    {
+        if (m_queues.empty())
+        {
+            if (dependency != nullptr)
+            {
+                Wait(*dependency);
+            }
+            function();
+            return;
+        }
+
+        // Take the next free slot of the ring. Waiting for a particular slot could wait on a job further down this
+        // thread's own stack, so once every slot is taken the job goes on the heap instead.
+        ThreadQueue &threadQueue = GetThreadQueue();
+        Job *job = nullptr;
+        for (uint32_t i = 0; i < c_maxJobsPerThread; i++)
+        {
+            Job *slot = &threadQueue.jobs[(threadQueue.nextJob + i) & (c_maxJobsPerThread - 1)];
+            if (slot->finished.load(std::memory_order_acquire))
+            {
+                job = slot;
+                threadQueue.nextJob += i + 1;
+                job->finished.store(false, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        if (job == nullptr)
+        {
+            job = new Job();
+            job->heapAllocated = true;
+        }
+
+        job->function = std::move(function);
+        job->counter = &counter;
+        job->dependency = dependency;
+
+        counter.m_value.fetch_add(1, std::memory_order_relaxed);
+        Push(threadQueue, job);
+    }
+
+    void JobSystem::RunBackground(std::function<void()> function, JobCounter &counter)
+    {
+        if (m_workers.empty())
+        {
+            function();
+            return;
+        }
+
+        Job *job = new Job();
+        job->heapAllocated = true;
+        job->function = std::move(function);
+        job->counter = &counter;
+
+        counter.m_value.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(m_backgroundMutex);
+            m_backgroundJobs.push_back(job);
+        }
+
+        m_pendingJobs++;
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wakeCondition.notify_one();
+    }
+
+    void JobSystem::Wait(const JobCounter &counter)
+    {
+        while (!counter.IsDone())
+        {
+            if (t_queueIndex == c_noQueue)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            if (Job *job = GetJob(t_queueIndex))
+            {
+                Execute(job);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)> &function)
+    {
+        grainSize = std::max(grainSize, 1u);
+        if (count <= grainSize || m_queues.empty())
+        {
+            if (count > 0)
+            {
+                function(0, count);
+            }
+            return;
+        }
+
+        JobCounter counter;
+        for (uint32_t begin = grainSize; begin < count; begin += grainSize)
+        {
+            const uint32_t end = std::min(begin + grainSize, count);
+            Run([&function, begin, end]()
+                { function(begin, end); },
+                counter);
+        }
+
+        // The first range runs here while the workers pick up the rest
+        function(0, grainSize);
+        Wait(counter);
+    }
+
+    void JobSystem::WorkerLoop(uint32_t queueIndex)
+    {
+        t_queueIndex = queueIndex;
+        VLT_PROFILE_THREAD("Job worker");
+
+        uint32_t idleSpins = 0;
+        while (m_running)
+        {
+            if (Job *job = GetJob(queueIndex))
+            {
+                Execute(job);
+                idleSpins = 0;
+                continue;
+            }
+
+            if (Job *job = GetBackgroundJob())
+            {
+                Execute(job);
+                idleSpins = 0;
+                continue;
+            }
+
+            if (++idleSpins < c_idleSpinCount)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_sleepingWorkers++;
+            m_wakeCondition.wait(lock, [this]()
+                                 { return m_pendingJobs > 0 || !m_running; });
+            m_sleepingWorkers--;
+            idleSpins = 0;
+        }
+    }
+}
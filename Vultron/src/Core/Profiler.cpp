@@ -0,0 +1,221 @@
+#include "Vultron/Core/Profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace Vultron
+{
+#if VLT_PROFILER_ENABLED
+    thread_local constinit ProfilerThreadBuffer *t_profilerBuffer = nullptr;
+
+    // Every buffer ever handed out, buffers are reused but never freed so traces stay valid
+    static std::mutex s_registryMutex;
+    static std::vector<std::unique_ptr<ProfilerThreadBuffer>> s_buffers;
+
+    static std::atomic<uint64_t> s_frameCount = 0;
+    static std::array<std::atomic<uint64_t>, c_profilerFrameHistory> s_frameStarts = {};
+
+    // Pairs ticks with the steady clock, a second pair taken when writing a trace gives the tick rate
+    struct ProfilerTimeBase
+    {
+        uint64_t ticks = GetProfilerTicks();
+        std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+    };
+    static const ProfilerTimeBase s_timeBase;
+
+    // Gives the buffer back when its thread exits
+    struct ProfilerBufferOwner
+    {
+        bool active = false;
+
+        ~ProfilerBufferOwner()
+        {
+            if (active && t_profilerBuffer != nullptr)
+            {
+                std::lock_guard<std::mutex> lock(s_registryMutex);
+                t_profilerBuffer->inUse = false;
+                t_profilerBuffer = nullptr;
+            }
+        }
+    };
+    static thread_local ProfilerBufferOwner t_bufferOwner;
+
+    ProfilerThreadBuffer *AcquireProfilerBuffer()
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+
+        const auto freeBuffer = std::find_if(s_buffers.begin(), s_buffers.end(), [](const std::unique_ptr<ProfilerThreadBuffer> &buffer)
+                                             { return !buffer->inUse; });
+        ProfilerThreadBuffer *buffer = nullptr;
+        if (freeBuffer != s_buffers.end())
+        {
+            buffer = freeBuffer->get();
+            buffer->name.clear();
+        }
+        else
+        {
+            s_buffers.push_back(std::make_unique<ProfilerThreadBuffer>());
+            buffer = s_buffers.back().get();
+            buffer->threadId = static_cast<uint32_t>(s_buffers.size());
+        }
+
+        buffer->inUse = true;
+        t_profilerBuffer = buffer;
+        // Touching the owner registers its destructor for this thread
+        t_bufferOwner.active = true;
+
+        return buffer;
+    }
+
+    void MarkProfilerFrame()
+    {
+        const uint64_t frame = s_frameCount.load(std::memory_order_relaxed);
+        s_frameStarts[frame % c_profilerFrameHistory].store(GetProfilerTicks(), std::memory_order_relaxed);
+        s_frameCount.store(frame + 1, std::memory_order_release);
+    }
+
+    void SetProfilerThreadName(const char *name)
+    {
+        ProfilerThreadBuffer *buffer = t_profilerBuffer != nullptr ? t_profilerBuffer : AcquireProfilerBuffer();
+
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        buffer->name = name;
+    }
+
+    static void WriteJsonString(std::ostream &out, const char *value)
+    {
+        out << '"';
+        for (const char *c = value; *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                out << '\\';
+            }
+            out << *c;
+        }
+        out << '"';
+    }
+
+    bool WriteChromeTrace(const std::string &filepath, uint32_t frameCount)
+    {
+        struct Zone
+        {
+            const char *name;
+            uint64_t start;
+            uint64_t end;
+            uint32_t threadId;
+        };
+
+        const double nanosecondsPerTick = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_timeBase.time).count()) /
+                                          static_cast<double>(std::max<uint64_t>(GetProfilerTicks() - s_timeBase.ticks, 1));
+
+        // Zones that started before the oldest requested frame are left out
+        const uint64_t frames = s_frameCount.load(std::memory_order_acquire);
+        const uint64_t exportedFrames = std::min<uint64_t>({frameCount, c_profilerFrameHistory, frames});
+        const uint64_t firstFrame = frames - exportedFrames;
+        const uint64_t cutoff = exportedFrames > 0 ? s_frameStarts[firstFrame % c_profilerFrameHistory].load(std::memory_order_relaxed) : 0;
+
+        std::vector<Zone> zones;
+        std::vector<std::pair<uint32_t, std::string>> threadNames;
+        {
+            std::lock_guard<std::mutex> lock(s_registryMutex);
+            for (const auto &buffer : s_buffers)
+            {
+                threadNames.push_back({buffer->threadId, buffer->name.empty() ? "Thread " + std::to_string(buffer->threadId) : buffer->name});
+
+                // The owner keeps recording, copy first and then drop whatever it may have overwritten meanwhile
+                const uint64_t count = buffer->count.load(std::memory_order_acquire);
+                const uint64_t first = count > c_profilerEventsPerThread ? count - c_profilerEventsPerThread : 0;
+                const size_t copyStart = zones.size();
+                for (uint64_t i = first; i < count; i++)
+                {
+                    const ProfilerEvent &event = buffer->events[i & (c_profilerEventsPerThread - 1)];
+                    zones.push_back({event.name.load(std::memory_order_relaxed), event.start.load(std::memory_order_relaxed), event.end.load(std::memory_order_relaxed), buffer->threadId});
+                }
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                const uint64_t countAfter = buffer->count.load(std::memory_order_relaxed);
+                const uint64_t firstValid = countAfter >= c_profilerEventsPerThread ? countAfter - c_profilerEventsPerThread + 1 : 0;
+                if (firstValid > first)
+                {
+                    const size_t overwritten = static_cast<size_t>(std::min(firstValid - first, count - first));
+                    zones.erase(zones.begin() + copyStart, zones.begin() + copyStart + overwritten);
+                }
+            }
+        }
+
+        std::ofstream file(filepath);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to open " << filepath << std::endl;
+            return false;
+        }
+
+        const auto toMicroseconds = [&](uint64_t ticks)
+        {
+            return static_cast<double>(ticks - s_timeBase.ticks) * nanosecondsPerTick / 1000.0;
+        };
+
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+        bool firstEvent = true;
+        const auto separator = [&]() -> std::ofstream &
+        {
+            file << (firstEvent ? "" : ",\n");
+            firstEvent = false;
+            return file;
+        };
+
+        for (const auto &[threadId, name] : threadNames)
+        {
+            separator() << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << threadId << ", \"args\": {\"name\": ";
+            WriteJsonString(file, name.c_str());
+            file << "}}";
+        }
+
+        for (uint64_t frame = firstFrame; frame < frames; frame++)
+        {
+            const uint64_t start = s_frameStarts[frame % c_profilerFrameHistory].load(std::memory_order_relaxed);
+            separator() << "{\"ph\": \"i\", \"s\": \"g\", \"name\": \"Frame " << frame << "\", \"pid\": 1, \"tid\": 0, \"ts\": " << toMicroseconds(start) << "}";
+        }
+
+        for (const Zone &zone : zones)
+        {
+            if (zone.name == nullptr || zone.start < cutoff || zone.end < zone.start)
+            {
+                continue;
+            }
+
+            separator() << "{\"ph\": \"X\", \"name\": ";
+            WriteJsonString(file, zone.name);
+            file << ", \"pid\": 1, \"tid\": " << zone.threadId << ", \"ts\": " << toMicroseconds(zone.start)
+                 << ", \"dur\": " << static_cast<double>(zone.end - zone.start) * nanosecondsPerTick / 1000.0 << "}";
+        }
+
+        file << "\n]}" << std::endl;
+
+        std::cout << "Wrote " << exportedFrames << " frames of profiler zones to " << filepath << std::endl;
+
+        return true;
+    }
+#else
+    void MarkProfilerFrame()
+    {
+    }
+
+    void SetProfilerThreadName(const char *name)
+    {
+    }
+
+    bool WriteChromeTrace(const std::string &filepath, uint32_t frameCount)
+    {
+        std::cerr << "The profiler is compiled out, configure with VLT_PROFILER=ON to record zones." << std::endl;
+        return false;
+    }
+#endif
+}
@@ -0,0 +1,585 @@
+#include "Vultron/FrameCapture.h"
+
+#include "Vultron/Core/Profiler.h"
+
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+namespace Vultron
+{
+    // Per job flags, a job is only written when one of them is set
+    constexpr uint8_t c_captureMeshChanged = 1 << 0;
+    constexpr uint8_t c_captureMaterialChanged = 1 << 1;
+    constexpr uint8_t c_captureParametersChanged = 1 << 2;
+    constexpr uint8_t c_captureTransformChanged = 1 << 3;
+
+    // Jobs past the end of the previous frame are compared with this one
+    static RenderJob GetCaptureBaseJob()
+    {
+        return RenderJob{.mesh = VLT_INVALID_HANDLE, .material = VLT_INVALID_HANDLE, .transform = glm::mat4(1.0f), .parameters = {}};
+    }
+
+    static void WriteVarint(std::vector<uint8_t> &buffer, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            buffer.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<uint8_t>(value));
+    }
+
+    template <typename T>
+    static void WriteRaw(std::vector<uint8_t> &buffer, const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "WriteRaw requires a trivially copyable type.");
+        const size_t offset = buffer.size();
+        buffer.resize(offset + sizeof(T));
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    static void WriteString(std::vector<uint8_t> &buffer, const std::string &value)
+    {
+        WriteVarint(buffer, value.size());
+        buffer.insert(buffer.end(), value.begin(), value.end());
+    }
+
+    static void GetTransformBits(const glm::mat4 &transform, uint32_t (&bits)[16])
+    {
+        std::memcpy(bits, &transform[0][0], sizeof(bits));
+    }
+
+    void FrameCaptureWriter::WriteAsset(const CaptureAsset &asset)
+    {
+        m_buffer.clear();
+        WriteRaw(m_buffer, asset.type);
+        WriteVarint(m_buffer, asset.handle);
+
+        if (asset.type == CaptureRecordType::Material)
+        {
+            const TexturedMaterial &material = asset.material;
+            WriteVarint(m_buffer, material.texture);
+            WriteRaw<uint8_t>(m_buffer, material.normalTexture.has_value());
+            WriteVarint(m_buffer, material.normalTexture.value_or(VLT_INVALID_HANDLE));
+            WriteRaw<uint8_t>(m_buffer, material.alphaTest);
+            WriteRaw(m_buffer, material.alphaCutoff);
+
+            const PipelineState &state = material.pipelineState;
+            WriteRaw(m_buffer, state.vertexLayout);
+            WriteRaw<uint32_t>(m_buffer, state.cullMode);
+            WriteRaw<uint32_t>(m_buffer, state.frontFace);
+            WriteRaw<uint8_t>(m_buffer, state.depthTest);
+            WriteRaw<uint8_t>(m_buffer, state.depthWrite);
+            WriteRaw<uint32_t>(m_buffer, state.depthCompareOp);
+            WriteRaw(m_buffer, state.blendMode);
+        }
+        else
+        {
+            const std::string assetsDirectory = std::string(VLT_ASSETS_DIR) + "/";
+            const bool relative = asset.path.starts_with(assetsDirectory);
+            WriteRaw<uint8_t>(m_buffer, relative);
+            WriteString(m_buffer, relative ? asset.path.substr(assetsDirectory.size()) : asset.path);
+        }
+
+        Flush();
+    }
+
+    void FrameCaptureWriter::Flush()
+    {
+        m_file.write(reinterpret_cast<const char *>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+        m_bytesWritten += m_buffer.size();
+    }
+
+    bool FrameCaptureWriter::Begin(const std::string &filepath)
+    {
+        End();
+
+        m_file.open(filepath, std::ios::binary | std::ios::trunc);
+        if (!m_file.is_open())
+        {
+            std::cerr << "Failed to open " << filepath << std::endl;
+            return false;
+        }
+
+        m_frameCount = 0;
+        m_bytesWritten = 0;
+        m_previousJobs.clear();
+
+        m_buffer.clear();
+        WriteRaw(m_buffer, c_frameCaptureMagic);
+        WriteRaw(m_buffer, c_frameCaptureVersion);
+        Flush();
+
+        for (const CaptureAsset &asset : m_assets)
+        {
+            WriteAsset(asset);
+        }
+
+        std::cout << "Capturing frames to " << filepath << std::endl;
+
+        return true;
+    }
+
+    void FrameCaptureWriter::End()
+    {
+        if (!m_file.is_open())
+        {
+            return;
+        }
+
+        m_buffer.clear();
+        WriteRaw(m_buffer, CaptureRecordType::End);
+        Flush();
+        m_file.close();
+
+        std::cout << "Captured " << m_frameCount << " frames in " << m_bytesWritten << " bytes" << std::endl;
+    }
+
+    void FrameCaptureWriter::RecordAsset(const CaptureAsset &asset)
+    {
+        m_assets.push_back(asset);
+        if (IsCapturing())
+        {
+            WriteAsset(asset);
+        }
+    }
+
+    void FrameCaptureWriter::RecordFrame(const FramePacket &packet, const std::vector<RenderJob> &objectJobs)
+    {
+        VLT_PROFILE_ZONE("FrameCaptureWriter::RecordFrame");
+
+        m_buffer.clear();
+        WriteRaw(m_buffer, CaptureRecordType::Frame);
+        WriteRaw(m_buffer, packet.camera.position);
+        WriteRaw(m_buffer, packet.camera.direction);
+        WriteRaw(m_buffer, packet.camera.up);
+        WriteRaw(m_buffer, packet.camera.fov);
+        WriteRaw(m_buffer, packet.camera.nearPlane);
+        WriteRaw(m_buffer, packet.camera.farPlane);
+        WriteRaw(m_buffer, packet.light.direction);
+        WriteRaw(m_buffer, packet.width);
+        WriteRaw(m_buffer, packet.height);
+
+        // A run of unchanged jobs is written as its length before the next changed job, or at the end of the frame
+        const RenderJob baseJob = GetCaptureBaseJob();
+        const size_t jobCount = objectJobs.size() + packet.jobs.size();
+        WriteVarint(m_buffer, jobCount);
+        uint64_t unchangedJobs = 0;
+        for (size_t i = 0; i < jobCount; i++)
+        {
+            const RenderJob &job = i < objectJobs.size() ? objectJobs[i] : packet.jobs[i - objectJobs.size()];
+            const RenderJob &previous = i < m_previousJobs.size() ? m_previousJobs[i] : baseJob;
+
+            uint32_t bits[16];
+            uint32_t previousBits[16];
+            GetTransformBits(job.transform, bits);
+            GetTransformBits(previous.transform, previousBits);
+            uint16_t changedElements = 0;
+            for (uint32_t element = 0; element < 16; element++)
+            {
+                changedElements |= static_cast<uint16_t>(bits[element] != previousBits[element]) << element;
+            }
+
+            uint8_t flags = 0;
+            flags |= job.mesh != previous.mesh ? c_captureMeshChanged : 0;
+            flags |= job.material != previous.material ? c_captureMaterialChanged : 0;
+            flags |= job.parameters.lod != previous.parameters.lod || job.parameters.flags != previous.parameters.flags ? c_captureParametersChanged : 0;
+            flags |= changedElements != 0 ? c_captureTransformChanged : 0;
+
+            if (flags == 0)
+            {
+                unchangedJobs++;
+                continue;
+            }
+
+            WriteVarint(m_buffer, unchangedJobs);
+            unchangedJobs = 0;
+
+            WriteRaw(m_buffer, flags);
+            if (flags & c_captureMeshChanged)
+            {
+                WriteVarint(m_buffer, job.mesh);
+            }
+            if (flags & c_captureMaterialChanged)
+            {
+                WriteVarint(m_buffer, job.material);
+            }
+            if (flags & c_captureParametersChanged)
+            {
+                WriteVarint(m_buffer, job.parameters.lod);
+                WriteVarint(m_buffer, job.parameters.flags);
+            }
+            if (flags & c_captureTransformChanged)
+            {
+                // Usually only the translation moves, so most jobs store three floats
+                WriteRaw(m_buffer, changedElements);
+                for (uint32_t element = 0; element < 16; element++)
+                {
+                    if (changedElements & (1 << element))
+                    {
+                        WriteRaw(m_buffer, bits[element]);
+                    }
+                }
+            }
+        }
+
+        if (unchangedJobs > 0)
+        {
+            WriteVarint(m_buffer, unchangedJobs);
+        }
+
+        Flush();
+
+        m_previousJobs.assign(objectJobs.begin(), objectJobs.end());
+        m_previousJobs.insert(m_previousJobs.end(), packet.jobs.begin(), packet.jobs.end());
+        m_frameCount++;
+    }
+
+    bool FrameCaptureReader::Open(const std::string &filepath)
+    {
+        Close();
+
+        if (!m_file.Open(filepath))
+        {
+            std::cerr << "Failed to open " << filepath << std::endl;
+            return false;
+        }
+
+        const uint32_t magic = ReadRaw<uint32_t>();
+        const uint32_t version = ReadRaw<uint32_t>();
+        if (m_failed || magic != c_frameCaptureMagic || version != c_frameCaptureVersion)
+        {
+            std::cerr << filepath << " is not a version " << c_frameCaptureVersion << " frame capture." << std::endl;
+            Close();
+            return false;
+        }
+
+        m_firstRecord = m_offset;
+
+        return true;
+    }
+
+    void FrameCaptureReader::Close()
+    {
+        m_file.Close();
+        m_offset = 0;
+        m_firstRecord = 0;
+        m_failed = false;
+        m_frame = {};
+    }
+
+    template <typename T>
+    T FrameCaptureReader::ReadRaw()
+    {
+        T value{};
+        if (m_failed || m_offset + sizeof(T) > m_file.GetSize())
+        {
+            m_failed = true;
+            return value;
+        }
+
+        std::memcpy(&value, m_file.GetData() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return value;
+    }
+
+    uint64_t FrameCaptureReader::ReadVarint()
+    {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7)
+        {
+            const uint8_t byte = ReadRaw<uint8_t>();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0 || m_failed)
+            {
+                return value;
+            }
+        }
+
+        m_failed = true;
+        return value;
+    }
+
+    std::string FrameCaptureReader::ReadString()
+    {
+        const uint64_t size = ReadVarint();
+        if (m_failed || size > m_file.GetSize() - m_offset)
+        {
+            m_failed = true;
+            return {};
+        }
+
+        std::string value(reinterpret_cast<const char *>(m_file.GetData() + m_offset), size);
+        m_offset += size;
+        return value;
+    }
+
+    void FrameCaptureReader::ReadAsset(CaptureRecordType type)
+    {
+        m_asset = {};
+        m_asset.type = type;
+        m_asset.handle = ReadVarint();
+
+        if (type == CaptureRecordType::Material)
+        {
+            TexturedMaterial &material = m_asset.material;
+            material.texture = ReadVarint();
+            const bool hasNormalTexture = ReadRaw<uint8_t>() != 0;
+            const RenderHandle normalTexture = ReadVarint();
+            material.normalTexture = hasNormalTexture ? std::optional<RenderHandle>(normalTexture) : std::nullopt;
+            material.alphaTest = ReadRaw<uint8_t>() != 0;
+            material.alphaCutoff = ReadRaw<float>();
+
+            PipelineState &state = material.pipelineState;
+            state.vertexLayout = ReadRaw<VertexLayout>();
+            state.cullMode = static_cast<VkCullModeFlags>(ReadRaw<uint32_t>());
+            state.frontFace = static_cast<VkFrontFace>(ReadRaw<uint32_t>());
+            state.depthTest = ReadRaw<uint8_t>() != 0;
+            state.depthWrite = ReadRaw<uint8_t>() != 0;
+            state.depthCompareOp = static_cast<VkCompareOp>(ReadRaw<uint32_t>());
+            state.blendMode = ReadRaw<BlendMode>();
+        }
+        else
+        {
+            const bool relative = ReadRaw<uint8_t>() != 0;
+            const std::string path = ReadString();
+            m_asset.path = relative ? std::string(VLT_ASSETS_DIR) + "/" + path : path;
+        }
+    }
+
+    void FrameCaptureReader::ReadFrame()
+    {
+        m_frame.camera.position = ReadRaw<glm::vec3>();
+        m_frame.camera.direction = ReadRaw<glm::vec3>();
+        m_frame.camera.up = ReadRaw<glm::vec3>();
+        m_frame.camera.fov = ReadRaw<float>();
+        m_frame.camera.nearPlane = ReadRaw<float>();
+        m_frame.camera.farPlane = ReadRaw<float>();
+        m_frame.light.direction = ReadRaw<glm::vec3>();
+        m_frame.width = ReadRaw<uint32_t>();
+        m_frame.height = ReadRaw<uint32_t>();
+
+        // Unchanged jobs take no space, so the count can only be checked against a limit
+        const uint64_t jobCount = ReadVarint();
+        if (m_failed || jobCount > c_maxCaptureJobs)
+        {
+            m_failed = true;
+            return;
+        }
+
+        // Jobs carried over from the previous frame stay, new ones start from the base job
+        m_frame.jobs.resize(jobCount, GetCaptureBaseJob());
+
+        uint64_t index = 0;
+        while (index < jobCount && !m_failed)
+        {
+            index += ReadVarint();
+            if (index == jobCount)
+            {
+                break;
+            }
+            if (index > jobCount)
+            {
+                m_failed = true;
+                break;
+            }
+
+            RenderJob &job = m_frame.jobs[index++];
+            const uint8_t flags = ReadRaw<uint8_t>();
+            if (flags & c_captureMeshChanged)
+            {
+                job.mesh = ReadVarint();
+            }
+            if (flags & c_captureMaterialChanged)
+            {
+                job.material = ReadVarint();
+            }
+            if (flags & c_captureParametersChanged)
+            {
+                job.parameters.lod = static_cast<uint32_t>(ReadVarint());
+                job.parameters.flags = static_cast<uint32_t>(ReadVarint());
+            }
+            if (flags & c_captureTransformChanged)
+            {
+                uint32_t bits[16];
+                GetTransformBits(job.transform, bits);
+                const uint16_t changedElements = ReadRaw<uint16_t>();
+                for (uint32_t element = 0; element < 16; element++)
+                {
+                    if (changedElements & (1 << element))
+                    {
+                        bits[element] = ReadRaw<uint32_t>();
+                    }
+                }
+                std::memcpy(&job.transform[0][0], bits, sizeof(bits));
+            }
+        }
+    }
+
+    bool FrameCaptureReader::Next(CaptureRecordType &type)
+    {
+        if (m_failed || m_offset >= m_file.GetSize())
+        {
+            return false;
+        }
+
+        type = ReadRaw<CaptureRecordType>();
+        switch (type)
+        {
+        case CaptureRecordType::Mesh:
+        case CaptureRecordType::Image:
+        case CaptureRecordType::Material:
+            ReadAsset(type);
+            break;
+        case CaptureRecordType::Frame:
+            ReadFrame();
+            break;
+        case CaptureRecordType::End:
+            return false;
+        default:
+            m_failed = true;
+            break;
+        }
+
+        if (m_failed)
+        {
+            std::cerr << "Frame capture is damaged or truncated, stopped reading at byte " << m_offset << "." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    void FrameCaptureReader::Rewind()
+    {
+        m_offset = m_firstRecord;
+        m_failed = false;
+        m_frame.jobs.clear();
+    }
+
+    bool FrameReplayer::Open(const std::string &filepath)
+    {
+        m_meshes.clear();
+        m_images.clear();
+        m_materials.clear();
+        m_frameIndex = 0;
+        m_framePending = false;
+
+        return m_reader.Open(filepath);
+    }
+
+    void FrameReplayer::Close()
+    {
+        m_reader.Close();
+    }
+
+    RenderHandle FrameReplayer::MapHandle(const std::unordered_map<RenderHandle, RenderHandle> &handles, RenderHandle handle)
+    {
+        const auto it = handles.find(handle);
+        return it != handles.end() ? it->second : VLT_INVALID_HANDLE;
+    }
+
+    void FrameReplayer::CreateAsset(SceneRenderer &renderer, const CaptureAsset &asset)
+    {
+        // Assets are created once, a looping replay reads their records again
+        switch (asset.type)
+        {
+        case CaptureRecordType::Mesh:
+            if (!m_meshes.contains(asset.handle))
+            {
+                m_meshes[asset.handle] = renderer.LoadMesh(asset.path);
+            }
+            break;
+        case CaptureRecordType::Image:
+            if (!m_images.contains(asset.handle))
+            {
+                m_images[asset.handle] = renderer.LoadImage(asset.path);
+            }
+            break;
+        case CaptureRecordType::Material:
+            if (!m_materials.contains(asset.handle))
+            {
+                TexturedMaterial material = asset.material;
+                material.texture = MapHandle(m_images, material.texture);
+                if (material.normalTexture.has_value())
+                {
+                    material.normalTexture = MapHandle(m_images, material.normalTexture.value());
+                }
+                m_materials[asset.handle] = renderer.CreateMaterial(material);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool FrameReplayer::LoadAssets(SceneRenderer &renderer)
+    {
+        CaptureRecordType type;
+        while (!m_framePending && m_reader.Next(type))
+        {
+            if (type == CaptureRecordType::Frame)
+            {
+                m_framePending = true;
+            }
+            else
+            {
+                CreateAsset(renderer, m_reader.GetAsset());
+            }
+        }
+
+        return m_framePending;
+    }
+
+    bool FrameReplayer::ReplayFrame(SceneRenderer &renderer, bool loop)
+    {
+        bool rewound = false;
+        CaptureRecordType type;
+        while (!m_framePending)
+        {
+            if (!m_reader.Next(type))
+            {
+                // A capture without frames would loop forever
+                if (!loop || rewound)
+                {
+                    return false;
+                }
+                m_reader.Rewind();
+                rewound = true;
+                continue;
+            }
+
+            if (type == CaptureRecordType::Frame)
+            {
+                m_framePending = true;
+            }
+            else
+            {
+                CreateAsset(renderer, m_reader.GetAsset());
+            }
+        }
+        m_framePending = false;
+
+        VLT_PROFILE_ZONE("FrameReplayer::ReplayFrame");
+
+        const CaptureFrame &frame = m_reader.GetFrame();
+        renderer.BeginFrame();
+        renderer.SetCamera(frame.camera);
+        renderer.SetLight(frame.light);
+        for (const RenderJob &job : frame.jobs)
+        {
+            renderer.SubmitRenderJob({
+                .mesh = MapHandle(m_meshes, job.mesh),
+                .material = MapHandle(m_materials, job.material),
+                .transform = job.transform,
+                .parameters = job.parameters,
+            });
+        }
+        renderer.EndFrame();
+
+        m_frameIndex++;
+
+        return true;
+    }
+}
@@ -0,0 +1,63 @@
+#include "Vultron/Null/NullRenderer.h"
+
+#include <iostream>
+
+namespace Vultron
+{
+    bool NullRenderer::Initialize(const Window &window, JobSystem &jobSystem)
+    {
+        m_headless = false;
+        m_stats = {};
+
+        std::cout << "Using null render backend, nothing will be drawn." << std::endl;
+
+        return true;
+    }
+
+    bool NullRenderer::InitializeHeadless(uint32_t width, uint32_t height, JobSystem &jobSystem)
+    {
+        m_headless = true;
+        m_stats = {};
+
+        std::cout << "Using null render backend, nothing will be drawn." << std::endl;
+
+        return true;
+    }
+
+    void NullRenderer::Shutdown()
+    {
+        std::cout << "Null render backend received " << m_stats.frames << " frames, " << m_stats.batches << " batches, "
+                  << m_stats.instances << " instances, " << m_stats.invalidBatches << " invalid batches." << std::endl;
+    }
+
+    bool NullRenderer::IsValid(const RenderBatch &batch, size_t instanceCount) const
+    {
+        const bool validMesh = batch.mesh != VLT_INVALID_HANDLE && batch.mesh < m_nextMesh;
+        const bool validMaterial = batch.material != VLT_INVALID_HANDLE && batch.material < m_nextMaterial;
+        const bool validRange = static_cast<size_t>(batch.firstInstance) + batch.instanceCount <= instanceCount;
+
+        return validMesh && validMaterial && validRange;
+    }
+
+    void NullRenderer::Draw(const Camera &camera, const DirectionalLight &light, const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances,
+                            const std::vector<InstanceRange> &dirtyInstances, std::chrono::high_resolution_clock::time_point inputTime)
+    {
+        m_stats.frames++;
+        m_stats.batches += batches.size();
+
+        m_frameStats = {};
+        m_frameStats.frameNumber = m_stats.frames;
+        for (const auto &batch : batches)
+        {
+            if (!IsValid(batch, instances.size()))
+            {
+                m_stats.invalidBatches++;
+                continue;
+            }
+
+            m_stats.instances += batch.instanceCount;
+            m_frameStats.drawCalls++;
+            m_frameStats.instances += batch.instanceCount;
+        }
+    }
+}
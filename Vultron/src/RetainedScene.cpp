@@ -0,0 +1,287 @@
+#include "Vultron/RetainedScene.h"
+
+#include "Vultron/Core/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+
+namespace Vultron
+{
+    void RetainedScene::Apply(const std::vector<RenderObjectCommand> &commands)
+    {
+        VLT_PROFILE_ZONE("RetainedScene::Apply");
+
+        for (const RenderObjectCommand &command : commands)
+        {
+            switch (command.type)
+            {
+            case RenderObjectCommandType::Create:
+            {
+                if (command.object >= m_objects.size())
+                {
+                    m_objects.resize(command.object + 1);
+                }
+
+                assert(m_objects[command.object].batch == nullptr && "Render object already exists.");
+                Insert(command.object, command.job);
+                m_objectCount++;
+                break;
+            }
+            case RenderObjectCommandType::SetTransform:
+            {
+                const Object &object = m_objects[command.object];
+                assert(object.batch != nullptr && "Render object does not exist.");
+                object.batch->transforms[object.instance] = command.job.transform;
+                WriteInstance(object.batch->firstInstance + object.instance, command.job.transform);
+                break;
+            }
+            case RenderObjectCommandType::SetMaterial:
+            {
+                const Object &object = m_objects[command.object];
+                assert(object.batch != nullptr && "Render object does not exist.");
+                const Batch &batch = *object.batch;
+                if (batch.material == command.job.material)
+                {
+                    break;
+                }
+
+                const RenderJob job = {batch.mesh, command.job.material, batch.transforms[object.instance], batch.parameters};
+                Remove(command.object);
+                Insert(command.object, job);
+                break;
+            }
+            case RenderObjectCommandType::Destroy:
+            {
+                assert(m_objects[command.object].batch != nullptr && "Render object does not exist.");
+                Remove(command.object);
+                m_objectCount--;
+                break;
+            }
+            }
+        }
+    }
+
+    void RetainedScene::Insert(uint32_t object, const RenderJob &job)
+    {
+        const auto [entry, inserted] = m_batches.try_emplace(job.GetHash());
+        Batch &batch = entry->second;
+        if (inserted)
+        {
+            batch.mesh = job.mesh;
+            batch.material = job.material;
+            batch.parameters = job.parameters;
+            Relocate(batch, c_minRetainedBatchCapacity);
+        }
+
+        const uint32_t instance = static_cast<uint32_t>(batch.objects.size());
+        if (instance == batch.capacity)
+        {
+            // The last range in the buffer can grow in place, others move to the end
+            if (batch.firstInstance + batch.capacity == m_instanceCount)
+            {
+                batch.capacity *= 2;
+                m_instanceCount = batch.firstInstance + batch.capacity;
+                if (m_instances.size() < m_instanceCount)
+                {
+                    m_instances.resize(m_instanceCount);
+                }
+            }
+            else
+            {
+                Relocate(batch, batch.capacity * 2);
+            }
+        }
+
+        batch.objects.push_back(object);
+        batch.transforms.push_back(job.transform);
+        m_objects[object] = {&batch, instance};
+        WriteInstance(batch.firstInstance + instance, job.transform);
+        m_batchesDirty = true;
+    }
+
+    void RetainedScene::Remove(uint32_t object)
+    {
+        Object &removed = m_objects[object];
+        Batch &batch = *removed.batch;
+
+        // The last instance of the batch takes the place of the removed one
+        const uint32_t last = static_cast<uint32_t>(batch.objects.size()) - 1;
+        if (removed.instance != last)
+        {
+            batch.objects[removed.instance] = batch.objects[last];
+            batch.transforms[removed.instance] = batch.transforms[last];
+            m_objects[batch.objects[last]].instance = removed.instance;
+            WriteInstance(batch.firstInstance + removed.instance, batch.transforms[last]);
+        }
+
+        batch.objects.pop_back();
+        batch.transforms.pop_back();
+        removed = {};
+
+        // Empty batches keep their range until the next compaction, objects often come back to the same batch
+        m_batchesDirty = true;
+    }
+
+    void RetainedScene::WriteInstance(uint32_t instance, const glm::mat4 &transform)
+    {
+        m_instances[instance] = transform;
+        MarkDirty(instance, 1);
+    }
+
+    void RetainedScene::MarkDirty(uint32_t firstInstance, uint32_t instanceCount)
+    {
+        if (instanceCount == 0)
+        {
+            return;
+        }
+
+        const uint32_t firstPage = firstInstance / c_instancePageSize;
+        const uint32_t lastPage = (firstInstance + instanceCount - 1) / c_instancePageSize;
+        if (m_dirtyPages.size() <= lastPage / 64)
+        {
+            m_dirtyPages.resize(lastPage / 64 + 1, 0);
+        }
+
+        for (uint32_t page = firstPage; page <= lastPage; page++)
+        {
+            m_dirtyPages[page / 64] |= 1ull << (page % 64);
+        }
+    }
+
+    void RetainedScene::Relocate(Batch &batch, uint32_t capacity)
+    {
+        batch.firstInstance = m_instanceCount;
+        batch.capacity = capacity;
+        m_instanceCount += capacity;
+        if (m_instances.size() < m_instanceCount)
+        {
+            m_instances.resize(m_instanceCount);
+        }
+
+        std::copy(batch.transforms.begin(), batch.transforms.end(), m_instances.begin() + batch.firstInstance);
+        MarkDirty(batch.firstInstance, static_cast<uint32_t>(batch.transforms.size()));
+        m_batchesDirty = true;
+    }
+
+    void RetainedScene::Compact(JobSystem &jobSystem)
+    {
+        VLT_PROFILE_ZONE("RetainedScene::Compact");
+
+        // A quarter of room to grow, so the batches that are still filling up do not move right away
+        std::vector<Batch *> batches;
+        batches.reserve(m_batches.size());
+        uint32_t instanceCount = 0;
+        for (auto entry = m_batches.begin(); entry != m_batches.end();)
+        {
+            Batch &batch = entry->second;
+            if (batch.objects.empty())
+            {
+                entry = m_batches.erase(entry);
+                continue;
+            }
+
+            const uint32_t count = static_cast<uint32_t>(batch.objects.size());
+            batch.firstInstance = instanceCount;
+            batch.capacity = count + count / 4;
+            instanceCount += batch.capacity;
+            batches.push_back(&batch);
+            ++entry;
+        }
+
+        m_instanceCount = instanceCount;
+        m_instances.resize(instanceCount);
+        jobSystem.ParallelFor(static_cast<uint32_t>(batches.size()), c_instancePackGrainSize, [&](uint32_t begin, uint32_t end)
+                              {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                std::copy(batches[i]->transforms.begin(), batches[i]->transforms.end(), m_instances.begin() + batches[i]->firstInstance);
+            } });
+
+        MarkDirty(0, instanceCount);
+        m_batchesDirty = true;
+    }
+
+    void RetainedScene::Update(JobSystem &jobSystem)
+    {
+        VLT_PROFILE_ZONE("RetainedScene::Update");
+
+        if (m_instanceCount > c_minRetainedCompactionSize && static_cast<uint64_t>(m_objectCount) * 2 < m_instanceCount)
+        {
+            Compact(jobSystem);
+        }
+
+        // Drops the jobs of the previous frame
+        m_instances.resize(m_instanceCount);
+
+        // Sized up front so WriteObjectTransform never has to grow it
+        const size_t pageWordCount = (m_instanceCount / c_instancePageSize + 64) / 64;
+        if (m_dirtyPages.size() < pageWordCount)
+        {
+            m_dirtyPages.resize(pageWordCount, 0);
+        }
+
+        if (!m_batchesDirty)
+        {
+            return;
+        }
+
+        m_renderBatches.clear();
+        for (const auto &[hash, batch] : m_batches)
+        {
+            if (batch.objects.empty())
+            {
+                continue;
+            }
+
+            m_renderBatches.push_back({batch.mesh, batch.material, batch.firstInstance, static_cast<uint32_t>(batch.objects.size()), batch.parameters});
+        }
+        m_batchesDirty = false;
+    }
+
+    void RetainedScene::WriteObjectTransform(uint32_t object, const glm::mat4 &transform)
+    {
+        const Object &entry = m_objects[object];
+        assert(entry.batch != nullptr && "Render object does not exist.");
+        entry.batch->transforms[entry.instance] = transform;
+
+        const uint32_t instance = entry.batch->firstInstance + entry.instance;
+        m_instances[instance] = transform;
+
+        // Other threads may mark pages of the same word at the same time
+        const uint32_t page = instance / c_instancePageSize;
+        std::atomic_ref<uint64_t>(m_dirtyPages[page / 64]).fetch_or(1ull << (page % 64), std::memory_order_relaxed);
+    }
+
+    void RetainedScene::GetDirtyRanges(std::vector<InstanceRange> &ranges)
+    {
+        for (size_t word = 0; word < m_dirtyPages.size(); word++)
+        {
+            uint64_t bits = m_dirtyPages[word];
+            m_dirtyPages[word] = 0;
+            while (bits != 0)
+            {
+                const uint32_t page = static_cast<uint32_t>(word * 64 + std::countr_zero(bits));
+                bits &= bits - 1;
+
+                // Pages past the end were freed by a compaction
+                const uint32_t firstInstance = page * c_instancePageSize;
+                if (firstInstance >= m_instanceCount)
+                {
+                    break;
+                }
+
+                const uint32_t instanceCount = std::min(c_instancePageSize, m_instanceCount - firstInstance);
+                if (!ranges.empty() && ranges.back().firstInstance + ranges.back().instanceCount == firstInstance)
+                {
+                    ranges.back().instanceCount += instanceCount;
+                }
+                else
+                {
+                    ranges.push_back({firstInstance, instanceCount});
+                }
+            }
+        }
+    }
+}
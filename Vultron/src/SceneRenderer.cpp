@@ -1 +1,588 @@
-#include "Vultron/SceneRenderer.h"
\ No newline at end of file
+#include "Vultron/SceneRenderer.h"
+
+#include "Vultron/Core/Profiler.h"
+#include "Vultron/FrameCapture.h"
+#include "Vultron/Null/NullRenderer.h"
+#include "Vultron/RetainedScene.h"
+#include "Vultron/Software/SoftwareRenderer.h"
+#include "Vultron/TransformHierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace Vultron
+{
+    static Ptr<RenderBackend> CreateBackend(RenderBackendType type)
+    {
+        switch (type)
+        {
+        case RenderBackendType::Null:
+            return MakePtr<NullRenderer>();
+        case RenderBackendType::Software:
+            return MakePtr<SoftwareRenderer>();
+        case RenderBackendType::Vulkan:
+        default:
+            return MakePtr<VulkanRenderer>();
+        }
+    }
+
+    SceneRenderer::SceneRenderer()
+        : retainedScene(MakePtr<RetainedScene>()), transformHierarchy(MakePtr<TransformHierarchy>()), captureWriter(MakePtr<FrameCaptureWriter>())
+    {
+    }
+
+    SceneRenderer::~SceneRenderer() = default;
+
+    bool SceneRenderer::Initialize(const Window &window, RenderBackendType backendType)
+    {
+        VLT_PROFILE_THREAD("Game thread");
+        backend = CreateBackend(backendType);
+
+        if (!jobSystem.Initialize())
+        {
+            return false;
+        }
+
+        this->window = &window;
+        currentPacket = &framePackets[0];
+
+        return backend->Initialize(window, jobSystem);
+    }
+
+    bool SceneRenderer::InitializeHeadless(uint32_t width, uint32_t height, RenderBackendType backendType)
+    {
+        VLT_PROFILE_THREAD("Game thread");
+        backend = CreateBackend(backendType);
+
+        if (!jobSystem.Initialize())
+        {
+            return false;
+        }
+
+        window = nullptr;
+        currentPacket = &framePackets[0];
+
+        return backend->InitializeHeadless(width, height, jobSystem);
+    }
+
+    void SceneRenderer::Shutdown()
+    {
+        EndCapture();
+        SetRenderThreadEnabled(false);
+
+        backend->Shutdown();
+        jobSystem.Shutdown();
+    }
+
+    void SceneRenderer::BeginFrame()
+    {
+        VLT_PROFILE_FRAME();
+        VLT_PROFILE_ZONE("SceneRenderer::BeginFrame");
+
+        if (renderThreadEnabled)
+        {
+            VLT_PROFILE_ZONE("Wait for free packet");
+            const auto waitStartTime = std::chrono::high_resolution_clock::now();
+            freePackets.Pop(currentPacket);
+            gameThreadWaitTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - waitStartTime).count();
+        }
+        else
+        {
+            backend->PaceFrame();
+        }
+
+        currentPacket->jobs.clear();
+        currentPacket->inputTime = std::chrono::high_resolution_clock::now();
+    }
+
+    void SceneRenderer::EndFrame()
+    {
+        VLT_PROFILE_ZONE("SceneRenderer::EndFrame");
+
+        currentPacket->camera = camera;
+        currentPacket->light = light;
+
+        // Window events are polled on the game thread, so the size travels with the packet
+        if (window != nullptr)
+        {
+            const auto [width, height] = window->GetExtent();
+            currentPacket->width = width;
+            currentPacket->height = height;
+        }
+
+        // The packet was drawn before it came back, so its old commands can be reused as the next pending ones
+        std::swap(currentPacket->objectCommands, pendingObjectCommands);
+        pendingObjectCommands.clear();
+        std::swap(currentPacket->transformCommands, pendingTransformCommands);
+        pendingTransformCommands.clear();
+
+        if (captureWriter->IsCapturing())
+        {
+            // Captured as jobs, so replays need no render objects
+            captureObjectJobs.clear();
+            for (const RenderObject &object : renderObjects)
+            {
+                if (object.alive)
+                {
+                    captureObjectJobs.push_back(object.job);
+                    if (object.node != VLT_INVALID_HANDLE)
+                    {
+                        captureObjectJobs.back().transform = ComputeTransformNodeWorld(object.node);
+                    }
+                }
+            }
+            captureWriter->RecordFrame(*currentPacket, captureObjectJobs);
+        }
+
+        if (!renderThreadEnabled)
+        {
+            RenderPacket(*currentPacket);
+            return;
+        }
+
+        packetsInFlight++;
+        submittedPackets.Push(currentPacket);
+        currentPacket = nullptr;
+    }
+
+    RenderObject *SceneRenderer::FindRenderObject(RenderHandle object)
+    {
+        const bool valid = object != VLT_INVALID_HANDLE && object <= renderObjects.size() && renderObjects[object - 1].alive;
+        assert(valid && "Invalid render object.");
+        return valid ? &renderObjects[object - 1] : nullptr;
+    }
+
+    RenderHandle SceneRenderer::CreateRenderObject(RenderHandle mesh, RenderHandle material, const glm::mat4 &transform, DrawParameters parameters)
+    {
+        uint32_t object = static_cast<uint32_t>(renderObjects.size());
+        if (!freeRenderObjects.empty())
+        {
+            object = freeRenderObjects.back();
+            freeRenderObjects.pop_back();
+        }
+        else
+        {
+            renderObjects.emplace_back();
+        }
+
+        RenderObject &renderObject = renderObjects[object];
+        renderObject.job = {mesh, material, transform, parameters};
+        renderObject.alive = true;
+        renderObjectCount++;
+
+        pendingObjectCommands.push_back({.type = RenderObjectCommandType::Create, .object = object, .job = renderObject.job});
+
+        return object + 1;
+    }
+
+    void SceneRenderer::SetRenderObjectTransform(RenderHandle object, const glm::mat4 &transform)
+    {
+        RenderObject *renderObject = FindRenderObject(object);
+        if (renderObject == nullptr)
+        {
+            return;
+        }
+
+        if (renderObject->node != VLT_INVALID_HANDLE)
+        {
+            AttachRenderObject(object, VLT_INVALID_HANDLE);
+        }
+
+        renderObject->job.transform = transform;
+        pendingObjectCommands.push_back({.type = RenderObjectCommandType::SetTransform, .object = static_cast<uint32_t>(object - 1), .job = renderObject->job});
+    }
+
+    void SceneRenderer::SetRenderObjectMaterial(RenderHandle object, RenderHandle material)
+    {
+        RenderObject *renderObject = FindRenderObject(object);
+        if (renderObject == nullptr || renderObject->job.material == material)
+        {
+            return;
+        }
+
+        renderObject->job.material = material;
+        pendingObjectCommands.push_back({.type = RenderObjectCommandType::SetMaterial, .object = static_cast<uint32_t>(object - 1), .job = renderObject->job});
+    }
+
+    void SceneRenderer::DestroyRenderObject(RenderHandle object)
+    {
+        RenderObject *renderObject = FindRenderObject(object);
+        if (renderObject == nullptr)
+        {
+            return;
+        }
+
+        if (renderObject->node != VLT_INVALID_HANDLE)
+        {
+            AttachRenderObject(object, VLT_INVALID_HANDLE);
+        }
+
+        renderObject->alive = false;
+        renderObjectCount--;
+        freeRenderObjects.push_back(static_cast<uint32_t>(object - 1));
+
+        pendingObjectCommands.push_back({.type = RenderObjectCommandType::Destroy, .object = static_cast<uint32_t>(object - 1)});
+    }
+
+    TransformNode *SceneRenderer::FindTransformNode(RenderHandle node)
+    {
+        const bool valid = node != VLT_INVALID_HANDLE && node <= transformNodes.size() && transformNodes[node - 1].alive;
+        assert(valid && "Invalid transform node.");
+        return valid ? &transformNodes[node - 1] : nullptr;
+    }
+
+    glm::mat4 SceneRenderer::ComputeTransformNodeWorld(RenderHandle node) const
+    {
+        glm::mat4 world = glm::mat4(1.0f);
+        for (; node != VLT_INVALID_HANDLE; node = transformNodes[node - 1].parent)
+        {
+            world = ComposeTransform(transformNodes[node - 1].local) * world;
+        }
+        return world;
+    }
+
+    RenderHandle SceneRenderer::CreateTransformNode(const Transform &local, RenderHandle parent)
+    {
+        uint32_t parentIndex = c_noTransformTarget;
+        if (parent != VLT_INVALID_HANDLE)
+        {
+            TransformNode *parentNode = FindTransformNode(parent);
+            if (parentNode == nullptr)
+            {
+                return VLT_INVALID_HANDLE;
+            }
+
+            parentNode->childCount++;
+            parentIndex = parent - 1;
+        }
+
+        uint32_t node = static_cast<uint32_t>(transformNodes.size());
+        if (!freeTransformNodes.empty())
+        {
+            node = freeTransformNodes.back();
+            freeTransformNodes.pop_back();
+        }
+        else
+        {
+            transformNodes.emplace_back();
+        }
+
+        transformNodes[node] = {.local = local, .parent = parent, .alive = true};
+        transformNodeCount++;
+
+        pendingTransformCommands.push_back({.type = TransformCommandType::Create, .node = node, .target = parentIndex, .local = local});
+
+        return node + 1;
+    }
+
+    void SceneRenderer::SetTransformNodeLocal(RenderHandle node, const Transform &local)
+    {
+        TransformNode *transformNode = FindTransformNode(node);
+        if (transformNode == nullptr)
+        {
+            return;
+        }
+
+        transformNode->local = local;
+        pendingTransformCommands.push_back({.type = TransformCommandType::SetLocal, .node = static_cast<uint32_t>(node - 1), .local = local});
+    }
+
+    void SceneRenderer::DestroyTransformNode(RenderHandle node)
+    {
+        TransformNode *transformNode = FindTransformNode(node);
+        if (transformNode == nullptr)
+        {
+            return;
+        }
+
+        assert(transformNode->childCount == 0 && "Transform node still has children.");
+        if (transformNode->object != VLT_INVALID_HANDLE)
+        {
+            // The render side drops the attachment with the node, before it propagates
+            RenderObject &renderObject = renderObjects[transformNode->object - 1];
+            renderObject.job.transform = ComputeTransformNodeWorld(node);
+            renderObject.node = VLT_INVALID_HANDLE;
+            pendingObjectCommands.push_back({.type = RenderObjectCommandType::SetTransform, .object = static_cast<uint32_t>(transformNode->object - 1), .job = renderObject.job});
+        }
+
+        if (transformNode->parent != VLT_INVALID_HANDLE)
+        {
+            transformNodes[transformNode->parent - 1].childCount--;
+        }
+
+        *transformNode = {};
+        transformNodeCount--;
+        freeTransformNodes.push_back(static_cast<uint32_t>(node - 1));
+
+        pendingTransformCommands.push_back({.type = TransformCommandType::Destroy, .node = static_cast<uint32_t>(node - 1)});
+    }
+
+    void SceneRenderer::AttachRenderObject(RenderHandle object, RenderHandle node)
+    {
+        RenderObject *renderObject = FindRenderObject(object);
+        if (renderObject == nullptr || renderObject->node == node)
+        {
+            return;
+        }
+
+        if (renderObject->node != VLT_INVALID_HANDLE)
+        {
+            // Detached objects keep the transform they were last drawn with. Sent along since the node may have moved
+            // in this packet, and the render side drops the attachment before it propagates.
+            TransformNode &oldNode = transformNodes[renderObject->node - 1];
+            renderObject->job.transform = ComputeTransformNodeWorld(renderObject->node);
+            oldNode.object = VLT_INVALID_HANDLE;
+            pendingObjectCommands.push_back({.type = RenderObjectCommandType::SetTransform, .object = static_cast<uint32_t>(object - 1), .job = renderObject->job});
+            pendingTransformCommands.push_back({.type = TransformCommandType::Attach, .node = static_cast<uint32_t>(renderObject->node - 1)});
+            renderObject->node = VLT_INVALID_HANDLE;
+        }
+
+        if (node == VLT_INVALID_HANDLE)
+        {
+            return;
+        }
+
+        TransformNode *transformNode = FindTransformNode(node);
+        if (transformNode == nullptr)
+        {
+            return;
+        }
+
+        assert(transformNode->object == VLT_INVALID_HANDLE && "Transform node already drives a render object.");
+        if (transformNode->object != VLT_INVALID_HANDLE)
+        {
+            RenderObject &previousObject = renderObjects[transformNode->object - 1];
+            previousObject.job.transform = ComputeTransformNodeWorld(node);
+            previousObject.node = VLT_INVALID_HANDLE;
+        }
+
+        transformNode->object = object;
+        renderObject->node = node;
+        pendingTransformCommands.push_back({.type = TransformCommandType::Attach, .node = static_cast<uint32_t>(node - 1), .target = static_cast<uint32_t>(object - 1)});
+    }
+
+    bool SceneRenderer::BeginCapture(const std::string &filepath)
+    {
+        return captureWriter->Begin(filepath);
+    }
+
+    void SceneRenderer::EndCapture()
+    {
+        captureWriter->End();
+    }
+
+    bool SceneRenderer::IsCapturing() const
+    {
+        return captureWriter->IsCapturing();
+    }
+
+    void SceneRenderer::CaptureMesh(RenderHandle handle, const std::string &path)
+    {
+        captureWriter->RecordAsset({.type = CaptureRecordType::Mesh, .handle = handle, .path = path});
+    }
+
+    void SceneRenderer::CaptureImage(RenderHandle handle, const std::string &path)
+    {
+        captureWriter->RecordAsset({.type = CaptureRecordType::Image, .handle = handle, .path = path});
+    }
+
+    void SceneRenderer::CaptureMaterial(RenderHandle handle, const TexturedMaterial &material)
+    {
+        captureWriter->RecordAsset({.type = CaptureRecordType::Material, .handle = handle, .material = material});
+    }
+
+    void BuildRenderBatches(const std::vector<RenderJob> &jobs, std::map<uint64_t, InstancedRenderJob> &renderJobs, std::vector<RenderBatch> &batches,
+                            std::vector<const InstancedRenderJob *> &batchJobs, uint32_t firstInstance)
+    {
+        VLT_PROFILE_ZONE("BuildRenderBatches");
+
+        renderJobs.clear();
+        for (const auto &job : jobs)
+        {
+            uint64_t hash = job.GetHash();
+            if (renderJobs.find(hash) == renderJobs.end())
+            {
+                renderJobs.insert({hash, InstancedRenderJob{job.mesh, job.material, job.parameters, {}}});
+            }
+
+            renderJobs[hash].transforms.push_back(job.transform);
+        }
+
+        batches.clear();
+        batchJobs.clear();
+        batches.reserve(renderJobs.size());
+        batchJobs.reserve(renderJobs.size());
+
+        uint32_t instanceCount = firstInstance;
+        for (auto &job : renderJobs)
+        {
+            const uint32_t count = static_cast<uint32_t>(job.second.transforms.size());
+            batches.push_back({job.second.mesh, job.second.material, instanceCount, count, job.second.parameters});
+            batchJobs.push_back(&job.second);
+            instanceCount += count;
+        }
+    }
+
+    void PackInstances(JobSystem &jobSystem, const std::vector<RenderBatch> &batches, const std::vector<const InstancedRenderJob *> &batchJobs,
+                       std::vector<glm::mat4> &instanceBuffer)
+    {
+        VLT_PROFILE_ZONE("PackInstances");
+
+        if (batches.empty())
+        {
+            return;
+        }
+
+        const uint32_t instanceCount = batches.back().firstInstance + batches.back().instanceCount;
+
+        // Offsets are known up front, so batches can be packed independently
+        instanceBuffer.resize(instanceCount);
+        jobSystem.ParallelFor(static_cast<uint32_t>(batches.size()), c_instancePackGrainSize, [&](uint32_t begin, uint32_t end)
+                              {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                std::copy(batchJobs[i]->transforms.begin(), batchJobs[i]->transforms.end(), instanceBuffer.begin() + batches[i].firstInstance);
+            } });
+    }
+
+    void SceneRenderer::RenderPacket(const FramePacket &packet)
+    {
+        VLT_PROFILE_ZONE("SceneRenderer::RenderPacket");
+
+        // Render objects keep their batches and instances between frames, only the jobs of this frame are batched from scratch
+        retainedScene->Apply(packet.objectCommands);
+        transformHierarchy->Apply(packet.transformCommands);
+        retainedScene->Update(jobSystem);
+
+        // Objects that follow a transform node get its new world matrix in place
+        transformHierarchy->Update(jobSystem);
+        transformHierarchy->WriteInstances(*retainedScene, jobSystem);
+
+        std::vector<glm::mat4> &instanceBuffer = retainedScene->GetInstances();
+        const uint32_t retainedInstances = retainedScene->GetInstanceCount();
+        BuildRenderBatches(packet.jobs, renderJobs, jobBatches, batchJobs, retainedInstances);
+        PackInstances(jobSystem, jobBatches, batchJobs, instanceBuffer);
+
+        const std::vector<RenderBatch> *batches = &retainedScene->GetBatches();
+        if (!jobBatches.empty())
+        {
+            frameBatches = *batches;
+            frameBatches.insert(frameBatches.end(), jobBatches.begin(), jobBatches.end());
+            batches = &frameBatches;
+        }
+
+        // The jobs change every frame
+        dirtyInstances.clear();
+        retainedScene->GetDirtyRanges(dirtyInstances);
+        if (instanceBuffer.size() > retainedInstances)
+        {
+            dirtyInstances.push_back({retainedInstances, static_cast<uint32_t>(instanceBuffer.size()) - retainedInstances});
+        }
+
+        backend->Resize(packet.width, packet.height);
+        backend->Draw(packet.camera, packet.light, *batches, instanceBuffer, dirtyInstances, packet.inputTime);
+
+        RenderStats stats = backend->GetRenderStats();
+        stats.submittedJobs = packet.jobs.size();
+        stats.batches = batches->size();
+        stats.renderObjects = retainedScene->GetObjectCount();
+        stats.objectCommands = packet.objectCommands.size();
+        stats.transformNodes = transformHierarchy->GetNodeCount();
+        stats.transformsUpdated = transformHierarchy->GetUpdatedCount();
+
+        const RenderTimings timings = {
+            .recordingTime = backend->GetRecordingTime(),
+            .frameWaitTime = backend->GetFrameWaitTime(),
+            .gpuTime = backend->GetGpuTime(),
+            .latency = backend->GetLatency(),
+            .readbackStallTime = backend->GetReadbackStallTime(),
+            .resizeLatency = backend->GetResizeLatency(),
+        };
+        {
+            std::lock_guard<std::mutex> lock(renderStatsMutex);
+            renderStats = stats;
+            renderTimings = timings;
+        }
+    }
+
+    void SceneRenderer::RenderThreadLoop()
+    {
+        jobSystem.RegisterThread();
+        VLT_PROFILE_THREAD("Render thread");
+
+        while (true)
+        {
+            FramePacket *packet = nullptr;
+            const auto waitStartTime = std::chrono::high_resolution_clock::now();
+            {
+                VLT_PROFILE_ZONE("Wait for submitted packet");
+                submittedPackets.Pop(packet);
+            }
+            renderThreadWaitTime.store(std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - waitStartTime).count(), std::memory_order_relaxed);
+
+            // A null packet asks the thread to stop
+            if (packet == nullptr)
+            {
+                break;
+            }
+
+            // The game thread is throttled through the packets, so pacing the render thread paces both
+            backend->PaceFrame();
+            RenderPacket(*packet);
+            freePackets.Push(packet);
+
+            packetsInFlight--;
+            packetsInFlight.notify_all();
+        }
+
+        jobSystem.UnregisterThread();
+    }
+
+    void SceneRenderer::FlushRenderThread()
+    {
+        if (!renderThreadEnabled)
+        {
+            return;
+        }
+
+        VLT_PROFILE_ZONE("SceneRenderer::FlushRenderThread");
+        for (uint32_t count = packetsInFlight.load(); count != 0; count = packetsInFlight.load())
+        {
+            packetsInFlight.wait(count);
+        }
+    }
+
+    void SceneRenderer::SetRenderThreadEnabled(bool enabled)
+    {
+        if (enabled == renderThreadEnabled)
+        {
+            return;
+        }
+
+        if (enabled)
+        {
+            // The game thread picks up a packet in BeginFrame
+            for (auto &packet : framePackets)
+            {
+                freePackets.Push(&packet);
+            }
+            currentPacket = nullptr;
+
+            renderThreadEnabled = true;
+            renderThread = std::thread(&SceneRenderer::RenderThreadLoop, this);
+            return;
+        }
+
+        submittedPackets.Push(nullptr);
+        renderThread.join();
+        renderThreadEnabled = false;
+
+        // Take every packet back, they are all free once the thread is gone
+        FramePacket *packet = nullptr;
+        while (freePackets.TryPop(packet))
+        {
+        }
+        currentPacket = &framePackets[0];
+    }
+}
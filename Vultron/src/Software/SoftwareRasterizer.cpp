@@ -0,0 +1,403 @@
+#include "Vultron/Software/SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Vultron
+{
+    static const std::array<float, 256> s_srgbToLinear = []()
+    {
+        std::array<float, 256> table{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            const float c = i / 255.0f;
+            table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return table;
+    }();
+
+    // Linear values quantized to 12 bits, enough to round trip every 8 bit sRGB value
+    constexpr uint32_t c_linearToSrgbSize = 4096;
+    static const std::array<uint8_t, c_linearToSrgbSize> s_linearToSrgb = []()
+    {
+        std::array<uint8_t, c_linearToSrgbSize> table{};
+        for (uint32_t i = 0; i < c_linearToSrgbSize; i++)
+        {
+            const float c = i / static_cast<float>(c_linearToSrgbSize - 1);
+            const float srgb = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+            table[i] = static_cast<uint8_t>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+        return table;
+    }();
+
+    static uint8_t LinearToSrgb(float value)
+    {
+        return s_linearToSrgb[static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * (c_linearToSrgbSize - 1) + 0.5f)];
+    }
+
+    static float Evaluate(const SoftwarePlane &plane, float x, float y)
+    {
+        return plane.dx * x + plane.dy * y + plane.c;
+    }
+
+    static SoftwarePlane MakePlane(const std::array<glm::vec2, 3> &points, const std::array<float, 3> &values, float invArea2)
+    {
+        const float d1 = values[1] - values[0];
+        const float d2 = values[2] - values[0];
+
+        SoftwarePlane plane;
+        plane.dx = (d1 * (points[2].y - points[0].y) - d2 * (points[1].y - points[0].y)) * invArea2;
+        plane.dy = (d2 * (points[1].x - points[0].x) - d1 * (points[2].x - points[0].x)) * invArea2;
+        plane.c = values[0] - plane.dx * points[0].x - plane.dy * points[0].y;
+        return plane;
+    }
+
+    // Bilinear filtering with repeat addressing on the mip level closest to the footprint, filtered in linear space
+    static glm::vec4 SampleTexture(const SoftwareTexture &texture, glm::vec2 uv, float lod)
+    {
+        const SoftwareTexture::Mip &base = texture.mips[0];
+        const float level = lod + 0.5f * std::log2(static_cast<float>(base.width) * base.height);
+        const uint32_t mipIndex = static_cast<uint32_t>(std::clamp(level + 0.5f, 0.0f, static_cast<float>(texture.mips.size() - 1)));
+        const SoftwareTexture::Mip &mip = texture.mips[mipIndex];
+
+        const float fx = uv.x * mip.width - 0.5f;
+        const float fy = uv.y * mip.height - 0.5f;
+        const float floorX = std::floor(fx);
+        const float floorY = std::floor(fy);
+        const float tx = fx - floorX;
+        const float ty = fy - floorY;
+
+        const int32_t width = static_cast<int32_t>(mip.width);
+        const int32_t height = static_cast<int32_t>(mip.height);
+        const int32_t x0 = ((static_cast<int32_t>(floorX) % width) + width) % width;
+        const int32_t y0 = ((static_cast<int32_t>(floorY) % height) + height) % height;
+        const int32_t x1 = x0 + 1 == width ? 0 : x0 + 1;
+        const int32_t y1 = y0 + 1 == height ? 0 : y0 + 1;
+
+        const auto fetch = [&mip](int32_t x, int32_t y)
+        {
+            const uint32_t texel = mip.texels[y * mip.width + x];
+            return glm::vec4(s_srgbToLinear[texel & 0xFF], s_srgbToLinear[(texel >> 8) & 0xFF], s_srgbToLinear[(texel >> 16) & 0xFF], (texel >> 24) / 255.0f);
+        };
+
+        const glm::vec4 top = glm::mix(fetch(x0, y0), fetch(x1, y0), tx);
+        const glm::vec4 bottom = glm::mix(fetch(x0, y1), fetch(x1, y1), tx);
+        return glm::mix(top, bottom, ty);
+    }
+
+    // Same lighting as triangle.frag, returns false when the pixel is discarded
+    static bool ShadePixel(const SoftwareTriangle &triangle, float x, float y, const glm::vec3 &lightDirection, uint32_t &color)
+    {
+        const SoftwareMaterial &material = *triangle.material;
+
+        const float w = 1.0f / Evaluate(triangle.invW, x, y);
+        const glm::vec2 texCoord(Evaluate(triangle.attributes[0], x, y) * w, Evaluate(triangle.attributes[1], x, y) * w);
+
+        const glm::vec4 albedo = SampleTexture(*material.texture, texCoord, triangle.lod);
+        if (material.alphaTest && albedo.a < material.alphaCutoff)
+        {
+            return false;
+        }
+
+        glm::vec3 normal = glm::normalize(glm::vec3(Evaluate(triangle.attributes[2], x, y), Evaluate(triangle.attributes[3], x, y), Evaluate(triangle.attributes[4], x, y)));
+        if (material.normalTexture != nullptr)
+        {
+            const glm::vec3 tangentNormal = glm::vec3(SampleTexture(*material.normalTexture, texCoord, triangle.lod)) * 2.0f - 1.0f;
+            normal = glm::normalize(glm::mat3(triangle.tangent, triangle.bitangent, normal) * tangentNormal);
+        }
+
+        const float intensity = std::max(glm::dot(normal, -lightDirection), 0.0f);
+        const glm::vec3 result = (0.1f + intensity) * glm::vec3(albedo);
+
+        color = LinearToSrgb(result.r) | (LinearToSrgb(result.g) << 8) | (LinearToSrgb(result.b) << 16) | (0xFFu << 24);
+        return true;
+    }
+
+    static bool SetupClipped(const std::array<SoftwareVertex, 3> &clipped, const glm::vec3 &tangent, const glm::vec3 &bitangent,
+                             const SoftwareMaterial &material, uint32_t width, uint32_t height, SoftwareTriangle &triangle)
+    {
+        std::array<SoftwareVertex, 3> vertices = clipped;
+        std::array<glm::vec2, 3> points;
+        std::array<float, 3> depths;
+        std::array<float, 3> invWs;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            invWs[i] = 1.0f / vertices[i].position.w;
+            points[i] = glm::vec2((vertices[i].position.x * invWs[i] * 0.5f + 0.5f) * width, (vertices[i].position.y * invWs[i] * 0.5f + 0.5f) * height);
+            depths[i] = vertices[i].position.z * invWs[i];
+        }
+
+        float area2 = (points[1].x - points[0].x) * (points[2].y - points[0].y) - (points[2].x - points[0].x) * (points[1].y - points[0].y);
+        if (area2 == 0.0f || !std::isfinite(area2))
+        {
+            return false;
+        }
+
+        // Vulkan calls a triangle counter-clockwise when this area is negative in framebuffer coordinates
+        const bool front = (area2 < 0.0f) == material.frontFaceCounterClockwise;
+        if (front ? material.cullFrontFaces : material.cullBackFaces)
+        {
+            return false;
+        }
+
+        // Wind every triangle the same way so the edge functions are positive inside
+        if (area2 < 0.0f)
+        {
+            std::swap(vertices[1], vertices[2]);
+            std::swap(points[1], points[2]);
+            std::swap(depths[1], depths[2]);
+            std::swap(invWs[1], invWs[2]);
+            area2 = -area2;
+        }
+
+        // Pixel centers covered by the bounds
+        const float minX = std::min({points[0].x, points[1].x, points[2].x});
+        const float maxX = std::max({points[0].x, points[1].x, points[2].x});
+        const float minY = std::min({points[0].y, points[1].y, points[2].y});
+        const float maxY = std::max({points[0].y, points[1].y, points[2].y});
+        triangle.minX = static_cast<int32_t>(std::max(std::ceil(minX - 0.5f), 0.0f));
+        triangle.minY = static_cast<int32_t>(std::max(std::ceil(minY - 0.5f), 0.0f));
+        triangle.maxX = static_cast<int32_t>(std::min(std::floor(maxX - 0.5f), static_cast<float>(width) - 1.0f));
+        triangle.maxY = static_cast<int32_t>(std::min(std::floor(maxY - 0.5f), static_cast<float>(height) - 1.0f));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        {
+            return false;
+        }
+
+        // The edge between two vertices is exactly negated for the neighbouring triangle, which keeps shared edges watertight
+        triangle.topLeftMask = 0;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            const glm::vec2 &a = points[(i + 1) % 3];
+            const glm::vec2 &b = points[(i + 2) % 3];
+            SoftwarePlane &edge = triangle.edges[i];
+            edge.dx = a.y - b.y;
+            edge.dy = b.x - a.x;
+            // The products are exact in double, so the result does not depend on whether the compiler fuses them
+            edge.c = static_cast<float>(static_cast<double>(a.x) * b.y - static_cast<double>(b.x) * a.y);
+
+            const bool topLeft = edge.dx > 0.0f || (edge.dx == 0.0f && edge.dy > 0.0f);
+            triangle.topLeftMask |= topLeft ? (1u << i) : 0;
+        }
+
+        const float invArea2 = 1.0f / area2;
+        triangle.depth = MakePlane(points, depths, invArea2);
+        triangle.invW = MakePlane(points, invWs, invArea2);
+        for (uint32_t attribute = 0; attribute < c_softwareAttributeCount; attribute++)
+        {
+            std::array<float, 3> values;
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const SoftwareVertex &vertex = vertices[i];
+                const float value = attribute < 2 ? vertex.texCoord[attribute] : vertex.normal[attribute - 2];
+                values[i] = value * invWs[i];
+            }
+            triangle.attributes[attribute] = MakePlane(points, values, invArea2);
+        }
+
+        const glm::vec2 uv1 = vertices[1].texCoord - vertices[0].texCoord;
+        const glm::vec2 uv2 = vertices[2].texCoord - vertices[0].texCoord;
+        const float uvArea2 = std::abs(uv1.x * uv2.y - uv2.x * uv1.y);
+        triangle.lod = uvArea2 > 0.0f ? 0.5f * std::log2(uvArea2 * invArea2) : -64.0f;
+
+        triangle.minDepth = std::min({depths[0], depths[1], depths[2]});
+        triangle.tangent = tangent;
+        triangle.bitangent = bitangent;
+        triangle.material = &material;
+
+        return true;
+    }
+
+    uint32_t SetupSoftwareTriangle(const std::array<SoftwareVertex, 3> &vertices, const glm::vec3 &tangent, const glm::vec3 &bitangent,
+                                   const SoftwareMaterial &material, uint32_t width, uint32_t height, SoftwareTriangle *out)
+    {
+        // Trivially outside one of the clip planes
+        const glm::vec4 &p0 = vertices[0].position;
+        const glm::vec4 &p1 = vertices[1].position;
+        const glm::vec4 &p2 = vertices[2].position;
+        if ((p0.x < -p0.w && p1.x < -p1.w && p2.x < -p2.w) || (p0.x > p0.w && p1.x > p1.w && p2.x > p2.w) ||
+            (p0.y < -p0.w && p1.y < -p1.w && p2.y < -p2.w) || (p0.y > p0.w && p1.y > p1.w && p2.y > p2.w) ||
+            (p0.z < 0.0f && p1.z < 0.0f && p2.z < 0.0f) || (p0.z > p0.w && p1.z > p1.w && p2.z > p2.w))
+        {
+            return 0;
+        }
+
+        if (p0.z >= 0.0f && p1.z >= 0.0f && p2.z >= 0.0f)
+        {
+            return SetupClipped(vertices, tangent, bitangent, material, width, height, out[0]) ? 1 : 0;
+        }
+
+        // Clip against the near plane z = 0, which Vulkan uses, leaving a triangle or a quad
+        std::array<SoftwareVertex, 4> polygon;
+        uint32_t polygonSize = 0;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            const SoftwareVertex &a = vertices[i];
+            const SoftwareVertex &b = vertices[(i + 1) % 3];
+            if (a.position.z >= 0.0f)
+            {
+                polygon[polygonSize++] = a;
+            }
+
+            if ((a.position.z >= 0.0f) != (b.position.z >= 0.0f))
+            {
+                const float t = a.position.z / (a.position.z - b.position.z);
+                polygon[polygonSize++] = {
+                    .position = glm::mix(a.position, b.position, t),
+                    .normal = glm::mix(a.normal, b.normal, t),
+                    .texCoord = glm::mix(a.texCoord, b.texCoord, t),
+                };
+            }
+        }
+
+        uint32_t count = 0;
+        for (uint32_t i = 1; i + 1 < polygonSize; i++)
+        {
+            if (SetupClipped({polygon[0], polygon[i], polygon[i + 1]}, tangent, bitangent, material, width, height, out[count]))
+            {
+                count++;
+            }
+        }
+
+        return count;
+    }
+
+    void RasterizeSoftwareTriangle(const SoftwareTriangle &triangle, const SoftwareTarget &target, int32_t x0, int32_t y0, int32_t x1, int32_t y1,
+                                   const glm::vec3 &lightDirection)
+    {
+        const SoftwareMaterial &material = *triangle.material;
+        constexpr int32_t blockSize = static_cast<int32_t>(c_softwareBlockSize);
+
+        const int32_t startX = std::max(x0, triangle.minX) / blockSize * blockSize;
+        const int32_t startY = std::max(y0, triangle.minY) / blockSize * blockSize;
+        const int32_t endX = std::min(x1, triangle.maxX + 1);
+        const int32_t endY = std::min(y1, triangle.maxY + 1);
+
+        for (int32_t blockY = startY; blockY < endY; blockY += blockSize)
+        {
+            for (int32_t blockX = startX; blockX < endX; blockX += blockSize)
+            {
+                // Coarse depth test, nothing in the block can pass if the triangle is behind everything in it
+                float &blockMaxDepth = target.blockMaxDepth[(blockY / blockSize) * target.blockCountX + blockX / blockSize];
+                if (material.depthTest && triangle.minDepth >= blockMaxDepth)
+                {
+                    continue;
+                }
+
+                // Skip the block if it is fully outside one edge, tested at the corner where the edge is largest
+                bool outside = false;
+                for (const SoftwarePlane &edge : triangle.edges)
+                {
+                    const float cornerX = blockX + 0.5f + (edge.dx > 0.0f ? blockSize - 1 : 0);
+                    const float cornerY = blockY + 0.5f + (edge.dy > 0.0f ? blockSize - 1 : 0);
+                    outside |= Evaluate(edge, cornerX, cornerY) < 0.0f;
+                }
+                if (outside)
+                {
+                    continue;
+                }
+
+                bool depthWritten = false;
+                for (int32_t row = 0; row < blockSize; row++)
+                {
+                    const int32_t y = blockY + row;
+                    const float centerY = y + 0.5f;
+                    float *depthRow = target.depth + static_cast<size_t>(y) * target.stride + blockX;
+                    uint32_t *colorRow = target.color + static_cast<size_t>(y) * target.stride + blockX;
+
+                    // One bit per pixel of the row that is covered and passes the depth test
+                    uint32_t mask = 0;
+#if defined(__AVX2__)
+                    const __m256 centerX = _mm256_add_ps(_mm256_set1_ps(blockX + 0.5f), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+                    __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        const SoftwarePlane &edge = triangle.edges[i];
+                        const __m256 value = _mm256_fmadd_ps(_mm256_set1_ps(edge.dx), centerX, _mm256_set1_ps(edge.dy * centerY + edge.c));
+                        const __m256 edgeInside = (triangle.topLeftMask & (1u << i)) ? _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GE_OQ)
+                                                                                    : _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GT_OQ);
+                        inside = _mm256_and_ps(inside, edgeInside);
+                    }
+
+                    mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+                    if (mask == 0)
+                    {
+                        continue;
+                    }
+
+                    const __m256 depth = _mm256_fmadd_ps(_mm256_set1_ps(triangle.depth.dx), centerX, _mm256_set1_ps(triangle.depth.dy * centerY + triangle.depth.c));
+                    if (material.depthTest)
+                    {
+                        mask &= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(depth, _mm256_loadu_ps(depthRow), _CMP_LT_OQ)));
+                    }
+
+                    alignas(32) float depths[c_softwareBlockSize];
+                    _mm256_store_ps(depths, depth);
+#else
+                    float depths[c_softwareBlockSize];
+                    for (int32_t column = 0; column < blockSize; column++)
+                    {
+                        const float centerX = blockX + column + 0.5f;
+                        bool inside = true;
+                        for (uint32_t i = 0; i < 3; i++)
+                        {
+                            const float value = Evaluate(triangle.edges[i], centerX, centerY);
+                            inside &= (triangle.topLeftMask & (1u << i)) ? value >= 0.0f : value > 0.0f;
+                        }
+
+                        depths[column] = Evaluate(triangle.depth, centerX, centerY);
+                        if (inside && (!material.depthTest || depths[column] < depthRow[column]))
+                        {
+                            mask |= 1u << column;
+                        }
+                    }
+#endif
+
+                    while (mask != 0)
+                    {
+                        const int32_t column = std::countr_zero(mask);
+                        mask &= mask - 1;
+
+                        uint32_t color = 0;
+                        if (!ShadePixel(triangle, blockX + column + 0.5f, centerY, lightDirection, color))
+                        {
+                            continue;
+                        }
+
+                        colorRow[column] = color;
+                        if (material.depthWrite)
+                        {
+                            depthRow[column] = depths[column];
+                            depthWritten = true;
+                        }
+                    }
+                }
+
+                if (depthWritten)
+                {
+                    float maxDepth = 0.0f;
+                    for (int32_t row = 0; row < blockSize; row++)
+                    {
+                        const float *depthRow = target.depth + static_cast<size_t>(blockY + row) * target.stride + blockX;
+                        maxDepth = std::max(maxDepth, *std::max_element(depthRow, depthRow + blockSize));
+                    }
+                    blockMaxDepth = maxDepth;
+                }
+            }
+        }
+    }
+
+    void ClearSoftwareTarget(const SoftwareTarget &target, uint32_t firstRow, uint32_t rowCount)
+    {
+        const size_t first = static_cast<size_t>(firstRow) * c_softwareBlockSize * target.stride;
+        const size_t count = static_cast<size_t>(rowCount) * c_softwareBlockSize * target.stride;
+        std::fill_n(target.color + first, count, 0xFF000000u);
+        std::fill_n(target.depth + first, count, 1.0f);
+        std::fill_n(target.blockMaxDepth + static_cast<size_t>(firstRow) * target.blockCountX, static_cast<size_t>(rowCount) * target.blockCountX, 1.0f);
+    }
+}
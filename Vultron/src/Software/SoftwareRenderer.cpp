@@ -0,0 +1,455 @@
+#include "Vultron/Software/SoftwareRenderer.h"
+
+#include "Vultron/Core/Profiler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace Vultron
+{
+    static std::array<glm::vec4, 6> GetFrustumPlanes(const glm::mat4 &viewProj)
+    {
+        const glm::vec4 row0(viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0]);
+        const glm::vec4 row1(viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1]);
+        const glm::vec4 row2(viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2]);
+        const glm::vec4 row3(viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3]);
+
+        // Depth goes from 0 to 1 like in Vulkan, so the near plane is z >= 0
+        std::array<glm::vec4, 6> planes = {row3 + row0, row3 - row0, row3 + row1, row3 - row1, row2, row3 - row2};
+        for (glm::vec4 &plane : planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        return planes;
+    }
+
+    bool SoftwareRenderer::Initialize(const Window &window, JobSystem &jobSystem)
+    {
+        std::cerr << "Software render backend cannot present to a window, use it headless." << std::endl;
+        return false;
+    }
+
+    bool SoftwareRenderer::InitializeHeadless(uint32_t width, uint32_t height, JobSystem &jobSystem)
+    {
+        if (width == 0 || height == 0)
+        {
+            std::cerr << "Faild to initialize software target." << std::endl;
+            return false;
+        }
+
+        m_jobSystem = &jobSystem;
+        m_width = width;
+        m_height = height;
+        m_stride = (width + c_softwareBlockSize - 1) / c_softwareBlockSize * c_softwareBlockSize;
+        m_paddedHeight = (height + c_softwareBlockSize - 1) / c_softwareBlockSize * c_softwareBlockSize;
+        m_tileCountX = (width + c_softwareTileSize - 1) / c_softwareTileSize;
+        m_tileCountY = (height + c_softwareTileSize - 1) / c_softwareTileSize;
+
+        const size_t pixelCount = static_cast<size_t>(m_stride) * m_paddedHeight;
+        for (auto &colorBuffer : m_colorBuffers)
+        {
+            colorBuffer.assign(pixelCount, 0xFF000000u);
+        }
+        m_depthBuffer.assign(pixelCount, 1.0f);
+        m_blockMaxDepth.assign(pixelCount / (c_softwareBlockSize * c_softwareBlockSize), 1.0f);
+
+        for (auto &chunk : m_chunks)
+        {
+            chunk.bins.resize(m_tileCountX * m_tileCountY);
+        }
+
+        std::cout << "Using software render backend at " << width << "x" << height << " with " << jobSystem.GetWorkerCount() + 1 << " threads." << std::endl;
+
+        return true;
+    }
+
+    void SoftwareRenderer::Shutdown()
+    {
+        for (const JobCounter &counter : m_readbackCounters)
+        {
+            m_jobSystem->Wait(counter);
+        }
+
+        m_meshes.clear();
+        m_textures.clear();
+        m_materials.clear();
+    }
+
+    RenderHandle SoftwareRenderer::LoadMesh(const std::string &filepath)
+    {
+        VLT_PROFILE_ZONE("SoftwareRenderer::LoadMesh");
+
+        auto mesh = MakePtr<SoftwareMesh>();
+        VulkanMesh::ReadFile(filepath, mesh->vertices, mesh->indices);
+        const size_t vertexCount = mesh->vertices.size();
+
+        glm::vec3 minPosition(std::numeric_limits<float>::max());
+        glm::vec3 maxPosition(std::numeric_limits<float>::lowest());
+        for (const StaticMeshVertex &vertex : mesh->vertices)
+        {
+            minPosition = glm::min(minPosition, vertex.position);
+            maxPosition = glm::max(maxPosition, vertex.position);
+        }
+        mesh->boundsCenter = vertexCount > 0 ? (minPosition + maxPosition) * 0.5f : glm::vec3(0.0f);
+        for (const StaticMeshVertex &vertex : mesh->vertices)
+        {
+            mesh->boundsRadius = std::max(mesh->boundsRadius, glm::length(vertex.position - mesh->boundsCenter));
+        }
+
+        // Tangent frame from the position and texture coordinate edges, the meshes do not store tangents
+        const uint32_t triangleCount = mesh->GetTriangleCount();
+        mesh->tangents.resize(triangleCount);
+        mesh->bitangents.resize(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; i++)
+        {
+            const StaticMeshVertex &v0 = mesh->vertices[mesh->indices[i * 3 + 0]];
+            const StaticMeshVertex &v1 = mesh->vertices[mesh->indices[i * 3 + 1]];
+            const StaticMeshVertex &v2 = mesh->vertices[mesh->indices[i * 3 + 2]];
+            const glm::vec3 dp1 = v1.position - v0.position;
+            const glm::vec3 dp2 = v2.position - v0.position;
+            const glm::vec2 duv1 = v1.texCoord - v0.texCoord;
+            const glm::vec2 duv2 = v2.texCoord - v0.texCoord;
+
+            const float determinant = duv1.x * duv2.y - duv2.x * duv1.y;
+            const float invDeterminant = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+            const glm::vec3 tangent = (dp1 * duv2.y - dp2 * duv1.y) * invDeterminant;
+            const glm::vec3 bitangent = (dp2 * duv1.x - dp1 * duv2.x) * invDeterminant;
+
+            const float invMax = glm::inversesqrt(std::max({glm::dot(tangent, tangent), glm::dot(bitangent, bitangent), 1e-12f}));
+            mesh->tangents[i] = tangent * invMax;
+            mesh->bitangents[i] = bitangent * invMax;
+        }
+
+        std::cout << "Loaded mesh with " << vertexCount << " vertices and " << mesh->indices.size() << " indices" << std::endl;
+
+        m_meshes.push_back(std::move(mesh));
+        return m_meshes.size();
+    }
+
+    RenderHandle SoftwareRenderer::LoadImage(const std::string &filepath)
+    {
+        VLT_PROFILE_ZONE("SoftwareRenderer::LoadImage");
+
+        const ImageFileData imageFile = VulkanImage::ReadFile(filepath);
+        if (imageFile.numBytesPerChannel != 1 || imageFile.numChannels == 0 || imageFile.numChannels > 4)
+        {
+            std::cerr << "Software render backend only supports 8 bit images: " << filepath << std::endl;
+            return VLT_INVALID_HANDLE;
+        }
+
+        auto texture = MakePtr<SoftwareTexture>();
+        for (const ImageFileData::Mip &fileMip : imageFile.mips)
+        {
+            SoftwareTexture::Mip &mip = texture->mips.emplace_back();
+            mip.width = std::max(fileMip.width, 1u);
+            mip.height = std::max(fileMip.height, 1u);
+
+            // Missing channels are zero, missing alpha is opaque
+            const size_t texelCount = static_cast<size_t>(fileMip.width) * fileMip.height;
+            mip.texels.assign(static_cast<size_t>(mip.width) * mip.height, 0xFF000000u);
+            for (size_t i = 0; i < texelCount; i++)
+            {
+                uint32_t texel = imageFile.numChannels < 4 ? 0xFF000000u : 0;
+                for (uint32_t channel = 0; channel < imageFile.numChannels; channel++)
+                {
+                    texel |= static_cast<uint32_t>(fileMip.data[i * imageFile.numChannels + channel]) << (channel * 8);
+                }
+                mip.texels[i] = texel;
+            }
+        }
+
+        m_textures.push_back(std::move(texture));
+        return m_textures.size();
+    }
+
+    RenderHandle SoftwareRenderer::CreateMaterial(const TexturedMaterial &material)
+    {
+        if (material.texture == VLT_INVALID_HANDLE || material.texture > m_textures.size())
+        {
+            return VLT_INVALID_HANDLE;
+        }
+
+        const PipelineState &state = material.pipelineState;
+        auto softwareMaterial = MakePtr<SoftwareMaterial>(SoftwareMaterial{
+            .texture = m_textures[material.texture - 1].get(),
+            .normalTexture = material.normalTexture.has_value() && *material.normalTexture <= m_textures.size() ? m_textures[*material.normalTexture - 1].get() : nullptr,
+            .alphaTest = material.alphaTest,
+            .alphaCutoff = material.alphaCutoff,
+            .cullBackFaces = (state.cullMode & VK_CULL_MODE_BACK_BIT) != 0,
+            .cullFrontFaces = (state.cullMode & VK_CULL_MODE_FRONT_BIT) != 0,
+            .frontFaceCounterClockwise = state.frontFace == VK_FRONT_FACE_COUNTER_CLOCKWISE,
+            .depthTest = state.depthTest,
+            .depthWrite = state.depthWrite,
+        });
+
+        m_materials.push_back(std::move(softwareMaterial));
+        return m_materials.size();
+    }
+
+    bool SoftwareRenderer::SetReadbackCallback(ReadbackCallback callback)
+    {
+        for (const JobCounter &counter : m_readbackCounters)
+        {
+            m_jobSystem->Wait(counter);
+        }
+
+        m_readbackCallback = std::move(callback);
+        return true;
+    }
+
+    SoftwareTarget SoftwareRenderer::GetTarget() const
+    {
+        return {
+            .color = const_cast<uint32_t *>(m_colorBuffers[m_currentColorBuffer].data()),
+            .depth = const_cast<float *>(m_depthBuffer.data()),
+            .blockMaxDepth = const_cast<float *>(m_blockMaxDepth.data()),
+            .width = m_width,
+            .height = m_height,
+            .stride = m_stride,
+            .paddedHeight = m_paddedHeight,
+            .blockCountX = m_stride / c_softwareBlockSize,
+        };
+    }
+
+    uint64_t SoftwareRenderer::CollectDraws(const glm::mat4 &viewProj, const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances)
+    {
+        const std::array<glm::vec4, 6> planes = GetFrustumPlanes(viewProj);
+
+        m_draws.clear();
+        uint64_t triangleCount = 0;
+        for (const RenderBatch &batch : batches)
+        {
+            const bool validMesh = batch.mesh != VLT_INVALID_HANDLE && batch.mesh <= m_meshes.size();
+            const bool validMaterial = batch.material != VLT_INVALID_HANDLE && batch.material <= m_materials.size();
+            if (!validMesh || !validMaterial || static_cast<size_t>(batch.firstInstance) + batch.instanceCount > instances.size())
+            {
+                continue;
+            }
+
+            const SoftwareMesh &mesh = *m_meshes[batch.mesh - 1];
+            for (uint32_t i = 0; i < batch.instanceCount; i++)
+            {
+                const glm::mat4 &model = instances[batch.firstInstance + i];
+
+                const glm::vec3 center = glm::vec3(model * glm::vec4(mesh.boundsCenter, 1.0f));
+                const float scale = std::sqrt(std::max({glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+                                                        glm::dot(glm::vec3(model[1]), glm::vec3(model[1])),
+                                                        glm::dot(glm::vec3(model[2]), glm::vec3(model[2]))}));
+                const float radius = mesh.boundsRadius * scale;
+
+                bool visible = true;
+                for (const glm::vec4 &plane : planes)
+                {
+                    visible &= glm::dot(glm::vec3(plane), center) + plane.w >= -radius;
+                }
+                if (!visible)
+                {
+                    m_stats.culledInstances++;
+                    continue;
+                }
+
+                m_draws.push_back({
+                    .mesh = &mesh,
+                    .material = m_materials[batch.material - 1].get(),
+                    .modelViewProj = viewProj * model,
+                    .firstTriangle = triangleCount,
+                });
+                triangleCount += mesh.GetTriangleCount();
+            }
+        }
+
+        return triangleCount;
+    }
+
+    uint32_t SoftwareRenderer::SetupTriangles(uint64_t firstTriangle, uint64_t count)
+    {
+        VLT_PROFILE_ZONE("Setup triangles");
+
+        const uint32_t chunkCount = static_cast<uint32_t>(std::clamp<uint64_t>(count / c_softwareMinChunkTriangles, 1, c_softwareMaxSetupChunks));
+
+        m_jobSystem->ParallelFor(chunkCount, 1, [&](uint32_t begin, uint32_t end)
+                                 {
+            for (uint32_t chunkIndex = begin; chunkIndex < end; chunkIndex++)
+            {
+                SoftwareSetupChunk &chunk = m_chunks[chunkIndex];
+                chunk.triangles.clear();
+                chunk.culledTriangles = 0;
+                for (auto &bin : chunk.bins)
+                {
+                    bin.clear();
+                }
+
+                // Chunks cover consecutive triangle ranges, so visiting them in order keeps the submission order
+                const uint64_t chunkBegin = firstTriangle + count * chunkIndex / chunkCount;
+                const uint64_t chunkEnd = firstTriangle + count * (chunkIndex + 1) / chunkCount;
+
+                auto draw = std::upper_bound(m_draws.begin(), m_draws.end(), chunkBegin, [](uint64_t triangle, const SoftwareDraw &draw)
+                                             { return triangle < draw.firstTriangle; }) - 1;
+                for (uint64_t triangle = chunkBegin; triangle < chunkEnd; triangle++)
+                {
+                    while (triangle >= draw->firstTriangle + draw->mesh->GetTriangleCount())
+                    {
+                        draw++;
+                    }
+
+                    const SoftwareMesh &mesh = *draw->mesh;
+                    const uint32_t meshTriangle = static_cast<uint32_t>(triangle - draw->firstTriangle);
+                    std::array<SoftwareVertex, 3> vertices;
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        const StaticMeshVertex &vertex = mesh.vertices[mesh.indices[meshTriangle * 3 + i]];
+                        vertices[i] = {
+                            .position = draw->modelViewProj * glm::vec4(vertex.position, 1.0f),
+                            .normal = vertex.normal,
+                            .texCoord = vertex.texCoord,
+                        };
+                    }
+
+                    const size_t first = chunk.triangles.size();
+                    chunk.triangles.resize(first + 2);
+                    const uint32_t setupCount = SetupSoftwareTriangle(vertices, mesh.tangents[meshTriangle], mesh.bitangents[meshTriangle], *draw->material,
+                                                                      m_width, m_height, &chunk.triangles[first]);
+                    chunk.triangles.resize(first + setupCount);
+                    chunk.culledTriangles += setupCount == 0 ? 1 : 0;
+
+                    for (size_t index = first; index < chunk.triangles.size(); index++)
+                    {
+                        const SoftwareTriangle &setup = chunk.triangles[index];
+                        constexpr int32_t tileSize = static_cast<int32_t>(c_softwareTileSize);
+                        for (int32_t tileY = setup.minY / tileSize; tileY <= setup.maxY / tileSize; tileY++)
+                        {
+                            for (int32_t tileX = setup.minX / tileSize; tileX <= setup.maxX / tileSize; tileX++)
+                            {
+                                chunk.bins[tileY * m_tileCountX + tileX].push_back(static_cast<uint32_t>(index));
+                            }
+                        }
+                    }
+                }
+            } });
+
+        return chunkCount;
+    }
+
+    void SoftwareRenderer::RasterizeTiles(uint32_t chunkCount, const glm::vec3 &lightDirection)
+    {
+        VLT_PROFILE_ZONE("Rasterize tiles");
+
+        const SoftwareTarget target = GetTarget();
+
+        // One job per tile, tiles never share pixels or depth blocks
+        m_jobSystem->ParallelFor(m_tileCountX * m_tileCountY, 1, [&](uint32_t begin, uint32_t end)
+                                 {
+            for (uint32_t tile = begin; tile < end; tile++)
+            {
+                const int32_t x0 = static_cast<int32_t>((tile % m_tileCountX) * c_softwareTileSize);
+                const int32_t y0 = static_cast<int32_t>((tile / m_tileCountX) * c_softwareTileSize);
+                const int32_t x1 = std::min(x0 + static_cast<int32_t>(c_softwareTileSize), static_cast<int32_t>(m_width));
+                const int32_t y1 = std::min(y0 + static_cast<int32_t>(c_softwareTileSize), static_cast<int32_t>(m_height));
+
+                for (uint32_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++)
+                {
+                    const SoftwareSetupChunk &chunk = m_chunks[chunkIndex];
+                    for (uint32_t index : chunk.bins[tile])
+                    {
+                        RasterizeSoftwareTriangle(chunk.triangles[index], target, x0, y0, x1, y1, lightDirection);
+                    }
+                }
+            } });
+    }
+
+    void SoftwareRenderer::RunReadbackCallback(uint32_t bufferIndex, uint64_t frameNumber)
+    {
+        const std::vector<uint32_t> &color = m_colorBuffers[bufferIndex];
+        const uint32_t *pixels = color.data();
+
+        // The callback gets tightly packed rows
+        if (m_stride != m_width)
+        {
+            std::vector<uint32_t> &rows = m_readbackRows[bufferIndex];
+            rows.resize(static_cast<size_t>(m_width) * m_height);
+            for (uint32_t y = 0; y < m_height; y++)
+            {
+                std::copy_n(color.data() + static_cast<size_t>(y) * m_stride, m_width, rows.data() + static_cast<size_t>(y) * m_width);
+            }
+            pixels = rows.data();
+        }
+
+        m_readbackCallback({
+            .frameNumber = frameNumber,
+            .width = m_width,
+            .height = m_height,
+            .format = c_offscreenColorFormat,
+            .data = reinterpret_cast<const uint8_t *>(pixels),
+            .size = static_cast<size_t>(m_width) * m_height * sizeof(uint32_t),
+        });
+    }
+
+    void SoftwareRenderer::Draw(const Camera &camera, const DirectionalLight &light, const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances,
+                                const std::vector<InstanceRange> &dirtyInstances, std::chrono::high_resolution_clock::time_point inputTime)
+    {
+        VLT_PROFILE_ZONE("SoftwareRenderer::Draw");
+
+        // The color buffer may still be read by the callback of an earlier frame
+        const auto waitStartTime = std::chrono::high_resolution_clock::now();
+        m_jobSystem->Wait(m_readbackCounters[m_currentColorBuffer]);
+        m_readbackStallTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - waitStartTime).count();
+
+        const auto setupStartTime = std::chrono::high_resolution_clock::now();
+
+        // Same projection as VulkanRenderer
+        const float aspect = static_cast<float>(m_width) / static_cast<float>(m_height);
+        const glm::mat4 view = glm::lookAt(camera.position, camera.position + camera.direction, camera.up);
+        glm::mat4 proj = glm::perspective(glm::radians(camera.fov), aspect, camera.nearPlane, camera.farPlane);
+        proj[1][1] *= -1;
+
+        m_stats = {};
+        m_stats.frameNumber = m_frameNumber + 1;
+        m_triangleCount = CollectDraws(proj * view, batches, instances);
+        m_stats.drawCalls = m_draws.size();
+        m_stats.instances = m_draws.size();
+        m_stats.triangles = m_triangleCount;
+
+        const SoftwareTarget target = GetTarget();
+        const uint32_t blockRowCount = m_paddedHeight / c_softwareBlockSize;
+        m_jobSystem->ParallelFor(blockRowCount, 4, [&target](uint32_t begin, uint32_t end)
+                                 { ClearSoftwareTarget(target, begin, end - begin); });
+
+        // Large scenes are drawn in several passes so the bins stay bounded
+        m_setupTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - setupStartTime).count();
+        m_rasterTime = 0.0f;
+        for (uint64_t passStart = 0; passStart < m_triangleCount; passStart += c_softwareTrianglesPerPass)
+        {
+            const auto passStartTime = std::chrono::high_resolution_clock::now();
+            const uint32_t chunkCount = SetupTriangles(passStart, std::min<uint64_t>(c_softwareTrianglesPerPass, m_triangleCount - passStart));
+
+            for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+            {
+                m_stats.culledTriangles += m_chunks[chunk].culledTriangles;
+            }
+
+            const auto rasterStartTime = std::chrono::high_resolution_clock::now();
+            RasterizeTiles(chunkCount, light.direction);
+
+            const auto passEndTime = std::chrono::high_resolution_clock::now();
+            m_setupTime += std::chrono::duration<float, std::chrono::milliseconds::period>(rasterStartTime - passStartTime).count();
+            m_rasterTime += std::chrono::duration<float, std::chrono::milliseconds::period>(passEndTime - rasterStartTime).count();
+        }
+
+        m_frameNumber++;
+        if (m_readbackCallback)
+        {
+            const uint32_t bufferIndex = m_currentColorBuffer;
+            const uint64_t frameNumber = m_frameNumber;
+            m_jobSystem->RunBackground([this, bufferIndex, frameNumber]()
+                                       { RunReadbackCallback(bufferIndex, frameNumber); },
+                                       m_readbackCounters[bufferIndex]);
+        }
+
+        m_currentColorBuffer = (m_currentColorBuffer + 1) % c_softwareColorBufferCount;
+        m_latency = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - inputTime).count();
+    }
+}
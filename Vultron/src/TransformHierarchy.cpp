@@ -0,0 +1,318 @@
+#include "Vultron/TransformHierarchy.h"
+
+#include "Vultron/Core/Profiler.h"
+#include "Vultron/RetainedScene.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+namespace Vultron
+{
+    // result = a * b, result must not be a
+    static void MultiplyMatrices(const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &result)
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+        const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+        const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+        const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+        for (int column = 0; column < 4; column++)
+        {
+            __m128 value = _mm_mul_ps(a0, _mm_set1_ps(b[column][0]));
+            value = _mm_add_ps(value, _mm_mul_ps(a1, _mm_set1_ps(b[column][1])));
+            value = _mm_add_ps(value, _mm_mul_ps(a2, _mm_set1_ps(b[column][2])));
+            value = _mm_add_ps(value, _mm_mul_ps(a3, _mm_set1_ps(b[column][3])));
+            _mm_storeu_ps(&result[column][0], value);
+        }
+#else
+        result = a * b;
+#endif
+    }
+
+    // Reorders values so that the new slot i holds the old slot order[i]
+    template <typename T>
+    static void Reorder(std::vector<T> &values, const std::vector<uint32_t> &order)
+    {
+        std::vector<T> reordered(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            reordered[i] = values[order[i]];
+        }
+        values = std::move(reordered);
+    }
+
+    void TransformHierarchy::Apply(const std::vector<TransformCommand> &commands)
+    {
+        VLT_PROFILE_ZONE("TransformHierarchy::Apply");
+
+        for (const TransformCommand &command : commands)
+        {
+            switch (command.type)
+            {
+            case TransformCommandType::Create:
+            {
+                if (command.node >= m_slots.size())
+                {
+                    m_slots.resize(command.node + 1, c_noTransformTarget);
+                }
+
+                assert(m_slots[command.node] == c_noTransformTarget && "Transform node already exists.");
+                const uint32_t parent = command.target != c_noTransformTarget ? m_slots[command.target] : c_noTransformTarget;
+                assert((command.target == c_noTransformTarget || parent != c_noTransformTarget) && "Parent transform node does not exist.");
+
+                // Appended for now, sorted into its level by the next Update
+                const uint32_t slot = static_cast<uint32_t>(m_nodes.size());
+                m_nodes.push_back(command.node);
+                m_parents.push_back(parent);
+                m_depths.push_back(parent != c_noTransformTarget ? m_depths[parent] + 1 : 0);
+                m_positions.push_back(command.local.position);
+                m_rotations.push_back(command.local.rotation);
+                m_scales.push_back(command.local.scale);
+                m_worlds.emplace_back(1.0f);
+                m_objects.push_back(c_noTransformTarget);
+                m_localDirty.push_back(0);
+                m_changed.push_back(0);
+
+                m_slots[command.node] = slot;
+                m_nodeCount++;
+                m_layoutDirty = true;
+                MarkDirty(slot);
+                break;
+            }
+            case TransformCommandType::SetLocal:
+            {
+                const uint32_t slot = m_slots[command.node];
+                assert(slot != c_noTransformTarget && "Transform node does not exist.");
+                m_positions[slot] = command.local.position;
+                m_rotations[slot] = command.local.rotation;
+                m_scales[slot] = command.local.scale;
+                MarkDirty(slot);
+                break;
+            }
+            case TransformCommandType::Destroy:
+            {
+                const uint32_t slot = m_slots[command.node];
+                assert(slot != c_noTransformTarget && "Transform node does not exist.");
+                if (m_objects[slot] != c_noTransformTarget)
+                {
+                    m_objects[slot] = c_noTransformTarget;
+                    m_objectsDirty = true;
+                }
+
+                // The slot is dropped by the next layout rebuild
+                m_nodes[slot] = c_noTransformTarget;
+                m_slots[command.node] = c_noTransformTarget;
+                m_nodeCount--;
+                m_layoutDirty = true;
+                break;
+            }
+            case TransformCommandType::Attach:
+            {
+                const uint32_t slot = m_slots[command.node];
+                assert(slot != c_noTransformTarget && "Transform node does not exist.");
+                m_objects[slot] = command.target;
+                m_objectsDirty = true;
+
+                // A newly attached object needs the world matrix even if the node did not move
+                if (command.target != c_noTransformTarget)
+                {
+                    MarkDirty(slot);
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    void TransformHierarchy::MarkDirty(uint32_t slot)
+    {
+        m_localDirty[slot] = 1;
+
+        const uint32_t depth = m_depths[slot];
+        if (m_dirtyDepths.size() <= depth)
+        {
+            m_dirtyDepths.resize(depth + 1, 0);
+        }
+        m_dirtyDepths[depth] = 1;
+    }
+
+    void TransformHierarchy::RebuildLayout()
+    {
+        VLT_PROFILE_ZONE("TransformHierarchy::RebuildLayout");
+
+        // Counting sort by depth, stable so nodes keep their relative order within a level
+        uint32_t levelCount = 0;
+        for (size_t slot = 0; slot < m_nodes.size(); slot++)
+        {
+            if (m_nodes[slot] != c_noTransformTarget)
+            {
+                levelCount = std::max(levelCount, m_depths[slot] + 1);
+            }
+        }
+
+        m_levels.assign(levelCount + 1, 0);
+        for (size_t slot = 0; slot < m_nodes.size(); slot++)
+        {
+            if (m_nodes[slot] != c_noTransformTarget)
+            {
+                m_levels[m_depths[slot] + 1]++;
+            }
+        }
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            m_levels[level + 1] += m_levels[level];
+        }
+
+        std::vector<uint32_t> order(m_levels[levelCount]);
+        std::vector<uint32_t> newSlots(m_nodes.size(), c_noTransformTarget);
+        std::vector<uint32_t> levelEnds(m_levels.begin(), m_levels.end() - 1);
+        for (uint32_t slot = 0; slot < m_nodes.size(); slot++)
+        {
+            if (m_nodes[slot] != c_noTransformTarget)
+            {
+                const uint32_t newSlot = levelEnds[m_depths[slot]]++;
+                order[newSlot] = slot;
+                newSlots[slot] = newSlot;
+            }
+        }
+
+        Reorder(m_nodes, order);
+        Reorder(m_parents, order);
+        Reorder(m_depths, order);
+        Reorder(m_positions, order);
+        Reorder(m_rotations, order);
+        Reorder(m_scales, order);
+        Reorder(m_worlds, order);
+        Reorder(m_objects, order);
+        Reorder(m_localDirty, order);
+        Reorder(m_changed, order);
+
+        for (uint32_t slot = 0; slot < m_nodes.size(); slot++)
+        {
+            m_slots[m_nodes[slot]] = slot;
+            if (m_parents[slot] != c_noTransformTarget)
+            {
+                m_parents[slot] = newSlots[m_parents[slot]];
+            }
+        }
+
+        m_layoutDirty = false;
+        m_objectsDirty = true;
+    }
+
+    uint32_t TransformHierarchy::PropagateLevel(uint32_t first, uint32_t last, std::atomic<uint32_t> &changedObjectCount)
+    {
+        uint32_t changed = 0;
+        uint32_t changedObjects = 0;
+        for (uint32_t slot = first; slot < last; slot++)
+        {
+            // Parents are in the previous level, which is done
+            const uint32_t parent = m_parents[slot];
+            const bool parentChanged = parent != c_noTransformTarget && m_changed[parent] == m_updateNumber;
+            if (!m_localDirty[slot] && !parentChanged)
+            {
+                continue;
+            }
+
+            m_localDirty[slot] = 0;
+            const glm::mat4 local = ComposeTransform(m_positions[slot], m_rotations[slot], m_scales[slot]);
+            if (parent == c_noTransformTarget)
+            {
+                m_worlds[slot] = local;
+            }
+            else
+            {
+                MultiplyMatrices(m_worlds[parent], local, m_worlds[slot]);
+            }
+
+            m_changed[slot] = m_updateNumber;
+            changed++;
+            changedObjects += m_objects[slot] != c_noTransformTarget;
+        }
+
+        // One atomic per range, the range is still in cache for the second pass
+        if (changedObjects > 0)
+        {
+            uint32_t index = changedObjectCount.fetch_add(changedObjects, std::memory_order_relaxed);
+            for (uint32_t slot = first; slot < last; slot++)
+            {
+                if (m_changed[slot] == m_updateNumber && m_objects[slot] != c_noTransformTarget)
+                {
+                    m_changedObjectSlots[index++] = slot;
+                }
+            }
+        }
+
+        return changed;
+    }
+
+    void TransformHierarchy::Update(JobSystem &jobSystem)
+    {
+        VLT_PROFILE_ZONE("TransformHierarchy::Update");
+
+        m_updatedCount = 0;
+        m_updateNumber++;
+
+        if (m_layoutDirty)
+        {
+            RebuildLayout();
+        }
+
+        // Room for every slot that drives a render object, so propagation never has to grow it
+        if (m_objectsDirty)
+        {
+            m_changedObjectSlots.resize(std::count_if(m_objects.begin(), m_objects.end(), [](uint32_t object)
+                                                      { return object != c_noTransformTarget; }));
+            m_objectsDirty = false;
+        }
+
+        // A level is only visited if one of its nodes changed itself or a node of the level above changed,
+        // so a frame where nothing moves costs one check per level
+        bool parentsChanged = false;
+        std::atomic<uint32_t> changedObjectCount = 0;
+        const uint32_t levelCount = m_levels.empty() ? 0 : static_cast<uint32_t>(m_levels.size()) - 1;
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            const bool levelDirty = level < m_dirtyDepths.size() && m_dirtyDepths[level] != 0;
+            if (!levelDirty && !parentsChanged)
+            {
+                continue;
+            }
+
+            const uint32_t first = m_levels[level];
+            std::atomic<uint32_t> changed = 0;
+            jobSystem.ParallelFor(m_levels[level + 1] - first, c_transformGrainSize, [&](uint32_t begin, uint32_t end)
+                                  { changed.fetch_add(PropagateLevel(first + begin, first + end, changedObjectCount), std::memory_order_relaxed); });
+
+            parentsChanged = changed > 0;
+            m_updatedCount += changed;
+        }
+
+        std::fill(m_dirtyDepths.begin(), m_dirtyDepths.end(), 0);
+        m_changedObjectCount = changedObjectCount;
+    }
+
+    void TransformHierarchy::WriteInstances(RetainedScene &scene, JobSystem &jobSystem) const
+    {
+        if (m_changedObjectCount == 0)
+        {
+            return;
+        }
+
+        VLT_PROFILE_ZONE("TransformHierarchy::WriteInstances");
+
+        // Only the attached slots that changed, a frame where few nodes move costs nothing per attached object
+        jobSystem.ParallelFor(m_changedObjectCount, c_transformGrainSize, [&](uint32_t begin, uint32_t end)
+                              {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const uint32_t slot = m_changedObjectSlots[i];
+                scene.WriteObjectTransform(m_objects[slot], m_worlds[slot]);
+            } });
+    }
+}
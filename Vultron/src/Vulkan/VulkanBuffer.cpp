@@ -23,12 +23,14 @@ namespace Vultron
         VkBuffer buffer;
         VmaAllocation allocation;
         vmaCreateBuffer(createInfo.allocator, &bufferInfo, &allocInfo, &buffer, &allocation, nullptr);
+        TagAllocation(createInfo.allocator, allocation, createInfo.category);
 
         return VulkanBuffer(buffer, allocation, createInfo.size);
     }
 
     void VulkanBuffer::Destroy(VmaAllocator allocator)
     {
+        UntagAllocation(allocator, m_allocation);
         vmaDestroyBuffer(allocator, m_buffer, m_allocation);
     }
 }
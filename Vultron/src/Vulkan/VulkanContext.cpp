@@ -2,15 +2,19 @@
 
 #include "Vultron/Vulkan/VulkanUtils.h"
 
+#include <cassert>
 #include <iostream>
 #include <set>
+#include <cstring>
 
 namespace Vultron
 {
 
     bool VulkanContext::Initialize(const Window &window)
     {
-        if (!InitializeInstance(window))
+        m_headless = false;
+
+        if (!InitializeInstance(window.GetWindowExtensions()))
         {
             std::cerr << "Faild to initialize instance." << std::endl;
             return false;
@@ -22,6 +26,25 @@ namespace Vultron
             return false;
         }
 
+        return InitializeDevice();
+    }
+
+    bool VulkanContext::InitializeHeadless()
+    {
+        m_headless = true;
+        m_surface = VK_NULL_HANDLE;
+
+        if (!InitializeInstance({}))
+        {
+            std::cerr << "Faild to initialize instance." << std::endl;
+            return false;
+        }
+
+        return InitializeDevice();
+    }
+
+    bool VulkanContext::InitializeDevice()
+    {
         if (!InitializePhysicalDevice())
         {
             std::cerr << "Faild to initialize physical device." << std::endl;
@@ -36,14 +59,14 @@ namespace Vultron
 
         if (!InitializeAllocator())
         {
-            std::cerr << "Faild to initialize instance." << std::endl;
+            std::cerr << "Faild to initialize allocator." << std::endl;
             return false;
         }
 
         return true;
     }
 
-    bool VulkanContext::InitializeInstance(const Window &window)
+    bool VulkanContext::InitializeInstance(const std::vector<const char *> &windowExtensions)
     {
         VkApplicationInfo appInfo{};
         appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -57,12 +80,13 @@ namespace Vultron
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
         createInfo.pApplicationInfo = &appInfo;
 
-        std::vector<const char *> windowExtensions = window.GetWindowExtensions();
         auto requiredExtensions = std::vector<const char *>(windowExtensions.size());
 
         std::copy(windowExtensions.begin(), windowExtensions.end(), requiredExtensions.begin());
 
-        if (c_validationLayersEnabled)
+        // Also enabled without validation so command buffers can be labeled
+        m_debugUtilsSupported = c_validationLayersEnabled || CheckInstanceExtensionSupport(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        if (m_debugUtilsSupported)
         {
             requiredExtensions.emplace_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         }
@@ -137,9 +161,10 @@ namespace Vultron
 
             bool allowed = families.IsComplete() && CheckDeviceExtensionSupport(device);
             allowed &= (deviceFeatures.samplerAnisotropy == VK_TRUE);
+            allowed &= (deviceFeatures12.timelineSemaphore == VK_TRUE);
 
             bool swapChainAdequate = false;
-            if (allowed)
+            if (allowed && !m_headless)
             {
                 VkUtil::SwapChainSupport swapChainSupport = VkUtil::QuerySwapChainSupport(device, m_surface);
                 swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -192,10 +217,15 @@ namespace Vultron
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+        timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+        timelineSemaphoreFeatures.pNext = nullptr;
+
         VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures{};
         bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
         bufferDeviceAddressFeatures.bufferDeviceAddress = VK_TRUE;
-        bufferDeviceAddressFeatures.pNext = nullptr;
+        bufferDeviceAddressFeatures.pNext = &timelineSemaphoreFeatures;
 
         VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
         descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
@@ -205,9 +235,54 @@ namespace Vultron
         descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
         descriptorIndexingFeatures.pNext = &bufferDeviceAddressFeatures;
 
+        std::vector<const char *> extensions = c_deviceExtensions;
+        if (!m_headless)
+        {
+            extensions.insert(extensions.end(), c_swapchainExtensions.begin(), c_swapchainExtensions.end());
+        }
+
+        // Present wait is optional, it is only used for frame pacing and latency measurements
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        presentIdFeatures.pNext = &presentWaitFeatures;
+
+        if (!m_headless && CheckDeviceExtensionSupport(m_physicalDevice, c_presentWaitExtensions))
+        {
+            VkPhysicalDeviceFeatures2 supportedFeatures{};
+            supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedFeatures.pNext = &presentIdFeatures;
+            vkGetPhysicalDeviceFeatures2(m_physicalDevice, &supportedFeatures);
+
+            m_presentWaitSupported = presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+        }
+
+        if (m_presentWaitSupported)
+        {
+            extensions.insert(extensions.end(), c_presentWaitExtensions.begin(), c_presentWaitExtensions.end());
+            presentWaitFeatures.pNext = descriptorIndexingFeatures.pNext;
+            descriptorIndexingFeatures.pNext = &presentIdFeatures;
+        }
+
+        // The memory budget is optional, it only makes the budgets VMA reports exact
+        m_memoryBudgetSupported = CheckDeviceExtensionSupport(m_physicalDevice, c_memoryBudgetExtensions);
+        if (m_memoryBudgetSupported)
+        {
+            extensions.insert(extensions.end(), c_memoryBudgetExtensions.begin(), c_memoryBudgetExtensions.end());
+        }
+
+        // Pipeline statistics are optional, they are only used for render stats
+        VkPhysicalDeviceFeatures supportedDeviceFeatures{};
+        vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedDeviceFeatures);
+        m_pipelineStatisticsSupported = supportedDeviceFeatures.pipelineStatisticsQuery == VK_TRUE;
+        m_inheritedQueriesSupported = supportedDeviceFeatures.inheritedQueries == VK_TRUE;
+
         VkPhysicalDeviceFeatures2 deviceFeatures2{};
         deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
         deviceFeatures2.features.samplerAnisotropy = VK_TRUE;
+        deviceFeatures2.features.pipelineStatisticsQuery = supportedDeviceFeatures.pipelineStatisticsQuery;
+        deviceFeatures2.features.inheritedQueries = supportedDeviceFeatures.inheritedQueries;
         deviceFeatures2.pNext = &descriptorIndexingFeatures;
 
         VkDeviceCreateInfo createInfo{};
@@ -217,8 +292,8 @@ namespace Vultron
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(c_deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = c_deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
 
         if (c_validationLayersEnabled)
         {
@@ -237,6 +312,19 @@ namespace Vultron
         vkGetDeviceQueue(m_device, families.graphicsFamily.value(), 0, &m_graphicsQueue);
         vkGetDeviceQueue(m_device, families.presentFamily.value(), 0, &m_presentQueue);
 
+        if (m_presentWaitSupported)
+        {
+            m_waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(m_device, "vkWaitForPresentKHR"));
+            m_presentWaitSupported = m_waitForPresent != nullptr;
+        }
+
+        if (m_debugUtilsSupported)
+        {
+            m_cmdBeginDebugLabel = reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(vkGetInstanceProcAddr(m_instance, "vkCmdBeginDebugUtilsLabelEXT"));
+            m_cmdEndDebugLabel = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(vkGetInstanceProcAddr(m_instance, "vkCmdEndDebugUtilsLabelEXT"));
+            m_debugUtilsSupported = m_cmdBeginDebugLabel != nullptr && m_cmdEndDebugLabel != nullptr;
+        }
+
         return true;
     }
 
@@ -246,7 +334,13 @@ namespace Vultron
         allocatorCreateInfo.physicalDevice = m_physicalDevice;
         allocatorCreateInfo.device = m_device;
         allocatorCreateInfo.instance = m_instance;
+        // Matches the instance, VMA needs at least 1.1 to query the budget through vkGetPhysicalDeviceMemoryProperties2
+        allocatorCreateInfo.vulkanApiVersion = VK_API_VERSION_1_3;
         allocatorCreateInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+        if (m_memoryBudgetSupported)
+        {
+            allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        }
 
         VK_CHECK(vmaCreateAllocator(&allocatorCreateInfo, &m_allocator));
 
@@ -254,6 +348,12 @@ namespace Vultron
     }
 
     bool VulkanContext::CheckDeviceExtensionSupport(VkPhysicalDevice device)
+    {
+        return CheckDeviceExtensionSupport(device, c_deviceExtensions) &&
+               (m_headless || CheckDeviceExtensionSupport(device, c_swapchainExtensions));
+    }
+
+    bool VulkanContext::CheckDeviceExtensionSupport(VkPhysicalDevice device, const std::vector<const char *> &requested)
     {
         uint32_t extensionCount = 0;
         vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -261,7 +361,7 @@ namespace Vultron
         std::vector<VkExtensionProperties> extensions(extensionCount);
         vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
 
-        std::set<std::string> requiredExtensions(c_deviceExtensions.begin(), c_deviceExtensions.end());
+        std::set<std::string> requiredExtensions(requested.begin(), requested.end());
 
         for (const auto &extension : extensions)
         {
@@ -271,6 +371,54 @@ namespace Vultron
         return requiredExtensions.empty();
     }
 
+    VkResult VulkanContext::WaitForPresent(VkSwapchainKHR swapchain, uint64_t presentId, uint64_t timeout) const
+    {
+        assert(m_presentWaitSupported && "Present wait is not supported.");
+        return m_waitForPresent(m_device, swapchain, presentId, timeout);
+    }
+
+    void VulkanContext::BeginDebugLabel(VkCommandBuffer commandBuffer, const char *name) const
+    {
+        if (!m_debugUtilsSupported)
+        {
+            return;
+        }
+
+        VkDebugUtilsLabelEXT label{};
+        label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+        label.pLabelName = name;
+        m_cmdBeginDebugLabel(commandBuffer, &label);
+    }
+
+    void VulkanContext::EndDebugLabel(VkCommandBuffer commandBuffer) const
+    {
+        if (!m_debugUtilsSupported)
+        {
+            return;
+        }
+
+        m_cmdEndDebugLabel(commandBuffer);
+    }
+
+    bool VulkanContext::CheckInstanceExtensionSupport(const char *extension)
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+        for (const auto &properties : extensions)
+        {
+            if (std::strcmp(properties.extensionName, extension) == 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     bool VulkanContext::CheckValidationLayerSupport()
     {
         uint32_t layerCount;
@@ -305,7 +453,10 @@ namespace Vultron
     {
         vmaDestroyAllocator(m_allocator);
         vkDestroyDevice(m_device, nullptr);
-        vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+        if (!m_headless)
+        {
+            vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+        }
         vkDestroyInstance(m_instance, nullptr);
     }
 }
\ No newline at end of file
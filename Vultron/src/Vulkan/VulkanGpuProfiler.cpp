@@ -0,0 +1,205 @@
+#include "Vultron/Vulkan/VulkanGpuProfiler.h"
+
+#include "Vultron/Vulkan/VulkanUtils.h"
+
+#include <cassert>
+
+namespace Vultron
+{
+    bool VulkanGpuProfiler::Initialize(const VulkanContext &context, uint32_t frameCount)
+    {
+        m_context = &context;
+        m_frames.resize(frameCount);
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(context.GetPhysicalDevice(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(context.GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+        const uint32_t validBits = queueFamilies[context.GetGraphicsQueueFamily()].timestampValidBits;
+        m_timestampsSupported = validBits > 0 && context.GetDeviceProperties().limits.timestampPeriod > 0.0f;
+        if (!m_timestampsSupported)
+        {
+            return true;
+        }
+
+        m_timestampPeriod = context.GetDeviceProperties().limits.timestampPeriod;
+        m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = c_maxGpuScopes * 2;
+
+        for (Frame &frame : m_frames)
+        {
+            VK_CHECK(vkCreateQueryPool(context.GetDevice(), &queryPoolInfo, nullptr, &frame.queryPool));
+            frame.scopes.reserve(c_maxGpuScopes);
+        }
+
+        m_timestamps.resize(c_maxGpuScopes * 2);
+        m_results.reserve(c_maxGpuScopes);
+
+        return true;
+    }
+
+    void VulkanGpuProfiler::Destroy(const VulkanContext &context)
+    {
+        for (Frame &frame : m_frames)
+        {
+            if (frame.queryPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(context.GetDevice(), frame.queryPool, nullptr);
+            }
+        }
+
+        m_frames.clear();
+        m_results.clear();
+        m_recordingFrame = nullptr;
+        m_context = nullptr;
+    }
+
+    void VulkanGpuProfiler::Resolve(const VulkanContext &context, uint64_t completedValue)
+    {
+        // Older finished frames are dropped, only the newest one is worth reading
+        Frame *newest = nullptr;
+        for (Frame &frame : m_frames)
+        {
+            if (frame.pending && frame.timelineValue <= completedValue)
+            {
+                frame.pending = false;
+                if (newest == nullptr || frame.timelineValue > newest->timelineValue)
+                {
+                    newest = &frame;
+                }
+            }
+        }
+
+        if (newest == nullptr || newest->scopes.empty())
+        {
+            return;
+        }
+
+        // The frame is finished, so every query it wrote is available
+        const uint32_t queryCount = static_cast<uint32_t>(newest->scopes.size()) * 2;
+        if (vkGetQueryPoolResults(context.GetDevice(), newest->queryPool, 0, queryCount, queryCount * sizeof(uint64_t), m_timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        {
+            return;
+        }
+
+        m_results.clear();
+        for (size_t i = 0; i < newest->scopes.size(); i++)
+        {
+            const Scope &scope = newest->scopes[i];
+            const uint64_t ticks = (m_timestamps[i * 2 + 1] - m_timestamps[i * 2]) & m_timestampMask;
+            m_results.push_back({
+                .name = scope.name,
+                .depth = scope.depth,
+                .index = scope.index,
+                .time = static_cast<float>(static_cast<double>(ticks) * m_timestampPeriod / 1'000'000.0),
+            });
+        }
+        m_resultFrame = newest->timelineValue;
+    }
+
+    void VulkanGpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t timelineValue)
+    {
+        assert(m_recordingFrame == nullptr && "Previous frame was not ended.");
+
+        m_recordingFrame = &m_frames[frameIndex];
+        m_recordingFrame->scopes.clear();
+        m_recordingFrame->timelineValue = timelineValue;
+        m_recordingFrame->pending = false;
+        m_scopeDepth = 0;
+
+        if (m_timestampsSupported)
+        {
+            vkCmdResetQueryPool(commandBuffer, m_recordingFrame->queryPool, 0, c_maxGpuScopes * 2);
+        }
+    }
+
+    void VulkanGpuProfiler::EndFrame()
+    {
+        assert(m_recordingFrame != nullptr && "No frame is being recorded.");
+        assert(m_scopeDepth == 0 && "Scopes were not ended.");
+
+        m_recordingFrame->pending = m_timestampsSupported;
+        m_recordingFrame = nullptr;
+    }
+
+    void VulkanGpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const char *name, uint32_t index)
+    {
+        assert(m_recordingFrame != nullptr && "No frame is being recorded.");
+        assert(m_scopeDepth < c_maxGpuScopeDepth && "Scopes are nested too deep.");
+
+        m_context->BeginDebugLabel(commandBuffer, name);
+
+        // Out of queries the scope is still labeled, it just is not timed
+        uint32_t scope = c_invalidGpuScope;
+        if (m_timestampsSupported && m_recordingFrame->scopes.size() < c_maxGpuScopes)
+        {
+            scope = static_cast<uint32_t>(m_recordingFrame->scopes.size());
+            m_recordingFrame->scopes.push_back({.name = name, .depth = m_scopeDepth, .index = index});
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_recordingFrame->queryPool, scope * 2);
+        }
+
+        m_scopeStack[m_scopeDepth++] = scope;
+    }
+
+    void VulkanGpuProfiler::EndScope(VkCommandBuffer commandBuffer)
+    {
+        assert(m_scopeDepth > 0 && "No scope to end.");
+
+        const uint32_t scope = m_scopeStack[--m_scopeDepth];
+        if (scope != c_invalidGpuScope)
+        {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_recordingFrame->queryPool, scope * 2 + 1);
+        }
+
+        m_context->EndDebugLabel(commandBuffer);
+    }
+
+    uint32_t VulkanGpuProfiler::ReserveScopes(const char *name, uint32_t count)
+    {
+        assert(m_recordingFrame != nullptr && "No frame is being recorded.");
+
+        if (!m_timestampsSupported || m_recordingFrame->scopes.size() + count > c_maxGpuScopes)
+        {
+            return c_invalidGpuScope;
+        }
+
+        const uint32_t first = static_cast<uint32_t>(m_recordingFrame->scopes.size());
+        for (uint32_t i = 0; i < count; i++)
+        {
+            m_recordingFrame->scopes.push_back({.name = name, .depth = m_scopeDepth, .index = i});
+        }
+
+        return first;
+    }
+
+    void VulkanGpuProfiler::BeginReservedScope(VkCommandBuffer commandBuffer, uint32_t scope, const char *label) const
+    {
+        m_context->BeginDebugLabel(commandBuffer, label);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_recordingFrame->queryPool, scope * 2);
+    }
+
+    void VulkanGpuProfiler::EndReservedScope(VkCommandBuffer commandBuffer, uint32_t scope) const
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_recordingFrame->queryPool, scope * 2 + 1);
+        m_context->EndDebugLabel(commandBuffer);
+    }
+
+    float VulkanGpuProfiler::GetFrameTime() const
+    {
+        float time = 0.0f;
+        for (const GpuScope &scope : m_results)
+        {
+            if (scope.depth == 0)
+            {
+                time += scope.time;
+            }
+        }
+
+        return time;
+    }
+}
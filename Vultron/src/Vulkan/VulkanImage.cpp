@@ -1,5 +1,6 @@
 #include "Vultron/Vulkan/VulkanImage.h"
 
+#include "Vultron/Core/Profiler.h"
 #include "Vultron/Vulkan/VulkanBuffer.h"
 #include "Vultron/Vulkan/VulkanBuffer.h"
 #include "Vultron/Vulkan/VulkanUtils.h"
@@ -39,6 +40,7 @@ namespace Vultron
         VmaAllocation allocation;
 
         VK_CHECK(vmaAllocateMemoryForImage(createInfo.allocator, image, &allocInfo, &allocation, nullptr));
+        TagAllocation(createInfo.allocator, allocation, createInfo.category);
 
         vmaBindImageMemory(createInfo.allocator, allocation, image);
 
@@ -66,9 +68,11 @@ namespace Vultron
         return MakePtr<VulkanImage>(VulkanImage::Create(createInfo));
     }
 
-    VulkanImage VulkanImage::CreateFromFile(const ImageFromFileCreateInfo &createInfo)
+    ImageFileData VulkanImage::ReadFile(const std::string &filepath)
     {
-        std::fstream file(createInfo.filepath, std::ios::in | std::ios::binary);
+        VLT_PROFILE_ZONE("VulkanImage::ReadFile");
+
+        std::fstream file(filepath, std::ios::in | std::ios::binary);
         assert(file.is_open() && "Failed to open file");
 
         struct Header
@@ -89,18 +93,36 @@ namespace Vultron
             uint32_t height;
         } mipLevelHeader;
 
-        std::vector<MipInfo> mips;
-        mips.reserve(header.numMipLevels);
-        for (uint32_t i = 0; i < header.numMipLevels; i++)
+        ImageFileData image;
+        image.numChannels = header.numChannels;
+        image.numBytesPerChannel = header.numBytesPerChannel;
+        image.mips.resize(header.numMipLevels);
+        for (ImageFileData::Mip &mip : image.mips)
         {
             file.read(reinterpret_cast<char *>(&mipLevelHeader), sizeof(mipLevelHeader));
-            uint8_t *data = new uint8_t[mipLevelHeader.width * mipLevelHeader.height * header.numChannels * header.numBytesPerChannel];
-            file.read(reinterpret_cast<char *>(data), mipLevelHeader.width * mipLevelHeader.height * header.numChannels * header.numBytesPerChannel);
-            mips.push_back({.width = mipLevelHeader.width, .height = mipLevelHeader.height, .depth = 1, .mipLevel = i, .data = data});
+            mip.width = mipLevelHeader.width;
+            mip.height = mipLevelHeader.height;
+            mip.data.resize(static_cast<size_t>(mipLevelHeader.width) * mipLevelHeader.height * header.numChannels * header.numBytesPerChannel);
+            file.read(reinterpret_cast<char *>(mip.data.data()), mip.data.size());
         }
 
         file.close();
 
+        return image;
+    }
+
+    VulkanImage VulkanImage::CreateFromFile(const ImageFromFileCreateInfo &createInfo)
+    {
+        ImageFileData imageFile = ReadFile(createInfo.filepath);
+
+        std::vector<MipInfo> mips;
+        mips.reserve(imageFile.mips.size());
+        for (uint32_t i = 0; i < imageFile.mips.size(); i++)
+        {
+            ImageFileData::Mip &mip = imageFile.mips[i];
+            mips.push_back({.width = mip.width, .height = mip.height, .depth = 1, .mipLevel = i, .data = mip.data.data()});
+        }
+
         VulkanImage image = VulkanImage::Create(
             {.device = createInfo.device,
              .commandPool = createInfo.commandPool,
@@ -115,16 +137,13 @@ namespace Vultron
 
         image.UploadData(createInfo.device, createInfo.allocator, createInfo.commandPool, createInfo.queue, mips);
 
-        for (const MipInfo &mip : mips)
-        {
-            delete[] reinterpret_cast<uint8_t *>(mip.data);
-        }
-
         return image;
     }
 
     void VulkanImage::UploadData(VkDevice device, VmaAllocator allocator, VkCommandPool commandPool, VkQueue queue, const std::vector<MipInfo> &mips)
     {
+        VLT_PROFILE_ZONE("VulkanImage::UploadData");
+
         uint32_t mipLevels = static_cast<uint32_t>(mips.size());
 
         VkUtil::TransitionImageLayout(
@@ -141,7 +160,7 @@ namespace Vultron
         {
             const MipInfo &mip = mips[i];
             const size_t imageSize = mip.width * mip.height * 4 * sizeof(uint8_t); // Doing it like this for now.
-            VulkanBuffer stagingBuffer = VulkanBuffer::Create({.allocator = allocator, .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT, .size = imageSize, .allocationUsage = VMA_MEMORY_USAGE_CPU_TO_GPU});
+            VulkanBuffer stagingBuffer = VulkanBuffer::Create({.allocator = allocator, .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT, .size = imageSize, .allocationUsage = VMA_MEMORY_USAGE_CPU_TO_GPU, .category = MemoryCategory::Staging});
             stagingBuffer.Write(allocator, mip.data, imageSize);
 
             VkUtil::CopyBufferToImage(
@@ -181,6 +200,7 @@ namespace Vultron
     void VulkanImage::Destroy(const VulkanContext &context)
     {
         vkDestroyImageView(context.GetDevice(), m_imageView, nullptr);
+        UntagAllocation(context.GetAllocator(), m_allocation);
         vmaDestroyImage(context.GetAllocator(), m_image, m_allocation);
     }
 }
\ No newline at end of file
@@ -19,8 +19,18 @@ namespace Vultron::VkInit
         VkResult res = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
         std::cout << "Descriptor set allocation result: " << res << std::endl;
 
+        UpdateDescriptorSet(device, descriptorSet, bindings);
+
+        return descriptorSet;
+    }
+
+    void UpdateDescriptorSet(VkDevice device, VkDescriptorSet descriptorSet, const std::vector<DescriptorSetBinding> &bindings)
+    {
         std::vector<VkWriteDescriptorSet> descriptorWrites = {};
         descriptorWrites.resize(bindings.size());
+        // The writes point into these, so they have to outlive the loop
+        std::vector<VkDescriptorBufferInfo> bufferInfos(bindings.size());
+        std::vector<VkDescriptorImageInfo> imageInfos(bindings.size());
         for (size_t i = 0; i < bindings.size(); i++)
         {
             const auto &binding = bindings[i];
@@ -35,7 +45,7 @@ namespace Vultron::VkInit
             {
             case DescriptorType::UniformBuffer:
             {
-                VkDescriptorBufferInfo bufferInfo = {};
+                VkDescriptorBufferInfo &bufferInfo = bufferInfos[i];
                 bufferInfo.buffer = binding.buffer;
                 bufferInfo.offset = 0;
                 bufferInfo.range = binding.size;
@@ -46,7 +56,7 @@ namespace Vultron::VkInit
             }
             case DescriptorType::StorageBuffer:
             {
-                VkDescriptorBufferInfo bufferInfo = {};
+                VkDescriptorBufferInfo &bufferInfo = bufferInfos[i];
                 bufferInfo.buffer = binding.buffer;
                 bufferInfo.offset = 0;
                 bufferInfo.range = binding.size;
@@ -57,7 +67,7 @@ namespace Vultron::VkInit
             }
             case DescriptorType::CombinedImageSampler:
             {
-                VkDescriptorImageInfo imageInfo = {};
+                VkDescriptorImageInfo &imageInfo = imageInfos[i];
                 imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
                 imageInfo.imageView = binding.imageView;
                 imageInfo.sampler = binding.sampler;
@@ -72,8 +82,6 @@ namespace Vultron::VkInit
         }
 
         vkUpdateDescriptorSets(device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-
-        return descriptorSet;
     }
 
     VkDescriptorSetLayout CreateDescriptorSetLayout(VkDevice device, const std::vector<DescriptorSetLayoutBinding> &bindingLayouts)
@@ -0,0 +1,263 @@
+#include "Vultron/Vulkan/VulkanMemory.h"
+
+#include "Vultron/Core/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace Vultron
+{
+    static std::array<std::atomic<uint64_t>, c_memoryCategoryCount> s_categoryBytes = {};
+    static std::array<std::atomic<uint32_t>, c_memoryCategoryCount> s_categoryAllocations = {};
+
+    const char *GetMemoryCategoryName(MemoryCategory category)
+    {
+        switch (category)
+        {
+        case MemoryCategory::Mesh:
+            return "Mesh";
+        case MemoryCategory::Texture:
+            return "Texture";
+        case MemoryCategory::RenderTarget:
+            return "RenderTarget";
+        case MemoryCategory::Instance:
+            return "Instance";
+        case MemoryCategory::Uniform:
+            return "Uniform";
+        case MemoryCategory::Staging:
+            return "Staging";
+        case MemoryCategory::Readback:
+            return "Readback";
+        default:
+            return "Other";
+        }
+    }
+
+    void TagAllocation(VmaAllocator allocator, VmaAllocation allocation, MemoryCategory category)
+    {
+        if (allocation == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        // Offset by one so allocations that were never tagged keep null user data
+        vmaSetAllocationUserData(allocator, allocation, reinterpret_cast<void *>(static_cast<uintptr_t>(category) + 1));
+        vmaSetAllocationName(allocator, allocation, GetMemoryCategoryName(category));
+
+        VmaAllocationInfo info;
+        vmaGetAllocationInfo(allocator, allocation, &info);
+
+        const size_t index = static_cast<size_t>(category);
+        s_categoryBytes[index].fetch_add(info.size, std::memory_order_relaxed);
+        s_categoryAllocations[index].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void UntagAllocation(VmaAllocator allocator, VmaAllocation allocation)
+    {
+        if (allocation == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        VmaAllocationInfo info;
+        vmaGetAllocationInfo(allocator, allocation, &info);
+        if (info.pUserData == nullptr)
+        {
+            return;
+        }
+
+        const size_t index = reinterpret_cast<uintptr_t>(info.pUserData) - 1;
+        s_categoryBytes[index].fetch_sub(info.size, std::memory_order_relaxed);
+        s_categoryAllocations[index].fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    bool VulkanMemoryBudget::Initialize(const VulkanContext &context)
+    {
+        m_allocator = context.GetAllocator();
+        m_budgetExtensionEnabled = context.IsMemoryBudgetSupported();
+
+        const VkPhysicalDeviceMemoryProperties *memoryProperties = nullptr;
+        vmaGetMemoryProperties(m_allocator, &memoryProperties);
+
+        m_budgets.resize(memoryProperties->memoryHeapCount);
+        m_heapPressure.assign(memoryProperties->memoryHeapCount, MemoryPressure::Normal);
+
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        m_stats = {};
+        m_stats.budgetExtensionEnabled = m_budgetExtensionEnabled;
+        m_stats.heaps.resize(memoryProperties->memoryHeapCount);
+        for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++)
+        {
+            m_stats.heaps[i].deviceLocal = (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        }
+
+        return true;
+    }
+
+    void VulkanMemoryBudget::Destroy()
+    {
+        m_allocator = VK_NULL_HANDLE;
+        m_budgets.clear();
+        m_heapPressure.clear();
+        m_callback = nullptr;
+        m_dumpInterval = 0;
+    }
+
+    MemoryPressure VulkanMemoryBudget::GetPressure(MemoryPressure current, uint64_t usage, uint64_t budget) const
+    {
+        if (budget == 0)
+        {
+            return MemoryPressure::Normal;
+        }
+
+        const double fraction = static_cast<double>(usage) / static_cast<double>(budget);
+        if (fraction > 1.0)
+        {
+            return MemoryPressure::OverBudget;
+        }
+
+        // A heap hovering around the threshold would otherwise report a change every few frames
+        const double threshold = current == MemoryPressure::Normal ? m_warningFraction : m_warningFraction - c_memoryPressureHysteresis;
+
+        return fraction >= threshold ? MemoryPressure::Warning : MemoryPressure::Normal;
+    }
+
+    void VulkanMemoryBudget::Update(uint64_t frameNumber)
+    {
+        VLT_PROFILE_ZONE("VulkanMemoryBudget::Update");
+
+        vmaSetCurrentFrameIndex(m_allocator, static_cast<uint32_t>(frameNumber));
+        vmaGetHeapBudgets(m_allocator, m_budgets.data());
+
+        const uint32_t heapCount = static_cast<uint32_t>(m_budgets.size());
+        std::array<MemoryPressure, VK_MAX_MEMORY_HEAPS> previousPressure;
+        {
+            std::lock_guard<std::mutex> lock(m_statsMutex);
+            m_stats.frameNumber = frameNumber;
+            m_stats.pressure = MemoryPressure::Normal;
+
+            for (uint32_t i = 0; i < heapCount; i++)
+            {
+                const VmaBudget &budget = m_budgets[i];
+                MemoryHeapStats &heap = m_stats.heaps[i];
+                heap.budget = budget.budget;
+                heap.usage = budget.usage;
+                heap.blockBytes = budget.statistics.blockBytes;
+                heap.allocationBytes = budget.statistics.allocationBytes;
+                heap.allocationCount = budget.statistics.allocationCount;
+
+                previousPressure[i] = m_heapPressure[i];
+                m_heapPressure[i] = GetPressure(m_heapPressure[i], budget.usage, budget.budget);
+                if (heap.deviceLocal)
+                {
+                    m_stats.pressure = std::max(m_stats.pressure, m_heapPressure[i]);
+                }
+            }
+
+            for (size_t i = 0; i < c_memoryCategoryCount; i++)
+            {
+                m_stats.categories[i].bytes = s_categoryBytes[i].load(std::memory_order_relaxed);
+                m_stats.categories[i].allocations = s_categoryAllocations[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        // Outside of the lock, the callback may read the stats
+        if (m_callback)
+        {
+            for (uint32_t i = 0; i < heapCount; i++)
+            {
+                if (m_heapPressure[i] != previousPressure[i])
+                {
+                    m_callback({
+                        .heapIndex = i,
+                        .pressure = m_heapPressure[i],
+                        .previousPressure = previousPressure[i],
+                        .usage = m_budgets[i].usage,
+                        .budget = m_budgets[i].budget,
+                        .deviceLocal = m_stats.heaps[i].deviceLocal,
+                    });
+                }
+            }
+        }
+
+        if (m_dumpInterval > 0 && frameNumber % m_dumpInterval == 0)
+        {
+            WriteStats(m_dumpDirectory + "/memory_" + std::to_string(frameNumber) + ".json", false);
+        }
+    }
+
+    MemoryStats VulkanMemoryBudget::GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        return m_stats;
+    }
+
+    void VulkanMemoryBudget::SetBudgetCallback(MemoryBudgetCallback callback, float warningFraction)
+    {
+        m_callback = std::move(callback);
+        m_warningFraction = std::clamp(warningFraction, 0.0f, 1.0f);
+    }
+
+    void VulkanMemoryBudget::SetDumpInterval(const std::string &directory, uint32_t frames)
+    {
+        m_dumpDirectory = directory;
+        m_dumpInterval = frames;
+        if (frames > 0)
+        {
+            std::filesystem::create_directories(directory);
+        }
+    }
+
+    bool VulkanMemoryBudget::WriteStats(const std::string &filepath, bool detailed) const
+    {
+        if (m_allocator == VK_NULL_HANDLE)
+        {
+            return false;
+        }
+
+        const MemoryStats stats = GetStats();
+
+        std::ofstream file(filepath);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to open " << filepath << std::endl;
+            return false;
+        }
+
+        file << "{\n";
+        file << "  \"frame\": " << stats.frameNumber << ",\n";
+        file << "  \"budgetExtension\": " << (stats.budgetExtensionEnabled ? "true" : "false") << ",\n";
+        file << "  \"heaps\": [";
+        for (size_t i = 0; i < stats.heaps.size(); i++)
+        {
+            const MemoryHeapStats &heap = stats.heaps[i];
+            file << (i == 0 ? "\n" : ",\n");
+            file << "    {\"index\": " << i << ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false")
+                 << ", \"budget\": " << heap.budget << ", \"usage\": " << heap.usage
+                 << ", \"blockBytes\": " << heap.blockBytes << ", \"allocationBytes\": " << heap.allocationBytes
+                 << ", \"allocations\": " << heap.allocationCount << "}";
+        }
+        file << "\n  ],\n";
+        file << "  \"categories\": {";
+        for (size_t i = 0; i < c_memoryCategoryCount; i++)
+        {
+            file << (i == 0 ? "\n" : ",\n");
+            file << "    \"" << GetMemoryCategoryName(static_cast<MemoryCategory>(i)) << "\": {\"bytes\": " << stats.categories[i].bytes
+                 << ", \"allocations\": " << stats.categories[i].allocations << "}";
+        }
+        file << "\n  },\n";
+
+        // Already JSON, embedded as is
+        char *vmaStats = nullptr;
+        vmaBuildStatsString(m_allocator, &vmaStats, detailed ? VK_TRUE : VK_FALSE);
+        file << "  \"vma\": " << vmaStats << "\n";
+        vmaFreeStatsString(m_allocator, vmaStats);
+
+        file << "}" << std::endl;
+
+        return true;
+    }
+}
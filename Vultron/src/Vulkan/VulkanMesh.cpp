@@ -1,4 +1,5 @@
 #include "Vultron/Vulkan/VulkanMesh.h"
+#include "Vultron/Core/Profiler.h"
 #include "Vultron/Vulkan/VulkanUtils.h"
 
 #include "vk_mem_alloc.h"
@@ -11,12 +12,14 @@ namespace Vultron
 {
     VulkanMesh VulkanMesh::Create(const MeshCreateInfo &createInfo)
     {
+        VLT_PROFILE_ZONE("VulkanMesh::Create");
+
         const size_t verticesSize = sizeof(createInfo.vertices[0]) * createInfo.vertices.size();
-        auto vertexBuffer = VulkanBuffer::Create({.allocator = createInfo.allocator, .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, .size = verticesSize});
+        auto vertexBuffer = VulkanBuffer::Create({.allocator = createInfo.allocator, .usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, .size = verticesSize, .category = MemoryCategory::Mesh});
         vertexBuffer.UploadStaged(createInfo.device, createInfo.commandPool, createInfo.queue, createInfo.allocator, createInfo.vertices.data(), verticesSize, VMA_MEMORY_USAGE_GPU_ONLY);
 
         const size_t indiciesSize = sizeof(createInfo.indices[0]) * createInfo.indices.size();
-        auto indexBuffer = VulkanBuffer::Create({.allocator = createInfo.allocator, .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, .size = indiciesSize, .allocationUsage = VMA_MEMORY_USAGE_GPU_ONLY});
+        auto indexBuffer = VulkanBuffer::Create({.allocator = createInfo.allocator, .usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, .size = indiciesSize, .allocationUsage = VMA_MEMORY_USAGE_GPU_ONLY, .category = MemoryCategory::Mesh});
         indexBuffer.UploadStaged(createInfo.device, createInfo.commandPool, createInfo.queue, createInfo.allocator, createInfo.indices.data(), indiciesSize);
 
         return VulkanMesh(vertexBuffer, indexBuffer);
@@ -27,12 +30,11 @@ namespace Vultron
         return MakePtr<VulkanMesh>(Create(createInfo));
     }
 
-    VulkanMesh VulkanMesh::CreateFromFile(const MeshFromFilesCreateInfo &createInfo)
+    void VulkanMesh::ReadFile(const std::string &filepath, std::vector<StaticMeshVertex> &vertices, std::vector<uint32_t> &indices)
     {
-        std::vector<StaticMeshVertex> vertices;
-        std::vector<uint32_t> indices;
+        VLT_PROFILE_ZONE("VulkanMesh::ReadFile");
 
-        std::ifstream file(createInfo.filepath, std::ios::ate | std::ios::binary);
+        std::ifstream file(filepath, std::ios::ate | std::ios::binary);
 
         assert(file.is_open() && "Failed to open file");
 
@@ -52,8 +54,15 @@ namespace Vultron
         file.read(reinterpret_cast<char *>(indices.data()), indices.size() * sizeof(uint32_t));
 
         file.close();
+    }
+
+    VulkanMesh VulkanMesh::CreateFromFile(const MeshFromFilesCreateInfo &createInfo)
+    {
+        std::vector<StaticMeshVertex> vertices;
+        std::vector<uint32_t> indices;
+        ReadFile(createInfo.filepath, vertices, indices);
 
-        std::cout << "Loaded mesh with " << vertexCount << " vertices and " << indexCount << " indices" << std::endl;
+        std::cout << "Loaded mesh with " << vertices.size() << " vertices and " << indices.size() << " indices" << std::endl;
 
         return VulkanMesh::Create({.device = createInfo.device, .commandPool = createInfo.commandPool, .queue = createInfo.queue, .allocator = createInfo.allocator, .vertices = vertices, .indices = indices});
     }
@@ -0,0 +1,149 @@
+#include "Vultron/Vulkan/VulkanPipelineCache.h"
+
+#include "Vultron/Vulkan/VulkanUtils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Vultron
+{
+    static bool WriteFileDurably(const std::filesystem::path &path, const void *data, size_t size)
+    {
+        FILE *file = std::fopen(path.string().c_str(), "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        bool written = std::fwrite(data, 1, size, file) == size && std::fflush(file) == 0;
+#if defined(_WIN32)
+        written = written && _commit(_fileno(file)) == 0;
+#else
+        written = written && fsync(fileno(file)) == 0;
+#endif
+
+        return std::fclose(file) == 0 && written;
+    }
+
+    VulkanPipelineCache VulkanPipelineCache::Create(const VulkanContext &context, const PipelineCacheCreateInfo &createInfo)
+    {
+        std::vector<char> data;
+        bool warm = ReadCacheFile(createInfo.filepath, data) && ValidateHeader(context, data);
+        if (!warm)
+        {
+            data.clear();
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        VkPipelineCache pipelineCache;
+        VK_CHECK(vkCreatePipelineCache(context.GetDevice(), &cacheInfo, nullptr, &pipelineCache));
+
+        std::cout << (warm ? "Loaded pipeline cache " : "Starting with a cold pipeline cache ") << createInfo.filepath << std::endl;
+
+        return VulkanPipelineCache(pipelineCache, createInfo.filepath, warm);
+    }
+
+    bool VulkanPipelineCache::ReadCacheFile(const std::string &filepath, std::vector<char> &data)
+    {
+        std::ifstream file(filepath, std::ios::ate | std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        data.resize(fileSize);
+        file.seekg(0);
+        file.read(data.data(), fileSize);
+
+        return file.good();
+    }
+
+    bool VulkanPipelineCache::ValidateHeader(const VulkanContext &context, const std::vector<char> &data)
+    {
+        if (data.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+        {
+            return false;
+        }
+
+        VkPipelineCacheHeaderVersionOne header;
+        std::memcpy(&header, data.data(), sizeof(header));
+
+        const VkPhysicalDeviceProperties properties = context.GetDeviceProperties();
+
+        if (header.headerSize < sizeof(VkPipelineCacheHeaderVersionOne) || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+        {
+            std::cerr << "Pipeline cache has an unknown header version, discarding." << std::endl;
+            return false;
+        }
+
+        if (header.vendorID != properties.vendorID || header.deviceID != properties.deviceID)
+        {
+            std::cerr << "Pipeline cache was created on another device, discarding." << std::endl;
+            return false;
+        }
+
+        if (std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        {
+            std::cerr << "Pipeline cache UUID mismatch (driver changed), discarding." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool VulkanPipelineCache::Save(const VulkanContext &context) const
+    {
+        size_t dataSize = 0;
+        VK_CHECK(vkGetPipelineCacheData(context.GetDevice(), m_pipelineCache, &dataSize, nullptr));
+
+        std::vector<char> data(dataSize);
+        VK_CHECK(vkGetPipelineCacheData(context.GetDevice(), m_pipelineCache, &dataSize, data.data()));
+
+        const std::filesystem::path path(m_filepath);
+        const std::filesystem::path tempPath = path.string() + ".tmp";
+
+        std::error_code error;
+        if (path.has_parent_path())
+        {
+            std::filesystem::create_directories(path.parent_path(), error);
+        }
+
+        // Flushed to disk before the rename, otherwise a crash right after it can leave a truncated file under the real name
+        if (!WriteFileDurably(tempPath, data.data(), dataSize))
+        {
+            std::cerr << "Failed to write pipeline cache to " << tempPath.string() << "." << std::endl;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        // Rename is atomic, so a crash mid-write never leaves a truncated cache behind.
+        std::filesystem::rename(tempPath, path, error);
+        if (error)
+        {
+            std::cerr << "Failed to replace pipeline cache: " << error.message() << std::endl;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    void VulkanPipelineCache::Destroy(const VulkanContext &context)
+    {
+        vkDestroyPipelineCache(context.GetDevice(), m_pipelineCache, nullptr);
+    }
+}
@@ -0,0 +1,331 @@
+#include "Vultron/Vulkan/VulkanPipelineManager.h"
+
+#include "Vultron/Core/Hash.h"
+#include "Vultron/Vulkan/VulkanMesh.h"
+#include "Vultron/Vulkan/VulkanUtils.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+namespace Vultron
+{
+    uint64_t ShaderVariant::GetHash() const
+    {
+        return HashBytes(values.data(), values.size() * sizeof(uint32_t));
+    }
+
+    std::array<VkSpecializationMapEntry, ShaderVariant::c_constantCount> ShaderVariant::GetMapEntries()
+    {
+        std::array<VkSpecializationMapEntry, c_constantCount> entries = {};
+        for (uint32_t i = 0; i < c_constantCount; i++)
+        {
+            entries[i].constantID = i;
+            entries[i].offset = i * sizeof(uint32_t);
+            entries[i].size = sizeof(uint32_t);
+        }
+
+        return entries;
+    }
+
+    uint64_t PipelineDescription::GetHash() const
+    {
+        // Hash field by field so that padding never affects the result
+        uint64_t hash = c_hashOffsetBasis;
+        hash = HashValue(vertexShaderHash, hash);
+        hash = HashValue(fragmentShaderHash, hash);
+        hash = HashValue(state.vertexLayout, hash);
+        hash = HashValue(state.cullMode, hash);
+        hash = HashValue(state.frontFace, hash);
+        hash = HashValue(state.depthTest, hash);
+        hash = HashValue(state.depthWrite, hash);
+        hash = HashValue(state.depthCompareOp, hash);
+        hash = HashValue(state.blendMode, hash);
+        hash = HashValue(variant.GetHash(), hash);
+
+        return hash;
+    }
+
+    bool VulkanPipelineManager::Initialize(const VulkanContext &context, VkPipelineCache pipelineCache, uint32_t workerCount)
+    {
+        m_device = context.GetDevice();
+        m_pipelineCache = pipelineCache;
+        m_running = true;
+
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            m_workers.emplace_back(&VulkanPipelineManager::WorkerLoop, this);
+        }
+
+        return true;
+    }
+
+    void VulkanPipelineManager::Destroy(const VulkanContext &context)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+            m_queue.clear();
+        }
+        m_workAvailable.notify_all();
+
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+        m_workers.clear();
+
+        for (auto &[description, pipeline] : m_pipelines)
+        {
+            vkDestroyPipeline(context.GetDevice(), pipeline, nullptr);
+        }
+
+        m_pipelines.clear();
+        m_pending.clear();
+    }
+
+    VkPipeline VulkanPipelineManager::GetPipeline(const PipelineDescription &description)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (auto it = m_pipelines.find(description); it != m_pipelines.end())
+        {
+            return it->second;
+        }
+
+        if (m_pending.contains(description))
+        {
+            auto queued = std::find(m_queue.begin(), m_queue.end(), description);
+
+            if (queued == m_queue.end())
+            {
+                // A worker is already compiling it
+                m_pipelineReady.wait(lock, [this, &description]()
+                                     { return m_pipelines.contains(description); });
+                return m_pipelines.at(description);
+            }
+
+            // Still waiting in the queue, compile it here instead
+            m_queue.erase(queued);
+        }
+
+        m_pending.insert(description);
+        lock.unlock();
+
+        VkPipeline pipeline = CreateGraphicsPipeline(m_device, m_pipelineCache, description);
+
+        lock.lock();
+        m_pipelines[description] = pipeline;
+        m_pending.erase(description);
+        lock.unlock();
+        m_pipelineReady.notify_all();
+
+        return pipeline;
+    }
+
+    VkPipeline VulkanPipelineManager::RequestPipeline(const PipelineDescription &description)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (auto it = m_pipelines.find(description); it != m_pipelines.end())
+            {
+                return it->second;
+            }
+
+            if (m_pending.contains(description))
+            {
+                return VK_NULL_HANDLE;
+            }
+
+            m_pending.insert(description);
+            m_queue.push_back(description);
+        }
+        m_workAvailable.notify_one();
+
+        return VK_NULL_HANDLE;
+    }
+
+    size_t VulkanPipelineManager::GetPipelineCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pipelines.size();
+    }
+
+    size_t VulkanPipelineManager::GetPendingCount()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pending.size();
+    }
+
+    void VulkanPipelineManager::WorkerLoop()
+    {
+        while (true)
+        {
+            PipelineDescription description;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_workAvailable.wait(lock, [this]()
+                                     { return !m_running || !m_queue.empty(); });
+
+                if (!m_running)
+                {
+                    return;
+                }
+
+                description = m_queue.front();
+                m_queue.pop_front();
+            }
+
+            VkPipeline pipeline = CreateGraphicsPipeline(m_device, m_pipelineCache, description);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_pipelines[description] = pipeline;
+                m_pending.erase(description);
+            }
+            m_pipelineReady.notify_all();
+        }
+    }
+
+    VkPipeline VulkanPipelineManager::CreateGraphicsPipeline(VkDevice device, VkPipelineCache pipelineCache, const PipelineDescription &description)
+    {
+        const PipelineState &state = description.state;
+
+        // Constants a stage does not declare are ignored, so both stages share one block
+        const auto specializationEntries = ShaderVariant::GetMapEntries();
+        VkSpecializationInfo specializationInfo{};
+        specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+        specializationInfo.pMapEntries = specializationEntries.data();
+        specializationInfo.dataSize = description.variant.values.size() * sizeof(uint32_t);
+        specializationInfo.pData = description.variant.values.data();
+
+        VkPipelineShaderStageCreateInfo shaderStages[] = {
+            {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_VERTEX_BIT,
+                .module = description.vertexShader,
+                .pName = "main",
+                .pSpecializationInfo = &specializationInfo,
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+                .module = description.fragmentShader,
+                .pName = "main",
+                .pSpecializationInfo = &specializationInfo,
+            }};
+
+        VkVertexInputBindingDescription vertexBindingDesc{};
+        std::array<VkVertexInputAttributeDescription, 3> vertexAttributeDescs{};
+        switch (state.vertexLayout)
+        {
+        case VertexLayout::StaticMesh:
+            vertexBindingDesc = StaticMeshVertex::GetBindingDescription();
+            vertexAttributeDescs = StaticMeshVertex::GetAttributeDescriptions();
+            break;
+        }
+
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        vertexInputInfo.vertexBindingDescriptionCount = 1;
+        vertexInputInfo.pVertexBindingDescriptions = &vertexBindingDesc;
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributeDescs.size());
+        vertexInputInfo.pVertexAttributeDescriptions = vertexAttributeDescs.data();
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+        const std::array<VkDynamicState, 2> dynamicStates = {
+            VK_DYNAMIC_STATE_VIEWPORT,
+            VK_DYNAMIC_STATE_SCISSOR};
+
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+        dynamicState.pDynamicStates = dynamicStates.data();
+
+        VkPipelineViewportStateCreateInfo viewportState{};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.depthClampEnable = VK_FALSE;
+        rasterizer.rasterizerDiscardEnable = VK_FALSE;
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.cullMode = state.cullMode;
+        rasterizer.frontFace = state.frontFace;
+        rasterizer.depthBiasEnable = VK_FALSE;
+
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.sampleShadingEnable = VK_FALSE;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        switch (state.blendMode)
+        {
+        case BlendMode::Opaque:
+            colorBlendAttachment.blendEnable = VK_FALSE;
+            break;
+        case BlendMode::AlphaBlend:
+            colorBlendAttachment.blendEnable = VK_TRUE;
+            colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+            break;
+        case BlendMode::Additive:
+            colorBlendAttachment.blendEnable = VK_TRUE;
+            colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+            colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+            break;
+        }
+
+        VkPipelineColorBlendStateCreateInfo colorBlending{};
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.logicOpEnable = VK_FALSE;
+        colorBlending.logicOp = VK_LOGIC_OP_COPY;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &colorBlendAttachment;
+
+        VkPipelineDepthStencilStateCreateInfo depthStencil{};
+        depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+        depthStencil.depthTestEnable = state.depthTest ? VK_TRUE : VK_FALSE;
+        depthStencil.depthWriteEnable = state.depthWrite ? VK_TRUE : VK_FALSE;
+        depthStencil.depthCompareOp = state.depthCompareOp;
+        depthStencil.depthBoundsTestEnable = VK_FALSE;
+        depthStencil.stencilTestEnable = VK_FALSE;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = shaderStages;
+        pipelineInfo.pVertexInputState = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDepthStencilState = &depthStencil;
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.layout = description.layout;
+        pipelineInfo.renderPass = description.renderPass;
+        pipelineInfo.subpass = 0;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VK_CHECK(vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &pipeline));
+
+        return pipeline;
+    }
+}
@@ -0,0 +1,121 @@
+#include "Vultron/Vulkan/VulkanPipelineStatistics.h"
+
+#include "Vultron/Vulkan/VulkanUtils.h"
+
+#include <array>
+#include <cassert>
+
+namespace Vultron
+{
+    bool VulkanPipelineStatistics::Initialize(const VulkanContext &context, uint32_t frameCount)
+    {
+        m_supported = context.IsPipelineStatisticsSupported();
+        m_inheritedQueriesSupported = context.IsInheritedQueriesSupported();
+        m_frames.resize(frameCount);
+        if (!m_supported)
+        {
+            return true;
+        }
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        queryPoolInfo.queryCount = 1;
+        queryPoolInfo.pipelineStatistics = c_pipelineStatisticFlags;
+
+        for (Frame &frame : m_frames)
+        {
+            VK_CHECK(vkCreateQueryPool(context.GetDevice(), &queryPoolInfo, nullptr, &frame.queryPool));
+        }
+
+        return true;
+    }
+
+    void VulkanPipelineStatistics::Destroy(const VulkanContext &context)
+    {
+        for (Frame &frame : m_frames)
+        {
+            if (frame.queryPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(context.GetDevice(), frame.queryPool, nullptr);
+            }
+        }
+
+        m_frames.clear();
+        m_recordingFrame = nullptr;
+        m_supported = false;
+        m_skipped = false;
+    }
+
+    void VulkanPipelineStatistics::Resolve(const VulkanContext &context, uint64_t completedValue)
+    {
+        Frame *newest = nullptr;
+        for (Frame &frame : m_frames)
+        {
+            if (frame.pending && frame.timelineValue <= completedValue)
+            {
+                frame.pending = false;
+                if (newest == nullptr || frame.timelineValue > newest->timelineValue)
+                {
+                    newest = &frame;
+                }
+            }
+        }
+
+        if (newest == nullptr)
+        {
+            return;
+        }
+
+        std::array<uint64_t, 5> values{};
+        if (vkGetQueryPoolResults(context.GetDevice(), newest->queryPool, 0, 1, sizeof(values), values.data(), sizeof(values), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        {
+            return;
+        }
+
+        m_results = {
+            .frameNumber = newest->timelineValue,
+            .inputAssemblyPrimitives = values[0],
+            .vertexShaderInvocations = values[1],
+            .clippingInvocations = values[2],
+            .clippingPrimitives = values[3],
+            .fragmentShaderInvocations = values[4],
+        };
+    }
+
+    void VulkanPipelineStatistics::Begin(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t timelineValue, bool secondaryCommandBuffers)
+    {
+        if (!m_supported)
+        {
+            return;
+        }
+
+        assert(m_recordingFrame == nullptr && "Previous query was not ended.");
+
+        // Executing secondary command buffers inside an active query needs the inheritedQueries feature
+        m_skipped = secondaryCommandBuffers && !m_inheritedQueriesSupported;
+        if (m_skipped)
+        {
+            return;
+        }
+
+        m_recordingFrame = &m_frames[frameIndex];
+        m_recordingFrame->timelineValue = timelineValue;
+        m_recordingFrame->pending = false;
+
+        vkCmdResetQueryPool(commandBuffer, m_recordingFrame->queryPool, 0, 1);
+        vkCmdBeginQuery(commandBuffer, m_recordingFrame->queryPool, 0, 0);
+    }
+
+    void VulkanPipelineStatistics::End(VkCommandBuffer commandBuffer)
+    {
+        if (m_recordingFrame == nullptr)
+        {
+            return;
+        }
+
+        vkCmdEndQuery(commandBuffer, m_recordingFrame->queryPool, 0);
+        m_recordingFrame->pending = true;
+        m_recordingFrame = nullptr;
+    }
+}
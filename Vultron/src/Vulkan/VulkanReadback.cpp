@@ -0,0 +1,116 @@
+#include "Vultron/Vulkan/VulkanReadback.h"
+
+#include "Vultron/Vulkan/VulkanUtils.h"
+
+#include <cassert>
+
+namespace Vultron
+{
+    bool VulkanReadback::Initialize(const VulkanContext &context, JobSystem &jobSystem, uint32_t width, uint32_t height, VkFormat format, ReadbackCallback callback)
+    {
+        m_jobSystem = &jobSystem;
+        m_callback = std::move(callback);
+        m_width = width;
+        m_height = height;
+        m_format = format;
+        m_frameSize = static_cast<size_t>(width) * height * 4;
+        m_nextSlot = 0;
+
+        // GPU_TO_CPU prefers host cached memory, reading uncached memory from the CPU is very slow
+        for (auto &slot : m_slots)
+        {
+            slot.buffer = VulkanBuffer::Create({.allocator = context.GetAllocator(), .usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT, .size = m_frameSize, .allocationUsage = VMA_MEMORY_USAGE_GPU_TO_CPU, .category = MemoryCategory::Readback});
+            slot.buffer.Map(context.GetAllocator());
+            slot.copyPending = false;
+        }
+
+        return true;
+    }
+
+    void VulkanReadback::Destroy(const VulkanContext &context)
+    {
+        if (!IsInitialized())
+        {
+            return;
+        }
+
+        for (auto &slot : m_slots)
+        {
+            assert(!slot.copyPending && "Readback copy was never polled.");
+            m_jobSystem->Wait(slot.callbackCounter);
+
+            slot.buffer.Unmap(context.GetAllocator());
+            slot.buffer.Destroy(context.GetAllocator());
+        }
+
+        m_jobSystem = nullptr;
+        m_callback = nullptr;
+    }
+
+    void VulkanReadback::Dispatch(const VulkanContext &context, Slot &slot)
+    {
+        slot.copyPending = false;
+
+        // No-op for coherent memory
+        vmaInvalidateAllocation(context.GetAllocator(), slot.buffer.GetAllocation(), 0, VK_WHOLE_SIZE);
+
+        // The callback reads the mapped buffer directly, the slot is not reused until it returns
+        const ReadbackFrame frame = {
+            .frameNumber = slot.timelineValue,
+            .width = m_width,
+            .height = m_height,
+            .format = m_format,
+            .data = slot.buffer.GetMapped<const uint8_t>(),
+            .size = m_frameSize,
+        };
+        m_jobSystem->RunBackground([this, frame]()
+                                   { m_callback(frame); },
+                                   slot.callbackCounter);
+    }
+
+    void VulkanReadback::Poll(const VulkanContext &context, uint64_t completedValue)
+    {
+        // Slots are filled in order, so they finish in order
+        for (uint32_t i = 0; i < c_readbackRingSize; i++)
+        {
+            Slot &slot = m_slots[(m_nextSlot + i) % c_readbackRingSize];
+            if (slot.copyPending && slot.timelineValue <= completedValue)
+            {
+                Dispatch(context, slot);
+            }
+        }
+    }
+
+    void VulkanReadback::RecordCopy(VkCommandBuffer commandBuffer, VkImage image, uint64_t timelineValue)
+    {
+        Slot &slot = m_slots[m_nextSlot];
+        m_nextSlot = (m_nextSlot + 1) % c_readbackRingSize;
+
+        // The ring is larger than the frames in flight, so the GPU is always done with the slot by now
+        assert(!slot.copyPending && "Readback slot is still being written by the GPU.");
+        assert(slot.callbackCounter.IsDone() && "Readback slot is still held by its callback.");
+
+        // The render pass' outgoing dependency orders the copy after the color writes
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {m_width, m_height, 1};
+        vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer.GetBuffer(), 1, &region);
+
+        // Make the copy visible to the host once the frame timeline is signaled
+        VkMemoryBarrier hostBarrier{};
+        hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+        slot.timelineValue = timelineValue;
+        slot.copyPending = true;
+    }
+}
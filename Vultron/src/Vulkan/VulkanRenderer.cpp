@@ -1,5 +1,6 @@
 #include "Vultron/Vulkan/VulkanRenderer.h"
 
+#include "Vultron/Core/Profiler.h"
 #include "Vultron/Vulkan/VulkanUtils.h"
 #include "Vultron/Vulkan/VulkanInitializers.h"
 #include "Vultron/Vulkan/Debug.h"
@@ -10,19 +11,24 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <limits>
 #include <vector>
 #include <set>
+#include <thread>
 #include <string>
 #include <random>
 
 namespace Vultron
 {
-    bool VulkanRenderer::Initialize(const Window &window)
+    bool VulkanRenderer::Initialize(const Window &window, JobSystem &jobSystem)
     {
+        m_jobSystem = &jobSystem;
+
         if (!m_context.Initialize(window))
         {
             std::cerr << "Faild to initialize context." << std::endl;
@@ -36,29 +42,76 @@ namespace Vultron
         }
 
         const auto [width, height] = window.GetExtent();
-        if (!m_swapchain.Initialize(m_context, width, height))
+        m_requestedExtent = {width, height};
+        if (!m_swapchain.Initialize(m_context, width, height, m_presentPolicy))
         {
             std::cerr << "Faild to initialize swap chain." << std::endl;
             return false;
         }
 
+        return InitializeResources();
+    }
+
+    bool VulkanRenderer::InitializeHeadless(uint32_t width, uint32_t height, JobSystem &jobSystem)
+    {
+        m_jobSystem = &jobSystem;
+
+        if (!m_context.InitializeHeadless())
+        {
+            std::cerr << "Faild to initialize context." << std::endl;
+            return false;
+        }
+
+        if (c_validationLayersEnabled && !InitializeDebugMessenger())
+        {
+            std::cerr << "Faild to initialize debug messages." << std::endl;
+            return false;
+        }
+
+        m_requestedExtent = {width, height};
+        if (!InitializeOffscreenTarget())
+        {
+            std::cerr << "Faild to initialize offscreen target." << std::endl;
+            return false;
+        }
+
+        return InitializeResources();
+    }
+
+    bool VulkanRenderer::InitializeResources()
+    {
         if (!InitializeRenderPass())
         {
             std::cerr << "Faild to initialize render pass." << std::endl;
             return false;
         }
 
+        if (!InitializePipelineCache())
+        {
+            std::cerr << "Faild to initialize pipeline cache." << std::endl;
+            return false;
+        }
+
+        if (!InitializePipelineManager())
+        {
+            std::cerr << "Faild to initialize pipeline manager." << std::endl;
+            return false;
+        }
+
         if (!InitializeDescriptorSetLayout())
         {
             std::cerr << "Faild to initialize descriptor set layout." << std::endl;
             return false;
         }
 
+        const auto pipelineStartTime = std::chrono::high_resolution_clock::now();
         if (!InitializeGraphicsPipeline())
         {
             std::cerr << "Faild to initialize graphics pipeline." << std::endl;
             return false;
         }
+        const float pipelineTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - pipelineStartTime).count();
+        std::cout << "Created graphics pipelines in " << pipelineTime << " ms (" << (m_pipelineCache.IsWarm() ? "warm" : "cold") << " pipeline cache)." << std::endl;
 
         if (!InitializeCommandPool())
         {
@@ -136,7 +189,9 @@ namespace Vultron
             {.attachments = {
                  // Color attachment
                  {
-                     .format = m_swapchain.GetImageFormat(),
+                     .format = GetTargetFormat(),
+                     // Offscreen images are left ready to be copied out
+                     .finalLayout = m_context.IsHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
                  },
                  // Depth attachment
                  {
@@ -153,6 +208,18 @@ namespace Vultron
         return true;
     }
 
+    bool VulkanRenderer::InitializePipelineCache()
+    {
+        m_pipelineCache = VulkanPipelineCache::Create(m_context, {.filepath = std::string(VLT_CACHE_DIR) + "/pipeline_cache.bin"});
+
+        return true;
+    }
+
+    bool VulkanRenderer::InitializePipelineManager()
+    {
+        return m_pipelineManager.Initialize(m_context, m_pipelineCache.GetPipelineCache());
+    }
+
     bool VulkanRenderer::InitializeDescriptorSetLayout()
     {
         m_descriptorSetLayout = VkInit::CreateDescriptorSetLayout(
@@ -175,12 +242,24 @@ namespace Vultron
 
     bool VulkanRenderer::InitializeGraphicsPipeline()
     {
-        // Shader
-        m_vertexShader = VulkanShader::CreateFromFile({.device = m_context.GetDevice(), .filepath = std::string(VLT_ASSETS_DIR) + "/shaders/triangle.vert.spv"});
-        m_fragmentShader = VulkanShader::CreateFromFile({.device = m_context.GetDevice(), .filepath = std::string(VLT_ASSETS_DIR) + "/shaders/triangle.frag.spv"});
+        // Shader, prefer the packed bundle and fall back to loose .spv files
+        const std::string shaderDir = VLT_SHADER_DIR;
+        const bool useBundle = m_shaderBundle.Initialize(m_context, {.filepath = shaderDir + "/shaders.bundle"}) &&
+                               m_shaderBundle.Contains("triangle.vert") && m_shaderBundle.Contains("triangle.frag");
+        if (useBundle)
+        {
+            m_vertexShader = m_shaderBundle.GetShader("triangle.vert");
+            m_fragmentShader = m_shaderBundle.GetShader("triangle.frag");
+        }
+        else
+        {
+            m_shaderBundle.Destroy(m_context);
+            m_vertexShader = VulkanShader::CreateFromFile({.device = m_context.GetDevice(), .filepath = shaderDir + "/triangle.vert.spv"});
+            m_fragmentShader = VulkanShader::CreateFromFile({.device = m_context.GetDevice(), .filepath = shaderDir + "/triangle.frag.spv"});
+        }
 
         m_materialPipeline = VulkanMaterialPipeline::Create(
-            m_context, m_swapchain, m_renderPass,
+            m_context, m_renderPass, m_pipelineManager,
             {
                 .vertexShader = m_vertexShader,
                 .fragmentShader = m_fragmentShader,
@@ -191,14 +270,56 @@ namespace Vultron
                         .type = DescriptorType::CombinedImageSampler,
                         .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
                     },
+                    {
+                        .binding = 1,
+                        .type = DescriptorType::CombinedImageSampler,
+                        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                    },
                 },
             });
 
         return true;
     }
 
+    bool VulkanRenderer::InitializeOffscreenTarget()
+    {
+        m_colorImage = VulkanImage::Create(
+            {.device = m_context.GetDevice(),
+             .allocator = m_context.GetAllocator(),
+             .info = {
+                 .width = m_requestedExtent.width,
+                 .height = m_requestedExtent.height,
+                 .depth = 1,
+                 .format = c_offscreenColorFormat,
+             },
+             .additionalUsageFlags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+             .category = MemoryCategory::RenderTarget});
+
+        return true;
+    }
+
     bool VulkanRenderer::InitializeFramebuffers()
     {
+        if (m_context.IsHeadless())
+        {
+            std::array<VkImageView, 2> attachments = {
+                m_colorImage.GetImageView(),
+                m_depthImage.GetImageView()};
+
+            VkFramebufferCreateInfo framebufferInfo{};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = m_renderPass.GetRenderPass();
+            framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+            framebufferInfo.pAttachments = attachments.data();
+            framebufferInfo.width = m_requestedExtent.width;
+            framebufferInfo.height = m_requestedExtent.height;
+            framebufferInfo.layers = 1;
+
+            VK_CHECK(vkCreateFramebuffer(m_context.GetDevice(), &framebufferInfo, nullptr, &m_offscreenFramebuffer));
+
+            return true;
+        }
+
         std::vector<VkFramebuffer> &framebuffers = m_swapchain.GetFramebuffers();
         const std::vector<VkImageView> &imageViews = m_swapchain.GetImageViews();
         framebuffers.resize(imageViews.size());
@@ -240,7 +361,9 @@ namespace Vultron
 
     bool VulkanRenderer::InitializeCommandBuffer()
     {
-        for (size_t i = 0; i < c_frameOverlap; i++)
+        VkUtil::QueueFamilies families = VkUtil::QueryQueueFamilies(m_context.GetPhysicalDevice(), m_context.GetSurface());
+
+        for (size_t i = 0; i < c_maxFramesInFlight; i++)
         {
             VkCommandBufferAllocateInfo allocInfo{};
             allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -249,6 +372,25 @@ namespace Vultron
             allocInfo.commandBufferCount = 1;
 
             VK_CHECK(vkAllocateCommandBuffers(m_context.GetDevice(), &allocInfo, &m_frames[i].commandBuffer));
+
+            // Secondary command buffers for parallel recording, the pools are reset as a whole every frame
+            for (uint32_t thread = 0; thread < c_maxRecordingThreads; thread++)
+            {
+                VkCommandPoolCreateInfo poolInfo{};
+                poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+                poolInfo.queueFamilyIndex = families.graphicsFamily.value();
+                poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+                VK_CHECK(vkCreateCommandPool(m_context.GetDevice(), &poolInfo, nullptr, &m_frames[i].recordingPools[thread]));
+
+                VkCommandBufferAllocateInfo secondaryAllocInfo{};
+                secondaryAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                secondaryAllocInfo.commandPool = m_frames[i].recordingPools[thread];
+                secondaryAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                secondaryAllocInfo.commandBufferCount = 1;
+
+                VK_CHECK(vkAllocateCommandBuffers(m_context.GetDevice(), &secondaryAllocInfo, &m_frames[i].secondaryCommandBuffers[thread]));
+            }
         }
 
         return true;
@@ -256,19 +398,43 @@ namespace Vultron
 
     bool VulkanRenderer::InitializeSyncObjects()
     {
-        for (size_t i = 0; i < c_frameOverlap; i++)
+        for (size_t i = 0; i < c_maxFramesInFlight; i++)
         {
             VkSemaphoreCreateInfo semaphoreInfo{};
             semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
             VK_CHECK(vkCreateSemaphore(m_context.GetDevice(), &semaphoreInfo, nullptr, &m_frames[i].imageAvailableSemaphore));
             VK_CHECK(vkCreateSemaphore(m_context.GetDevice(), &semaphoreInfo, nullptr, &m_frames[i].renderFinishedSemaphore));
+        }
+
+        // Acquire and present still need binary semaphores, frame pacing uses the timeline
+        VkSemaphoreTypeCreateInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timelineInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &timelineInfo;
 
-            VkFenceCreateInfo fenceInfo{};
-            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-            fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        VK_CHECK(vkCreateSemaphore(m_context.GetDevice(), &semaphoreInfo, nullptr, &m_frameTimeline));
 
-            VK_CHECK(vkCreateFence(m_context.GetDevice(), &fenceInfo, nullptr, &m_frames[i].inFlightFence));
+        if (!m_gpuProfiler.Initialize(m_context, c_maxFramesInFlight))
+        {
+            std::cerr << "Faild to initialize GPU profiler." << std::endl;
+            return false;
+        }
+
+        if (!m_pipelineStatistics.Initialize(m_context, c_maxFramesInFlight))
+        {
+            std::cerr << "Faild to initialize pipeline statistics." << std::endl;
+            return false;
+        }
+
+        if (!m_memoryBudget.Initialize(m_context))
+        {
+            std::cerr << "Faild to initialize memory budget." << std::endl;
+            return false;
         }
 
         return true;
@@ -309,15 +475,17 @@ namespace Vultron
              .queue = m_context.GetGraphicsQueue(),
              .allocator = m_context.GetAllocator(),
              .info = {
-                 .width = m_swapchain.GetExtent().width,
-                 .height = m_swapchain.GetExtent().height,
+                 .width = GetTargetExtent().width,
+                 .height = GetTargetExtent().height,
                  .depth = 1,
                  .format = depthFormat,
              },
              .aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT,
-             .additionalUsageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT});
+             .additionalUsageFlags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+             .category = MemoryCategory::RenderTarget});
 
-        m_depthImage.TransitionLayout(m_context.GetDevice(), m_commandPool, m_context.GetGraphicsQueue(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+        // No layout transition needed, the render pass clears the depth attachment from an undefined layout
+        m_depthExtent = GetTargetExtent();
 
         return true;
     }
@@ -326,28 +494,19 @@ namespace Vultron
     {
         size_t size = sizeof(UniformBufferData);
 
-        for (size_t i = 0; i < c_frameOverlap; i++)
+        for (size_t i = 0; i < c_maxFramesInFlight; i++)
         {
             VulkanBuffer &uniformBuffer = m_frames[i].uniformBuffer;
-            uniformBuffer = VulkanBuffer::Create({.allocator = m_context.GetAllocator(), .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, .size = size, .allocationUsage = VMA_MEMORY_USAGE_CPU_TO_GPU});
+            uniformBuffer = VulkanBuffer::Create({.allocator = m_context.GetAllocator(), .usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, .size = size, .allocationUsage = VMA_MEMORY_USAGE_CPU_TO_GPU, .category = MemoryCategory::Uniform});
             uniformBuffer.Map(m_context.GetAllocator());
         }
 
-        m_uniformBufferData.lightDir = glm::vec3(0.0f, 0.0f, 1.0f);
-        m_uniformBufferData.proj = glm::perspective(glm::radians(45.0f), (float)m_swapchain.GetExtent().width / (float)m_swapchain.GetExtent().height, 0.1f, 10000.0f);
-        m_uniformBufferData.proj[1][1] *= -1;
         return true;
     }
 
     bool VulkanRenderer::InitializeInstanceBuffer()
     {
-        constexpr size_t size = sizeof(InstanceData) * c_maxInstances;
-        for (size_t i = 0; i < c_frameOverlap; i++)
-        {
-            VulkanBuffer &instanceBuffer = m_frames[i].instanceBuffer;
-            instanceBuffer = VulkanBuffer::Create({.allocator = m_context.GetAllocator(), .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, .size = size, .allocationUsage = VMA_MEMORY_USAGE_CPU_TO_GPU});
-            instanceBuffer.Map(m_context.GetAllocator());
-        }
+        ReserveInstances(c_initialInstanceCapacity);
 
         return true;
     }
@@ -374,7 +533,7 @@ namespace Vultron
 
     bool VulkanRenderer::InitializeDescriptorSets()
     {
-        for (size_t i = 0; i < c_frameOverlap; i++)
+        for (size_t i = 0; i < c_maxFramesInFlight; i++)
         {
             std::vector<DescriptorSetBinding> bindings = {
                 {
@@ -386,12 +545,13 @@ namespace Vultron
                 {
                     .binding = 1,
                     .type = DescriptorType::StorageBuffer,
-                    .buffer = m_frames[i].instanceBuffer.GetBuffer(),
-                    .size = m_frames[i].instanceBuffer.GetSize(),
+                    .buffer = m_instanceBuffer.GetBuffer(),
+                    .size = m_instanceBuffer.GetSize(),
                 },
             };
 
             m_frames[i].descriptorSet = VkInit::CreateDescriptorSet(m_context.GetDevice(), m_descriptorPool, m_descriptorSetLayout, bindings);
+            m_frames[i].boundInstanceBuffer = m_instanceBuffer.GetBuffer();
         }
 
         return true;
@@ -414,42 +574,165 @@ namespace Vultron
         return true;
     }
 
-    void VulkanRenderer::RecreateSwapchain(uint32_t width, uint32_t height)
+    bool VulkanRenderer::RecreateSwapchain()
+    {
+        VLT_PROFILE_ZONE("VulkanRenderer::RecreateSwapchain");
+
+        if (m_requestedExtent.width == 0 || m_requestedExtent.height == 0)
+        {
+            return false;
+        }
+
+        // Build the new swapchain from the old one so presentation continues, no device wait needed
+        VulkanSwapchain swapchain;
+        if (!swapchain.Initialize(m_context, m_requestedExtent.width, m_requestedExtent.height, m_presentPolicy, m_swapchain.GetSwapchain()))
+        {
+            return false;
+        }
+
+        // The retired swapchain and its framebuffers may still be used by frames in flight
+        m_deletionQueue.Push(m_frameNumber, [this, oldSwapchain = m_swapchain]() mutable
+                             { oldSwapchain.Destroy(m_context); });
+        m_swapchain = swapchain;
+
+        const VkExtent2D extent = m_swapchain.GetExtent();
+        if (extent.width != m_depthExtent.width || extent.height != m_depthExtent.height)
+        {
+            m_deletionQueue.Push(m_frameNumber, [this, oldDepthImage = m_depthImage]() mutable
+                                 { oldDepthImage.Destroy(m_context); });
+            InitializeDepthBuffer();
+        }
+
+        InitializeFramebuffers();
+
+        // Present ids start over on the new swapchain
+        m_lastPresentId = 0;
+        m_swapchainDirty = false;
+        m_resizeRecreated = m_resizePending;
+
+        return true;
+    }
+
+    void VulkanRenderer::Resize(uint32_t width, uint32_t height)
+    {
+        if (m_context.IsHeadless() || (width == m_requestedExtent.width && height == m_requestedExtent.height))
+        {
+            return;
+        }
+
+        m_requestedExtent = {width, height};
+        m_swapchainDirty = true;
+
+        if (!m_resizePending)
+        {
+            m_resizePending = true;
+            m_resizeStartTime = std::chrono::high_resolution_clock::now();
+        }
+    }
+
+    bool VulkanRenderer::SetReadbackCallback(ReadbackCallback callback)
+    {
+        if (!m_context.IsHeadless())
+        {
+            std::cerr << "Frame readback needs a headless renderer." << std::endl;
+            return false;
+        }
+
+        // Frames already submitted still go to the previous callback
+        if (m_readback.IsInitialized())
+        {
+            VkSemaphoreWaitInfo waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &m_frameTimeline;
+            waitInfo.pValues = &m_frameNumber;
+            VK_CHECK(vkWaitSemaphores(m_context.GetDevice(), &waitInfo, (std::numeric_limits<uint64_t>::max)()));
+
+            m_readback.Poll(m_context, m_frameNumber);
+            m_readback.Destroy(m_context);
+        }
+
+        if (!callback)
+        {
+            return true;
+        }
+
+        return m_readback.Initialize(m_context, *m_jobSystem, m_requestedExtent.width, m_requestedExtent.height, c_offscreenColorFormat, std::move(callback));
+    }
+
+    void VulkanRenderer::SetPresentPolicy(PresentPolicy policy)
     {
-        // vkDeviceWaitIdle(m_context.GetDevice());
+        if (policy != m_presentPolicy)
+        {
+            m_presentPolicy = policy;
+            m_swapchainDirty = !m_context.IsHeadless();
+        }
+    }
 
-        // for (auto framebuffer : m_swapchain.GetFramebuffers())
-        // {
-        //     vkDestroyFramebuffer(m_context.GetDevice(), framebuffer, nullptr);
-        // }
+    void VulkanRenderer::PaceFrame()
+    {
+        VLT_PROFILE_ZONE("VulkanRenderer::PaceFrame");
 
-        // for (const auto &frame : m_frames)
-        // {
-        //     vkFreeCommandBuffers(m_context.GetDevice(), m_commandPool, 1, &frame.commandBuffer);
-        // }
+        if (m_presentWaitEnabled && m_context.IsPresentWaitSupported() && m_lastPresentId > 0)
+        {
+            // Keeps at most one frame queued for presentation, which also gives the real display time
+            const VkResult result = m_context.WaitForPresent(m_swapchain.GetSwapchain(), m_lastPresentId, c_presentWaitTimeout);
+            if (result == VK_SUCCESS)
+            {
+                const auto inputTime = m_inputTimes[m_lastPresentId % c_latencyHistory];
+                m_latency = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - inputTime).count();
+            }
+        }
 
-        // vkDestroyPipeline(m_context.GetDevice(), m_graphicsPipeline, nullptr);
-        // vkDestroyPipelineLayout(m_context.GetDevice(), m_pipelineLayout, nullptr);
-        // vkDestroyRenderPass(m_context.GetDevice(), m_renderPass.GetRenderPass(), nullptr);
+        if (m_frameRateLimit > 0.0f)
+        {
+            const auto period = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(std::chrono::duration<float>(1.0f / m_frameRateLimit));
+            auto now = std::chrono::high_resolution_clock::now();
+            if (now < m_nextFrameTime)
+            {
+                std::this_thread::sleep_until(m_nextFrameTime);
+                now = m_nextFrameTime;
+            }
+            m_nextFrameTime = now + period;
+        }
+    }
 
-        // for (auto imageView : m_swapChainImageViews)
-        // {
-        //     vkDestroyImageView(m_context.GetDevice(), imageView, nullptr);
-        // }
+    VkPipeline VulkanRenderer::ResolvePipeline(VulkanMaterialInstance &material)
+    {
+        if (material.GetPipeline() != VK_NULL_HANDLE)
+        {
+            return material.GetPipeline();
+        }
+
+        VkPipeline pipeline = m_pipelineManager.RequestPipeline(material.GetPipelineDescription());
+        if (pipeline != VK_NULL_HANDLE)
+        {
+            material.SetPipeline(pipeline);
+            return pipeline;
+        }
 
-        // vkDestroySwapchainKHR(m_context.GetDevice(), m_swapChain, nullptr);
+        return m_pipelineFallback == PipelineFallback::Default ? m_materialPipeline.GetPipeline() : VK_NULL_HANDLE;
+    }
 
-        // InitializeSwapChain(width, height);
-        // InitializeImageViews();
-        // InitializeRenderPass();
-        // InitializeGraphicsPipeline();
-        // InitializeFramebuffers();
-        // InitializeCommandBuffer();
+    void VulkanRenderer::PrepareBatches(const std::vector<RenderBatch> &batches)
+    {
+        // Resolve pipelines up front, material instances must not be modified by the recording threads
+        m_batchPipelines.resize(batches.size());
+        for (size_t i = 0; i < batches.size(); i++)
+        {
+            m_batchPipelines[i] = ResolvePipeline(m_resourcePool.GetMaterialInstance(batches[i].material));
+        }
     }
 
-    void VulkanRenderer::WriteCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<RenderBatch> &batches)
+    void VulkanRenderer::WriteCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex, const std::vector<RenderBatch> &batches, bool copyReadback)
     {
+        VLT_PROFILE_ZONE("Record");
+
         const FrameData &frame = m_frames[m_currentFrameIndex];
+        const auto recordStartTime = std::chrono::high_resolution_clock::now();
+
+        const uint32_t threadCount = static_cast<uint32_t>(std::min<size_t>(m_recordingThreadCount, batches.size()));
+        const bool parallel = threadCount > 1;
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -458,13 +741,23 @@ namespace Vultron
 
         VK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
 
+        m_gpuProfiler.BeginFrame(commandBuffer, m_currentFrameIndex, m_frameNumber);
+        m_gpuProfiler.BeginScope(commandBuffer, "Frame");
+
+        if (!m_instanceCopies.empty())
+        {
+            m_gpuProfiler.BeginScope(commandBuffer, "Instance upload");
+            RecordInstanceCopies(commandBuffer, frame);
+            m_gpuProfiler.EndScope(commandBuffer);
+        }
+
         VkRenderPassBeginInfo renderPassInfo{};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
         renderPassInfo.renderPass = m_renderPass.GetRenderPass();
-        renderPassInfo.framebuffer = m_swapchain.GetFramebuffers()[imageIndex];
+        renderPassInfo.framebuffer = m_context.IsHeadless() ? m_offscreenFramebuffer : m_swapchain.GetFramebuffers()[imageIndex];
 
         renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = m_swapchain.GetExtent();
+        renderPassInfo.renderArea.extent = GetTargetExtent();
 
         std::array<VkClearValue, 2> clearValues{};
         clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
@@ -473,83 +766,448 @@ namespace Vultron
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        m_gpuProfiler.BeginScope(commandBuffer, "Render pass");
+        m_pipelineStatistics.Begin(commandBuffer, m_currentFrameIndex, m_frameNumber, parallel);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+
+        // Batch scopes are reserved up front so the recording threads write them without locking
+        const uint32_t firstBatchScope = m_gpuBatchScopesEnabled ? m_gpuProfiler.ReserveScopes("Batch", static_cast<uint32_t>(batches.size())) : c_invalidGpuScope;
+
+        if (!parallel)
+        {
+            RecordBatches(commandBuffer, frame, batches.data(), m_batchPipelines.data(), batches.size(), firstBatchScope, m_stats);
+        }
+        else
+        {
+            VkCommandBufferInheritanceInfo inheritanceInfo{};
+            inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+            inheritanceInfo.renderPass = m_renderPass.GetRenderPass();
+            inheritanceInfo.subpass = 0;
+            inheritanceInfo.framebuffer = renderPassInfo.framebuffer;
+            inheritanceInfo.pipelineStatistics = m_pipelineStatistics.IsRecording() ? c_pipelineStatisticFlags : 0;
+
+            // Contiguous ranges keep the draw order identical to the serial path
+            m_jobSystem->ParallelFor(threadCount, 1, [&](uint32_t firstThread, uint32_t lastThread)
+                                     {
+                for (uint32_t thread = firstThread; thread < lastThread; thread++)
+                {
+                    VLT_PROFILE_ZONE("Record batches");
+                    const size_t first = batches.size() * thread / threadCount;
+                    const size_t last = batches.size() * (thread + 1) / threadCount;
+                    VkCommandBuffer secondaryCommandBuffer = frame.secondaryCommandBuffers[thread];
+
+                    VK_CHECK(vkResetCommandPool(m_context.GetDevice(), frame.recordingPools[thread], 0));
 
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_materialPipeline.GetPipeline());
+                    VkCommandBufferBeginInfo secondaryBeginInfo{};
+                    secondaryBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                    secondaryBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+                    secondaryBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+                    VK_CHECK(vkBeginCommandBuffer(secondaryCommandBuffer, &secondaryBeginInfo));
+                    const uint32_t firstScope = firstBatchScope != c_invalidGpuScope ? firstBatchScope + static_cast<uint32_t>(first) : c_invalidGpuScope;
+                    m_threadStats[thread] = {};
+                    RecordBatches(secondaryCommandBuffer, frame, batches.data() + first, m_batchPipelines.data() + first, last - first, firstScope, m_threadStats[thread]);
+                    VK_CHECK(vkEndCommandBuffer(secondaryCommandBuffer));
+                } });
+
+            vkCmdExecuteCommands(commandBuffer, threadCount, frame.secondaryCommandBuffers.data());
+
+            for (uint32_t thread = 0; thread < threadCount; thread++)
+            {
+                m_stats += m_threadStats[thread];
+            }
+        }
+
+        vkCmdEndRenderPass(commandBuffer);
+        m_pipelineStatistics.End(commandBuffer);
+        m_gpuProfiler.EndScope(commandBuffer);
+
+        if (copyReadback)
+        {
+            m_gpuProfiler.BeginScope(commandBuffer, "Readback copy");
+            m_readback.RecordCopy(commandBuffer, m_colorImage.GetImage(), m_frameNumber);
+            m_gpuProfiler.EndScope(commandBuffer);
+        }
+
+        m_gpuProfiler.EndScope(commandBuffer);
+        m_gpuProfiler.EndFrame();
+
+        VK_CHECK(vkEndCommandBuffer(commandBuffer));
+
+        m_recordingTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - recordStartTime).count();
+    }
+
+    void VulkanRenderer::RecordBatches(VkCommandBuffer commandBuffer, const FrameData &frame, const RenderBatch *batches, const VkPipeline *pipelines, size_t count, uint32_t firstScope,
+                                       RenderStats &stats) const
+    {
+        // Counted locally and added once, so threads only touch their own slot at the end
+        RenderStats counts = {};
 
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
-        viewport.width = (float)m_swapchain.GetExtent().width;
-        viewport.height = (float)m_swapchain.GetExtent().height;
+        viewport.width = (float)GetTargetExtent().width;
+        viewport.height = (float)GetTargetExtent().height;
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
         VkRect2D scissor{};
         scissor.offset = {0, 0};
-        scissor.extent = m_swapchain.GetExtent();
+        scissor.extent = GetTargetExtent();
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
         VkDescriptorSet descriptorSets[] = {frame.descriptorSet};
         vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_materialPipeline.GetPipelineLayout(), 0, 1, descriptorSets, 0, nullptr);
+        counts.descriptorBinds++;
 
-        for (const auto &batch : batches)
+        VkPipeline boundPipeline = VK_NULL_HANDLE;
+        for (size_t i = 0; i < count; i++)
         {
-            const VulkanMesh &mesh = m_resourcePool.GetMesh(batch.mesh);
+            const RenderBatch &batch = batches[i];
+            VkPipeline pipeline = pipelines[i];
+
+            // Skipped batches still write their timestamps, every reserved query has to be available
+            const uint32_t scope = firstScope != c_invalidGpuScope ? firstScope + static_cast<uint32_t>(i) : c_invalidGpuScope;
+            if (scope != c_invalidGpuScope)
+            {
+                char label[64];
+                std::snprintf(label, sizeof(label), "Batch mesh %llu material %llu", static_cast<unsigned long long>(batch.mesh), static_cast<unsigned long long>(batch.material));
+                m_gpuProfiler.BeginReservedScope(commandBuffer, scope, label);
+            }
+
+            if (pipeline == VK_NULL_HANDLE)
+            {
+                if (scope != c_invalidGpuScope)
+                {
+                    m_gpuProfiler.EndReservedScope(commandBuffer, scope);
+                }
+                counts.skippedBatches++;
+                continue;
+            }
+
+            if (pipeline != boundPipeline)
+            {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                boundPipeline = pipeline;
+                counts.pipelineBinds++;
+            }
+
             const VulkanMaterialInstance &material = m_resourcePool.GetMaterialInstance(batch.material);
+            const VulkanMesh &mesh = m_resourcePool.GetMesh(batch.mesh);
 
             VkBuffer vertexBuffers[] = {mesh.GetVertexBuffer()};
             VkDeviceSize offsets[] = {0};
             vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
             vkCmdBindIndexBuffer(commandBuffer, mesh.GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
-            VkDescriptorSet descriptorSets[] = {material.GetDescriptorSet()};
-            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_materialPipeline.GetPipelineLayout(), 1, 1, descriptorSets, 0, nullptr);
+            VkDescriptorSet materialDescriptorSets[] = {material.GetDescriptorSet()};
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_materialPipeline.GetPipelineLayout(), 1, 1, materialDescriptorSets, 0, nullptr);
+            counts.descriptorBinds++;
+
+            const DrawPushConstants drawConstants = {
+                .baseInstance = batch.firstInstance,
+                .materialIndex = static_cast<uint32_t>(batch.material),
+                .lod = batch.parameters.lod,
+                .flags = batch.parameters.flags,
+            };
+            m_materialPipeline.PushConstants(commandBuffer, drawConstants);
 
             vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(mesh.GetIndexCount()), batch.instanceCount, 0, 0, batch.firstInstance);
+            counts.drawCalls++;
+            counts.instances += batch.instanceCount;
+            counts.triangles += mesh.GetIndexCount() / 3 * batch.instanceCount;
+
+            if (scope != c_invalidGpuScope)
+            {
+                m_gpuProfiler.EndReservedScope(commandBuffer, scope);
+            }
         }
 
-        vkCmdEndRenderPass(commandBuffer);
+        stats += counts;
+    }
 
-        VK_CHECK(vkEndCommandBuffer(commandBuffer));
+    void VulkanRenderer::MarkInstancesDirty(const std::vector<InstanceRange> &dirtyInstances)
+    {
+        for (const InstanceRange &range : dirtyInstances)
+        {
+            if (range.instanceCount == 0)
+            {
+                continue;
+            }
+
+            const uint32_t firstPage = range.firstInstance / c_instancePageSize;
+            const uint32_t lastPage = (range.firstInstance + range.instanceCount - 1) / c_instancePageSize;
+            if (m_dirtyInstancePages.size() <= lastPage / 64)
+            {
+                m_dirtyInstancePages.resize(lastPage / 64 + 1, 0);
+            }
+
+            for (uint32_t page = firstPage; page <= lastPage; page++)
+            {
+                m_dirtyInstancePages[page / 64] |= 1ull << (page % 64);
+            }
+        }
     }
 
-    void VulkanRenderer::Draw(const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances)
+    void VulkanRenderer::ReserveInstances(size_t instanceCount)
     {
-        constexpr uint32_t timeout = (std::numeric_limits<uint32_t>::max)();
-        const uint32_t currentFrame = m_currentFrameIndex;
-        const FrameData &frame = m_frames[currentFrame];
+        if (instanceCount <= m_instanceCapacity)
+        {
+            return;
+        }
 
-        vkWaitForFences(m_context.GetDevice(), 1, &frame.inFlightFence, VK_TRUE, timeout);
-        vkResetFences(m_context.GetDevice(), 1, &frame.inFlightFence);
+        size_t capacity = std::max(m_instanceCapacity * 2, c_initialInstanceCapacity);
+        while (capacity < instanceCount)
+        {
+            capacity *= 2;
+        }
 
-        uint32_t imageIndex;
-        VK_CHECK(vkAcquireNextImageKHR(m_context.GetDevice(), m_swapchain.GetSwapchain(), timeout, frame.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex));
-        vkResetCommandBuffer(frame.commandBuffer, 0);
-        WriteCommandBuffer(frame.commandBuffer, imageIndex, batches);
+        if (m_instanceBuffer.GetBuffer() != VK_NULL_HANDLE)
+        {
+            m_deletionQueue.Push(m_frameNumber, [this, oldInstanceBuffer = m_instanceBuffer]() mutable
+                                 { oldInstanceBuffer.Destroy(m_context.GetAllocator()); });
+            std::cout << "Instance buffer grown to " << capacity << " instances" << std::endl;
+        }
+
+        m_instanceBuffer = VulkanBuffer::Create({.allocator = m_context.GetAllocator(),
+                                                 .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                                 .size = sizeof(InstanceData) * capacity,
+                                                 .allocationUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+                                                 .category = MemoryCategory::Instance});
+        m_instanceCapacity = capacity;
+
+        // Nothing is in the new buffer yet, everything is staged again from the frontend's instances
+        const size_t pageCount = (capacity + c_instancePageSize - 1) / c_instancePageSize;
+        m_dirtyInstancePages.assign((pageCount + 63) / 64, ~0ull);
+    }
+
+    size_t VulkanRenderer::StageInstances(FrameData &frame, const std::vector<glm::mat4> &instances)
+    {
+        VLT_PROFILE_ZONE("Stage instances");
+
+        // Runs of dirty pages become one copy each, packed one after another in the staging buffer
+        m_instanceCopies.clear();
+        size_t stagedSize = 0;
+
+        // Pages past the instances of this frame stay dirty until they are used
+        const size_t pageCount = (instances.size() + c_instancePageSize - 1) / c_instancePageSize;
+        for (size_t page = 0; page < pageCount; page++)
+        {
+            uint64_t &bits = m_dirtyInstancePages[page / 64];
+            const uint64_t bit = 1ull << (page % 64);
+            if ((bits & bit) == 0)
+            {
+                continue;
+            }
+            bits &= ~bit;
+
+            const size_t first = page * c_instancePageSize;
+            const size_t size = sizeof(InstanceData) * (std::min(first + c_instancePageSize, instances.size()) - first);
+            const VkDeviceSize offset = sizeof(InstanceData) * first;
+            if (!m_instanceCopies.empty() && m_instanceCopies.back().dstOffset + m_instanceCopies.back().size == offset)
+            {
+                m_instanceCopies.back().size += size;
+            }
+            else
+            {
+                m_instanceCopies.push_back({.srcOffset = stagedSize, .dstOffset = offset, .size = size});
+            }
+            stagedSize += size;
+        }
+
+        if (stagedSize == 0)
+        {
+            return 0;
+        }
+
+        // The GPU is done with this frame's staging buffer, so it can be replaced right away
+        VulkanBuffer &stagingBuffer = frame.instanceStagingBuffer;
+        if (stagingBuffer.GetSize() < stagedSize)
+        {
+            if (stagingBuffer.GetBuffer() != VK_NULL_HANDLE)
+            {
+                stagingBuffer.Unmap(m_context.GetAllocator());
+                stagingBuffer.Destroy(m_context.GetAllocator());
+            }
+
+            stagingBuffer = VulkanBuffer::Create({.allocator = m_context.GetAllocator(),
+                                                  .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                  .size = std::bit_ceil(stagedSize),
+                                                  .allocationUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+                                                  .category = MemoryCategory::Staging});
+            stagingBuffer.Map(m_context.GetAllocator());
+        }
+
+        const uint8_t *source = reinterpret_cast<const uint8_t *>(instances.data());
+        for (const VkBufferCopy &copy : m_instanceCopies)
+        {
+            stagingBuffer.CopyData(source + copy.dstOffset, copy.size, copy.srcOffset);
+        }
+
+        return stagedSize;
+    }
+
+    void VulkanRenderer::RecordInstanceCopies(VkCommandBuffer commandBuffer, const FrameData &frame) const
+    {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = m_instanceBuffer.GetBuffer();
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+
+        // Earlier frames still in flight may read or copy the instances that are overwritten here
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+        vkCmdCopyBuffer(commandBuffer, frame.instanceStagingBuffer.GetBuffer(), m_instanceBuffer.GetBuffer(), static_cast<uint32_t>(m_instanceCopies.size()), m_instanceCopies.data());
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    void VulkanRenderer::Draw(const Camera &camera, const DirectionalLight &light, const std::vector<RenderBatch> &batches, const std::vector<glm::mat4> &instances,
+                              const std::vector<InstanceRange> &dirtyInstances, std::chrono::high_resolution_clock::time_point inputTime)
+    {
+        VLT_PROFILE_ZONE("VulkanRenderer::Draw");
+
+        // Skipped frames report zeros
+        m_stats = {};
 
-        static std::chrono::high_resolution_clock::time_point lastTime = std::chrono::high_resolution_clock::now();
-        const auto currentTime = std::chrono::high_resolution_clock::now();
-        const float dt = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
-        lastTime = currentTime;
+        // Before anything can skip the frame, the changes are kept until they are staged
+        MarkInstancesDirty(dirtyInstances);
+
+        uint64_t completedFrame = 0;
+        VK_CHECK(vkGetSemaphoreCounterValue(m_context.GetDevice(), m_frameTimeline, &completedFrame));
+        m_deletionQueue.Flush(completedFrame);
+        if (m_readback.IsInitialized())
+        {
+            m_readback.Poll(m_context, completedFrame);
+        }
+
+        // Skip the frame while there is no swapchain to render to, e.g. while minimized
+        if (m_swapchainDirty && !RecreateSwapchain())
+        {
+            return;
+        }
+
+        constexpr uint64_t timeout = (std::numeric_limits<uint64_t>::max)();
+        const uint32_t currentFrame = m_currentFrameIndex;
+        FrameData &frame = m_frames[currentFrame];
+
+        // Everything that does not touch this frame's GPU resources happens before waiting on them
+        ReserveInstances(instances.size());
+        PrepareBatches(batches);
 
-        // Uniform buffer
         UniformBufferData ubo = m_uniformBufferData;
-        const glm::vec3 viewPos = glm::vec3(0.0f, 4.0f, 3.0f);
-        const glm::vec3 viewDir = glm::normalize(glm::vec3(0.0f, -1.0f, -0.3f));
-        ubo.view = glm::lookAt(viewPos, viewPos + viewDir, glm::vec3(0.0f, 0.0f, 1.0f));
+        const float aspect = (float)GetTargetExtent().width / (float)GetTargetExtent().height;
+        ubo.view = glm::lookAt(camera.position, camera.position + camera.direction, camera.up);
+        ubo.proj = glm::perspective(glm::radians(camera.fov), aspect, camera.nearPlane, camera.farPlane);
+        ubo.proj[1][1] *= -1;
+        ubo.lightDir = light.direction;
+        ubo.viewPos = camera.position;
+
+        // Wait until the GPU is done with the last frame that used this frame data
+        const auto waitStartTime = std::chrono::high_resolution_clock::now();
+        {
+            VLT_PROFILE_ZONE("Wait for frame");
+            VkSemaphoreWaitInfo waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &m_frameTimeline;
+            waitInfo.pValues = &frame.timelineValue;
+            VK_CHECK(vkWaitSemaphores(m_context.GetDevice(), &waitInfo, timeout));
+        }
+        m_frameWaitTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - waitStartTime).count();
+
+        // Only frames the GPU has finished are resolved, at the latest the one that used this frame data,
+        // before its queries are reset for the new frame
+        VK_CHECK(vkGetSemaphoreCounterValue(m_context.GetDevice(), m_frameTimeline, &completedFrame));
+        m_gpuProfiler.Resolve(m_context, completedFrame);
+        m_pipelineStatistics.Resolve(m_context, completedFrame);
+
+        // Headless frames always render to the one offscreen target
+        uint32_t imageIndex = 0;
+        if (!m_context.IsHeadless())
+        {
+            VLT_PROFILE_ZONE("Acquire");
+            VkResult acquireResult = vkAcquireNextImageKHR(m_context.GetDevice(), m_swapchain.GetSwapchain(), timeout, frame.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+            if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                // A failed acquire does not signal the semaphore, so the frame can be retried on a new swapchain
+                m_swapchainDirty = true;
+                if (!RecreateSwapchain())
+                {
+                    return;
+                }
+                acquireResult = vkAcquireNextImageKHR(m_context.GetDevice(), m_swapchain.GetSwapchain(), timeout, frame.imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+            }
+
+            if (acquireResult == VK_SUBOPTIMAL_KHR)
+            {
+                m_swapchainDirty = true;
+            }
+            else if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+            {
+                m_swapchainDirty = true;
+                return;
+            }
+            else
+            {
+                VK_CHECK(acquireResult);
+            }
+        }
+
         frame.uniformBuffer.CopyData(&ubo, sizeof(ubo));
 
-        // Instance buffer
-        const size_t size = sizeof(InstanceData) * instances.size();
-        frame.instanceBuffer.CopyData(instances.data(), size);
+        // The frame's descriptor set is no longer in use, it can follow a grown instance buffer
+        if (frame.boundInstanceBuffer != m_instanceBuffer.GetBuffer())
+        {
+            VkInit::UpdateDescriptorSet(m_context.GetDevice(), frame.descriptorSet,
+                                        {{.binding = 1, .type = DescriptorType::StorageBuffer, .buffer = m_instanceBuffer.GetBuffer(), .size = m_instanceBuffer.GetSize()}});
+            frame.boundInstanceBuffer = m_instanceBuffer.GetBuffer();
+        }
 
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        m_stats.uniformBytesUploaded = sizeof(ubo);
+        m_stats.instanceBytesUploaded = StageInstances(frame, instances);
+
+        // Numbered before recording so the readback knows which frame it copies
+        const uint64_t frameNumber = ++m_frameNumber;
+        m_stats.frameNumber = frameNumber;
+        m_memoryBudget.Update(frameNumber);
+        frame.timelineValue = frameNumber;
+        m_inputTimes[frameNumber % c_latencyHistory] = inputTime;
+
+        // Decided before recording, a readback callback that cannot keep up drops frames instead of stalling the render thread
+        const bool copyReadback = m_readback.IsInitialized() && m_readback.IsSlotAvailable();
+        m_stats.skippedReadbacks = m_readback.IsInitialized() && !copyReadback ? 1 : 0;
+
+        vkResetCommandBuffer(frame.commandBuffer, 0);
+        WriteCommandBuffer(frame.commandBuffer, imageIndex, batches, copyReadback);
 
         VkSemaphore waitSemaphores[] = {frame.imageAvailableSemaphore};
         VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        VkSemaphore signalSemaphores[] = {frame.renderFinishedSemaphore, m_frameTimeline};
+
+        // Values for binary semaphores are ignored
+        const uint64_t waitValues[] = {0};
+        const uint64_t signalValues[] = {0, frameNumber};
+
+        VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+        timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineSubmitInfo.waitSemaphoreValueCount = 1;
+        timelineSubmitInfo.pWaitSemaphoreValues = waitValues;
+        timelineSubmitInfo.signalSemaphoreValueCount = 2;
+        timelineSubmitInfo.pSignalSemaphoreValues = signalValues;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineSubmitInfo;
+
         submitInfo.waitSemaphoreCount = 1;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
@@ -557,53 +1215,154 @@ namespace Vultron
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &frame.commandBuffer;
 
-        VkSemaphore signalSemaphores[] = {frame.renderFinishedSemaphore};
-        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.signalSemaphoreCount = 2;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        VK_CHECK(vkQueueSubmit(m_context.GetGraphicsQueue(), 1, &submitInfo, frame.inFlightFence));
+        // Nothing is acquired or presented when headless, only the frame timeline is signaled
+        if (m_context.IsHeadless())
+        {
+            timelineSubmitInfo.waitSemaphoreValueCount = 0;
+            timelineSubmitInfo.signalSemaphoreValueCount = 1;
+            timelineSubmitInfo.pSignalSemaphoreValues = &signalValues[1];
+            submitInfo.waitSemaphoreCount = 0;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &signalSemaphores[1];
+        }
+
+        {
+            VLT_PROFILE_ZONE("Submit");
+            VK_CHECK(vkQueueSubmit(m_context.GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE));
+        }
+
+        if (m_context.IsHeadless())
+        {
+            // Input to submit, there is no present to measure
+            m_latency = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - inputTime).count();
+            m_currentFrameIndex = (currentFrame + 1) % m_framesInFlight;
+            return;
+        }
 
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
         presentInfo.waitSemaphoreCount = 1;
-        presentInfo.pWaitSemaphores = signalSemaphores;
+        presentInfo.pWaitSemaphores = &frame.renderFinishedSemaphore;
 
         VkSwapchainKHR swapChains[] = {m_swapchain.GetSwapchain()};
         presentInfo.swapchainCount = 1;
         presentInfo.pSwapchains = swapChains;
         presentInfo.pImageIndices = &imageIndex;
 
-        VK_CHECK(vkQueuePresentKHR(m_context.GetPresentQueue(), &presentInfo));
+        // The frame number doubles as present id, it only has to increase
+        VkPresentIdKHR presentId{};
+        presentId.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+        presentId.swapchainCount = 1;
+        presentId.pPresentIds = &frameNumber;
+        if (m_context.IsPresentWaitSupported())
+        {
+            presentInfo.pNext = &presentId;
+        }
+
+        // Out of date or suboptimal presents still consume the semaphore, the swapchain is recreated next frame
+        VkResult presentResult = VK_SUCCESS;
+        {
+            VLT_PROFILE_ZONE("Present");
+            presentResult = vkQueuePresentKHR(m_context.GetPresentQueue(), &presentInfo);
+        }
+        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR)
+        {
+            m_swapchainDirty = true;
+        }
+        else
+        {
+            VK_CHECK(presentResult);
 
-        m_currentFrameIndex = (currentFrame + 1) % c_frameOverlap;
+            if (m_resizeRecreated)
+            {
+                m_resizeLatency = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - m_resizeStartTime).count();
+                m_resizePending = false;
+                m_resizeRecreated = false;
+            }
+        }
+
+        if (m_context.IsPresentWaitSupported())
+        {
+            m_lastPresentId = frameNumber;
+        }
+
+        // Without present wait the best estimate is the time the image was queued
+        if (!m_presentWaitEnabled || !m_context.IsPresentWaitSupported())
+        {
+            m_latency = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - inputTime).count();
+        }
+
+        // Frame data slots stay valid when the count changes, each one remembers its own timeline value
+        m_currentFrameIndex = (currentFrame + 1) % m_framesInFlight;
+    }
+
+    RenderStats VulkanRenderer::GetRenderStats() const
+    {
+        RenderStats stats = m_stats;
+        stats.pipelineStatisticsSupported = m_pipelineStatistics.IsSupported() && !m_pipelineStatistics.WasSkipped();
+        stats.pipelineStatistics = m_pipelineStatistics.GetResults();
+        return stats;
     }
 
     void VulkanRenderer::Shutdown()
     {
         vkDeviceWaitIdle(m_context.GetDevice());
 
-        for (size_t i = 0; i < c_frameOverlap; i++)
+        // Joins the compile workers first, they may still be creating pipelines from the shaders, layouts and render pass
+        m_pipelineManager.Destroy(m_context);
+        m_deletionQueue.FlushAll();
+
+        // Deliver the frames still in the ring before the buffers go away
+        if (m_readback.IsInitialized())
+        {
+            m_readback.Poll(m_context, m_frameNumber);
+            m_readback.Destroy(m_context);
+        }
+
+        for (size_t i = 0; i < c_maxFramesInFlight; i++)
         {
             vkDestroySemaphore(m_context.GetDevice(), m_frames[i].imageAvailableSemaphore, nullptr);
             vkDestroySemaphore(m_context.GetDevice(), m_frames[i].renderFinishedSemaphore, nullptr);
-            vkDestroyFence(m_context.GetDevice(), m_frames[i].inFlightFence, nullptr);
 
             vkFreeCommandBuffers(m_context.GetDevice(), m_commandPool, 1, &m_frames[i].commandBuffer);
 
+            for (uint32_t thread = 0; thread < c_maxRecordingThreads; thread++)
+            {
+                vkFreeCommandBuffers(m_context.GetDevice(), m_frames[i].recordingPools[thread], 1, &m_frames[i].secondaryCommandBuffers[thread]);
+                vkDestroyCommandPool(m_context.GetDevice(), m_frames[i].recordingPools[thread], nullptr);
+            }
+
             m_frames[i].uniformBuffer.Unmap(m_context.GetAllocator());
             m_frames[i].uniformBuffer.Destroy(m_context.GetAllocator());
 
-            m_frames[i].instanceBuffer.Unmap(m_context.GetAllocator());
-            m_frames[i].instanceBuffer.Destroy(m_context.GetAllocator());
+            if (m_frames[i].instanceStagingBuffer.GetBuffer() != VK_NULL_HANDLE)
+            {
+                m_frames[i].instanceStagingBuffer.Unmap(m_context.GetAllocator());
+                m_frames[i].instanceStagingBuffer.Destroy(m_context.GetAllocator());
+            }
         }
 
+        m_instanceBuffer.Destroy(m_context.GetAllocator());
+
+        vkDestroySemaphore(m_context.GetDevice(), m_frameTimeline, nullptr);
+        m_gpuProfiler.Destroy(m_context);
+        m_pipelineStatistics.Destroy(m_context);
+        m_memoryBudget.Destroy();
+
         vkDestroySampler(m_context.GetDevice(), m_textureSampler, nullptr);
 
         m_depthImage.Destroy(m_context);
         m_resourcePool.Destroy(m_context);
-        m_vertexShader.Destroy(m_context);
-        m_fragmentShader.Destroy(m_context);
+        if (!m_shaderBundle.IsLoaded())
+        {
+            m_vertexShader.Destroy(m_context);
+            m_fragmentShader.Destroy(m_context);
+        }
+        m_shaderBundle.Destroy(m_context);
 
         vkDestroyCommandPool(m_context.GetDevice(), m_commandPool, nullptr);
 
@@ -611,8 +1370,19 @@ namespace Vultron
         vkDestroyDescriptorSetLayout(m_context.GetDevice(), m_descriptorSetLayout, nullptr);
         m_materialPipeline.Destroy(m_context);
 
+        m_pipelineCache.Save(m_context);
+        m_pipelineCache.Destroy(m_context);
+
         m_renderPass.Destroy(m_context);
-        m_swapchain.Destroy(m_context);
+        if (m_context.IsHeadless())
+        {
+            vkDestroyFramebuffer(m_context.GetDevice(), m_offscreenFramebuffer, nullptr);
+            m_colorImage.Destroy(m_context);
+        }
+        else
+        {
+            m_swapchain.Destroy(m_context);
+        }
 
         if (c_validationLayersEnabled)
         {
@@ -624,6 +1394,8 @@ namespace Vultron
 
     RenderHandle VulkanRenderer::LoadMesh(const std::string &filepath)
     {
+        VLT_PROFILE_ZONE("VulkanRenderer::LoadMesh");
+
         VulkanMesh mesh = VulkanMesh::CreateFromFile(
             {.device = m_context.GetDevice(),
              .commandPool = m_commandPool,
@@ -636,6 +1408,8 @@ namespace Vultron
 
     RenderHandle VulkanRenderer::LoadImage(const std::string &filepath)
     {
+        VLT_PROFILE_ZONE("VulkanRenderer::LoadImage");
+
         VulkanImage image = VulkanImage::CreateFromFile(
             {.device = m_context.GetDevice(),
              .commandPool = m_commandPool,
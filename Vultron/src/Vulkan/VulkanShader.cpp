@@ -1,5 +1,6 @@
 #include "Vultron/Vulkan/VulkanShader.h"
 #include "Vultron/Vulkan/VulkanUtils.h"
+#include "Vultron/Core/Hash.h"
 
 #include <fstream>
 #include <cassert>
@@ -11,15 +12,7 @@ namespace Vultron
 {
     VulkanShader VulkanShader::Create(const ShaderCreateInfo &createInfo)
     {
-        VkShaderModuleCreateInfo createInfoVk = {};
-        createInfoVk.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfoVk.codeSize = createInfo.source.size();
-        createInfoVk.pCode = reinterpret_cast<const uint32_t *>(createInfo.source.data());
-
-        VkShaderModule shaderModule;
-        VK_CHECK(vkCreateShaderModule(createInfo.device, &createInfoVk, nullptr, &shaderModule));
-
-        return VulkanShader(shaderModule);
+        return CreateFromCode({.device = createInfo.device, .code = reinterpret_cast<const uint32_t *>(createInfo.source.data()), .codeSize = createInfo.source.size()});
     }
 
     Ptr<VulkanShader> VulkanShader::CreatePtr(const ShaderCreateInfo &createInfo)
@@ -28,32 +21,37 @@ namespace Vultron
         return MakePtr<VulkanShader>(Create(createInfo));
     }
 
-    VulkanShader VulkanShader::CreateFromFile(const ShaderFromFileCreateInfo &createInfo)
+    VulkanShader VulkanShader::CreateFromCode(const ShaderFromCodeCreateInfo &createInfo)
     {
-        std::ifstream file(createInfo.filepath, std::ios::ate | std::ios::binary);
-        assert(file.is_open());
+        VkShaderModuleCreateInfo createInfoVk = {};
+        createInfoVk.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfoVk.codeSize = createInfo.codeSize;
+        createInfoVk.pCode = createInfo.code;
 
-        size_t fileSize = static_cast<size_t>(file.tellg());
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        file.close();
+        VkShaderModule shaderModule;
+        VK_CHECK(vkCreateShaderModule(createInfo.device, &createInfoVk, nullptr, &shaderModule));
 
-        return Create({.device = createInfo.device, .source = std::string(buffer.data(), fileSize)});
+        return VulkanShader(shaderModule, HashBytes(createInfo.code, createInfo.codeSize));
     }
 
-    Ptr<VulkanShader> VulkanShader::CreatePtrFromFile(const ShaderFromFileCreateInfo &createInfo)
+    VulkanShader VulkanShader::CreateFromFile(const ShaderFromFileCreateInfo &createInfo)
     {
         std::ifstream file(createInfo.filepath, std::ios::ate | std::ios::binary);
         assert(file.is_open());
 
+        // Read straight into 32-bit words, SPIR-V needs the alignment anyway
         size_t fileSize = static_cast<size_t>(file.tellg());
-        std::vector<char> buffer(fileSize);
+        std::vector<uint32_t> code((fileSize + sizeof(uint32_t) - 1) / sizeof(uint32_t));
         file.seekg(0);
-        file.read(buffer.data(), fileSize);
+        file.read(reinterpret_cast<char *>(code.data()), fileSize);
         file.close();
 
-        return MakePtr<VulkanShader>(Create({.device = createInfo.device, .source = std::string(buffer.data(), fileSize)}));
+        return CreateFromCode({.device = createInfo.device, .code = code.data(), .codeSize = fileSize});
+    }
+
+    Ptr<VulkanShader> VulkanShader::CreatePtrFromFile(const ShaderFromFileCreateInfo &createInfo)
+    {
+        return MakePtr<VulkanShader>(CreateFromFile(createInfo));
     }
 
     void VulkanShader::Destroy(const VulkanContext &context)
@@ -0,0 +1,118 @@
+#include "Vultron/Vulkan/VulkanShaderBundle.h"
+
+#include "Vultron/Core/Hash.h"
+#include "Vultron/Vulkan/VulkanUtils.h"
+
+#include <cassert>
+#include <iostream>
+
+namespace Vultron
+{
+    bool VulkanShaderBundle::Initialize(const VulkanContext &context, const ShaderBundleCreateInfo &createInfo)
+    {
+        m_device = context.GetDevice();
+
+        if (!m_file.Open(createInfo.filepath))
+        {
+            return false;
+        }
+
+        const uint8_t *data = m_file.GetData();
+        const size_t size = m_file.GetSize();
+
+        const ShaderBundleHeader *header = reinterpret_cast<const ShaderBundleHeader *>(data);
+        if (size < sizeof(ShaderBundleHeader) || header->magic != c_shaderBundleMagic || header->version != c_shaderBundleVersion)
+        {
+            std::cerr << "Invalid shader bundle " << createInfo.filepath << std::endl;
+            m_file.Close();
+            return false;
+        }
+
+        if (size < sizeof(ShaderBundleHeader) + header->entryCount * sizeof(ShaderBundleEntry))
+        {
+            std::cerr << "Shader bundle table of contents is truncated." << std::endl;
+            m_file.Close();
+            return false;
+        }
+
+        m_entries = reinterpret_cast<const ShaderBundleEntry *>(data + sizeof(ShaderBundleHeader));
+        m_entryCount = header->entryCount;
+
+        for (uint32_t i = 0; i < m_entryCount; i++)
+        {
+            const ShaderBundleEntry &entry = m_entries[i];
+            if (entry.offset + entry.size > size || entry.offset % sizeof(uint32_t) != 0)
+            {
+                std::cerr << "Shader bundle entry " << i << " is out of bounds." << std::endl;
+                m_file.Close();
+                return false;
+            }
+        }
+
+        std::cout << "Mapped shader bundle with " << m_entryCount << " modules." << std::endl;
+
+        return true;
+    }
+
+    void VulkanShaderBundle::Destroy(const VulkanContext &context)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &[key, shader] : m_shaders)
+        {
+            shader.Destroy(context);
+        }
+
+        m_shaders.clear();
+        m_entries = nullptr;
+        m_entryCount = 0;
+        m_file.Close();
+    }
+
+    uint64_t VulkanShaderBundle::GetKey(uint64_t nameHash, uint64_t variantHash)
+    {
+        return HashValue(variantHash, HashValue(nameHash));
+    }
+
+    const ShaderBundleEntry *VulkanShaderBundle::FindEntry(uint64_t nameHash, uint64_t variantHash) const
+    {
+        // The table is small, a linear scan over the mapped entries is fine
+        for (uint32_t i = 0; i < m_entryCount; i++)
+        {
+            if (m_entries[i].nameHash == nameHash && m_entries[i].variantHash == variantHash)
+            {
+                return &m_entries[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool VulkanShaderBundle::Contains(std::string_view name, uint64_t variantHash) const
+    {
+        return FindEntry(HashString(name), variantHash) != nullptr;
+    }
+
+    VulkanShader VulkanShaderBundle::GetShader(std::string_view name, uint64_t variantHash)
+    {
+        const uint64_t nameHash = HashString(name);
+        const uint64_t key = GetKey(nameHash, variantHash);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (auto it = m_shaders.find(key); it != m_shaders.end())
+        {
+            return it->second;
+        }
+
+        const ShaderBundleEntry *entry = FindEntry(nameHash, variantHash);
+        assert(entry != nullptr && "Shader not found in bundle.");
+
+        VulkanShader shader = VulkanShader::CreateFromCode(
+            {.device = m_device,
+             .code = reinterpret_cast<const uint32_t *>(m_file.GetData() + entry->offset),
+             .codeSize = static_cast<size_t>(entry->size)});
+
+        m_shaders.insert({key, shader});
+
+        return shader;
+    }
+}
@@ -7,9 +7,9 @@
 namespace Vultron
 {
 
-    bool VulkanSwapchain::Initialize(const VulkanContext &context, uint32_t width, uint32_t height)
+    bool VulkanSwapchain::Initialize(const VulkanContext &context, uint32_t width, uint32_t height, PresentPolicy policy, VkSwapchainKHR oldSwapchain)
     {
-        if (!InitializeSwapChain(context, width, height))
+        if (!InitializeSwapChain(context, width, height, policy, oldSwapchain))
         {
             return false;
         }
@@ -35,9 +35,13 @@ namespace Vultron
         }
 
         vkDestroySwapchainKHR(context.GetDevice(), m_swapchain, nullptr);
+
+        m_swapchainFramebuffers.clear();
+        m_swapchainImageViews.clear();
+        m_swapchainImages.clear();
     }
 
-    bool VulkanSwapchain::InitializeSwapChain(const VulkanContext &context, uint32_t width, uint32_t height)
+    bool VulkanSwapchain::InitializeSwapChain(const VulkanContext &context, uint32_t width, uint32_t height, PresentPolicy policy, VkSwapchainKHR oldSwapchain)
     {
         VkUtil::SwapChainSupport support = VkUtil::QuerySwapChainSupport(context.GetPhysicalDevice(), context.GetSurface());
 
@@ -53,16 +57,24 @@ namespace Vultron
 
         m_swapchainImageFormat = surfaceFormat.format;
 
-        // Pick present mode
+        // Pick present mode, FIFO is always available
+        const auto isSupported = [&](VkPresentModeKHR mode)
+        {
+            return std::find(support.presentModes.begin(), support.presentModes.end(), mode) != support.presentModes.end();
+        };
+
         VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-        for (const auto &mode : support.presentModes)
+        if (policy == PresentPolicy::LowLatency && isSupported(VK_PRESENT_MODE_IMMEDIATE_KHR))
         {
-            if (mode == VK_PRESENT_MODE_MAILBOX_KHR)
-            {
-                presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
-            }
+            presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+        }
+        else if (policy != PresentPolicy::VSync && isSupported(VK_PRESENT_MODE_MAILBOX_KHR))
+        {
+            presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
         }
 
+        m_presentMode = presentMode;
+
         // Pick extent
         VkExtent2D extent;
         VkSurfaceCapabilitiesKHR &capabilities = support.capabilities;
@@ -81,10 +93,17 @@ namespace Vultron
             extent = actualExtent;
         }
 
+        // Minimized windows report a zero extent, there is nothing to create until they are restored
+        if (extent.width == 0 || extent.height == 0)
+        {
+            return false;
+        }
+
         m_swapchainExtent = extent;
 
-        // Pick image count
-        uint32_t imageCount = support.capabilities.minImageCount + 1;
+        // Pick image count, low latency keeps the queue as short as possible
+        uint32_t imageCount = support.capabilities.minImageCount + (policy == PresentPolicy::LowLatency ? 0 : 1);
+        imageCount = std::max(imageCount, 2u);
         if (support.capabilities.maxImageCount > 0 && imageCount > support.capabilities.maxImageCount)
         {
             imageCount = support.capabilities.maxImageCount;
@@ -121,7 +140,7 @@ namespace Vultron
         createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         createInfo.presentMode = presentMode;
         createInfo.clipped = VK_TRUE;
-        createInfo.oldSwapchain = VK_NULL_HANDLE;
+        createInfo.oldSwapchain = oldSwapchain;
 
         VK_CHECK(vkCreateSwapchainKHR(context.GetDevice(), &createInfo, nullptr, &m_swapchain));
 
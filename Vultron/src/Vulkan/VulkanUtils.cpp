@@ -22,8 +22,16 @@ namespace Vultron::VkUtil
                 families.graphicsFamily = i;
             }
 
+            // Without a surface nothing is presented, the graphics queue stands in for the present queue
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            if (surface == VK_NULL_HANDLE)
+            {
+                presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+            }
+            else
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            }
 
             if (presentSupport)
             {
@@ -15,7 +15,7 @@ namespace Vultron
         }
 
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 
         m_width = width;
         m_height = height;
@@ -28,6 +28,14 @@ namespace Vultron
             return false;
         }
 
+        // The renderer picks up the new extent on its next frame
+        glfwSetWindowUserPointer(m_windowHandle, this);
+        glfwSetFramebufferSizeCallback(m_windowHandle, [](GLFWwindow *handle, int newWidth, int newHeight)
+                                       {
+            Window *window = static_cast<Window *>(glfwGetWindowUserPointer(handle));
+            window->m_width = static_cast<uint32_t>(newWidth);
+            window->m_height = static_cast<uint32_t>(newHeight); });
+
         return true;
     }
 
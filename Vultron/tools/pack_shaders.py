@@ -0,0 +1,98 @@
+import argparse
+import os
+import struct
+import subprocess
+import tempfile
+
+# Compile, optimize and pack shaders into a single vultron shader bundle.
+# Layout must match ShaderBundleHeader/ShaderBundleEntry in VulkanShaderBundle.h
+
+MAGIC = 0x31425356  # "VSB1"
+VERSION = 1
+ENTRY_FORMAT = "<QQQQ64s"
+HEADER_FORMAT = "<IIII"
+ALIGNMENT = 16
+
+VULKAN_SDK_PATH = os.environ.get("VULKAN_SDK")
+BIN_PATH = f"{VULKAN_SDK_PATH}/bin/" if VULKAN_SDK_PATH else ""
+
+
+def fnv1a(data, h=14695981039346656037):
+    # Same as HashString in Vultron/Core/Hash.h
+    for byte in data:
+        h ^= byte
+        h = (h * 1099511628211) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+def variant_hash(defines):
+    # The default variant, without extra defines, always has hash 0
+    if not defines:
+        return 0
+    return fnv1a(",".join(sorted(defines)).encode("utf-8"))
+
+
+def compile_shader(path, defines, optimize, bin_path):
+    with tempfile.TemporaryDirectory() as temp:
+        unoptimized = os.path.join(temp, "shader.spv")
+        optimized = os.path.join(temp, "shader.opt.spv")
+
+        command = [os.path.join(bin_path, "glslc"), "--target-env=vulkan", path, "-o", unoptimized]
+        command += [f"-D{define}" for define in defines]
+        subprocess.run(command, check=True)
+
+        if not optimize:
+            with open(unoptimized, "rb") as f:
+                return f.read()
+
+        subprocess.run([os.path.join(bin_path, "spirv-opt"), "-O", unoptimized, "-o", optimized], check=True)
+        with open(optimized, "rb") as f:
+            return f.read()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pack shaders into a vultron shader bundle")
+    # pack_shaders.py ../assets/shaders -o <build>/Vultron/shaders/shaders.bundle --variant triangle.frag:USE_FOG
+    parser.add_argument("input", help="Directory with .vert and .frag sources")
+    parser.add_argument("-o", "--output", help="The output bundle", default="shaders.bundle")
+    parser.add_argument("--variant", action="append", default=[],
+                        help="Extra variant as name:DEFINE1,DEFINE2, keyed by the hash of the sorted defines")
+    parser.add_argument("--no-optimize", action="store_true", help="Skip spirv-opt")
+    parser.add_argument("--bin-path", default=BIN_PATH, help="Directory with glslc and spirv-opt, PATH when empty")
+    args = parser.parse_args()
+
+    jobs = []
+    for name in sorted(os.listdir(args.input)):
+        if name.endswith((".vert", ".frag", ".comp")):
+            jobs.append((name, []))
+
+    for variant in args.variant:
+        name, defines = variant.split(":", 1)
+        jobs.append((name, [d for d in defines.split(",") if d]))
+
+    modules = []
+    for name, defines in jobs:
+        code = compile_shader(os.path.join(args.input, name), defines, not args.no_optimize, args.bin_path)
+        modules.append((name, variant_hash(defines), code))
+        print(f"Compiled {name} {' '.join(defines)} ({len(code)} bytes)")
+
+    offset = struct.calcsize(HEADER_FORMAT) + struct.calcsize(ENTRY_FORMAT) * len(modules)
+    entries = []
+    for name, variant, code in modules:
+        offset = (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1)
+        entries.append((fnv1a(name.encode("utf-8")), variant, offset, len(code), name.encode("utf-8")[:63]))
+        offset += len(code)
+
+    with open(args.output, "wb") as f:
+        f.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(modules), 0))
+        for entry in entries:
+            f.write(struct.pack(ENTRY_FORMAT, *entry))
+        for (_, _, code), entry in zip(modules, entries):
+            f.write(b"\0" * (entry[2] - f.tell()))
+            f.write(code)
+
+    print(f"Packed {len(modules)} modules into {args.output}")
+
+
+if __name__ == "__main__":
+    main()
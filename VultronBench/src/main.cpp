@@ -0,0 +1,448 @@
+#include "Vultron/Vultron.h"
+#include "Vultron/SceneRenderer.h"
+#include "Vultron/Window.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A scripted scene, instances are laid out on a grid and assigned meshes and materials round robin
+struct BenchScene
+{
+    std::string name;
+    uint32_t instanceCount = 0;
+    uint32_t meshCount = 1;
+    uint32_t materialCount = 1;
+    // Share of instances whose transform changes every frame
+    float dynamicFraction = 0.0f;
+};
+
+struct BenchTimings
+{
+    float mean = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+};
+
+struct BenchResult
+{
+    BenchScene scene;
+    uint64_t draws = 0;
+    uint64_t triangles = 0;
+    BenchTimings cpu;
+    BenchTimings gpu;
+    float recordingTime = 0.0f;
+    // Mean time of every GPU scope, only with --gpu-scopes
+    std::vector<Vultron::GpuScope> gpuScopes;
+    // Counters of the last frame
+    Vultron::RenderStats stats;
+};
+
+static const std::vector<BenchScene> c_defaultScenes = {
+    {"static", 2000, 1, 1, 0.0f},
+    {"dynamic", 2000, 1, 1, 1.0f},
+    {"meshes", 2000, 16, 1, 0.1f},
+    {"materials", 2000, 1, 16, 0.1f},
+    {"mixed", 2000, 8, 8, 0.25f},
+    {"small", 100, 1, 1, 0.0f},
+};
+
+// Nearest rank percentiles, samples are sorted in place
+static BenchTimings ComputeTimings(std::vector<float> &samples)
+{
+    BenchTimings timings;
+    if (samples.empty())
+    {
+        return timings;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](float p)
+    {
+        const size_t rank = static_cast<size_t>(p * (samples.size() - 1) + 0.5f);
+        return samples[rank];
+    };
+
+    for (float sample : samples)
+    {
+        timings.mean += sample;
+    }
+    timings.mean /= samples.size();
+    timings.p50 = percentile(0.50f);
+    timings.p95 = percentile(0.95f);
+    timings.p99 = percentile(0.99f);
+    timings.max = samples.back();
+
+    return timings;
+}
+
+// Reads only the counts from the header of a mesh file, see VulkanMesh::CreateFromFile
+static uint64_t ReadMeshTriangleCount(const std::string &filepath)
+{
+    std::ifstream file(filepath, std::ios::binary);
+    uint32_t vertexCount = 0;
+    file.read(reinterpret_cast<char *>(&vertexCount), sizeof(vertexCount));
+    file.seekg(static_cast<std::streamoff>(vertexCount) * sizeof(Vultron::StaticMeshVertex), std::ios::cur);
+
+    uint32_t indexCount = 0;
+    file.read(reinterpret_cast<char *>(&indexCount), sizeof(indexCount));
+    return indexCount / 3;
+}
+
+static void WriteTimings(std::ostream &out, const char *name, const BenchTimings &timings)
+{
+    out << "\"" << name << "\": {\"mean\": " << timings.mean << ", \"p50\": " << timings.p50 << ", \"p95\": " << timings.p95
+        << ", \"p99\": " << timings.p99 << ", \"max\": " << timings.max << "}";
+}
+
+static void WriteRenderStats(std::ostream &out, const Vultron::RenderStats &stats)
+{
+    out << "\"stats\": {\"jobs\": " << stats.submittedJobs << ", \"objects\": " << stats.renderObjects << ", \"object_commands\": " << stats.objectCommands
+        << ", \"transform_nodes\": " << stats.transformNodes << ", \"transforms_updated\": " << stats.transformsUpdated
+        << ", \"batches\": " << stats.batches << ", \"draw_calls\": " << stats.drawCalls
+        << ", \"instances\": " << stats.instances << ", \"triangles\": " << stats.triangles << ", \"pipeline_binds\": " << stats.pipelineBinds
+        << ", \"descriptor_binds\": " << stats.descriptorBinds << ", \"skipped_batches\": " << stats.skippedBatches
+        << ", \"instance_bytes\": " << stats.instanceBytesUploaded << ", \"uniform_bytes\": " << stats.uniformBytesUploaded
+        << ", \"culled_instances\": " << stats.culledInstances << ", \"culled_triangles\": " << stats.culledTriangles << ", \"skipped_readbacks\": " << stats.skippedReadbacks;
+    if (stats.pipelineStatisticsSupported)
+    {
+        const Vultron::PipelineStatistics &pipeline = stats.pipelineStatistics;
+        out << ", \"pipeline\": {\"input_primitives\": " << pipeline.inputAssemblyPrimitives << ", \"vertex_invocations\": " << pipeline.vertexShaderInvocations
+            << ", \"clipping_invocations\": " << pipeline.clippingInvocations << ", \"clipping_primitives\": " << pipeline.clippingPrimitives
+            << ", \"fragment_invocations\": " << pipeline.fragmentShaderInvocations << "}";
+    }
+    out << "}";
+}
+
+static const char *GetBackendName(Vultron::RenderBackendType type)
+{
+    switch (type)
+    {
+    case Vultron::RenderBackendType::Null:
+        return "null";
+    case Vultron::RenderBackendType::Software:
+        return "software";
+    case Vultron::RenderBackendType::Vulkan:
+    default:
+        return "vulkan";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // VultronBench [--scene <name>]... [--custom <instances> <meshes> <materials> <dynamic fraction>]
+    //              [--frames <n>] [--warmup <n>] [--headless] [--resolution <width> <height>]
+    //              [--backend vulkan|null|software] [--gpu-scopes] [--retained] [--output <file>]
+    // runs every scene for a fixed number of frames and writes the results as JSON, to stdout without --output.
+    // --gpu-scopes also times every batch on the GPU, reading the scopes flushes the render thread every frame.
+    // --retained creates the instances as render objects and only moves the dynamic ones instead of submitting every instance.
+    std::vector<BenchScene> scenes;
+    uint32_t frameCount = 500;
+    uint32_t warmupFrames = 50;
+    bool headless = false;
+    uint32_t width = 1920;
+    uint32_t height = 1080;
+    Vultron::RenderBackendType backendType = Vultron::RenderBackendType::Vulkan;
+    std::string outputPath;
+    bool gpuScopes = false;
+    bool retained = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "--scene" && i + 1 < argc)
+        {
+            const std::string_view name = argv[++i];
+            const auto scene = std::find_if(c_defaultScenes.begin(), c_defaultScenes.end(), [name](const BenchScene &scene)
+                                            { return scene.name == name; });
+            if (scene == c_defaultScenes.end())
+            {
+                std::cerr << "Unknown scene " << name << std::endl;
+                return -1;
+            }
+            scenes.push_back(*scene);
+        }
+        else if (argument == "--custom" && i + 4 < argc)
+        {
+            BenchScene scene;
+            scene.instanceCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+            scene.meshCount = std::max(static_cast<uint32_t>(std::atoi(argv[++i])), 1u);
+            scene.materialCount = std::max(static_cast<uint32_t>(std::atoi(argv[++i])), 1u);
+            scene.dynamicFraction = std::clamp(static_cast<float>(std::atof(argv[++i])), 0.0f, 1.0f);
+            scene.name = "custom_" + std::to_string(scene.instanceCount) + "_" + std::to_string(scene.meshCount) + "_" + std::to_string(scene.materialCount);
+            scenes.push_back(scene);
+        }
+        else if (argument == "--frames" && i + 1 < argc)
+        {
+            frameCount = std::max(static_cast<uint32_t>(std::atoi(argv[++i])), 1u);
+        }
+        else if (argument == "--warmup" && i + 1 < argc)
+        {
+            warmupFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (argument == "--headless")
+        {
+            headless = true;
+        }
+        else if (argument == "--resolution" && i + 2 < argc)
+        {
+            width = static_cast<uint32_t>(std::atoi(argv[++i]));
+            height = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (argument == "--backend" && i + 1 < argc)
+        {
+            const std::string_view backendName = argv[++i];
+            if (backendName == "null")
+            {
+                backendType = Vultron::RenderBackendType::Null;
+            }
+            else if (backendName == "software")
+            {
+                backendType = Vultron::RenderBackendType::Software;
+            }
+        }
+        else if (argument == "--gpu-scopes")
+        {
+            gpuScopes = true;
+        }
+        else if (argument == "--retained")
+        {
+            retained = true;
+        }
+        else if (argument == "--output" && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+    }
+
+    if (scenes.empty())
+    {
+        scenes = c_defaultScenes;
+    }
+
+    Vultron::Window window;
+    if (!headless && !window.Initialize())
+    {
+        std::cerr << "Window failed to initialize" << std::endl;
+        return -1;
+    }
+
+    Vultron::SceneRenderer renderer;
+    const bool initialized = headless ? renderer.InitializeHeadless(width, height, backendType) : renderer.Initialize(window, backendType);
+    if (!initialized)
+    {
+        std::cerr << "Renderer failed to initialize" << std::endl;
+        return -1;
+    }
+
+    renderer.SetGpuBatchScopesEnabled(gpuScopes);
+
+    // Every scene draws from the same pool, loading a file again gives a separate mesh or material
+    uint32_t meshCount = 0;
+    uint32_t materialCount = 0;
+    for (const BenchScene &scene : scenes)
+    {
+        meshCount = std::max(meshCount, scene.meshCount);
+        materialCount = std::max(materialCount, scene.materialCount);
+    }
+
+    const std::string meshPath = std::string(VLT_ASSETS_DIR) + "/meshes/DamagedHelmet.dat";
+    const uint64_t meshTriangles = ReadMeshTriangleCount(meshPath);
+    std::vector<Vultron::RenderHandle> meshes;
+    for (uint32_t i = 0; i < meshCount; i++)
+    {
+        meshes.push_back(renderer.LoadMesh(meshPath));
+    }
+
+    const std::string texturePaths[] = {std::string(VLT_ASSETS_DIR) + "/textures/helmet_albedo.dat", std::string(VLT_ASSETS_DIR) + "/textures/wood.dat"};
+    std::vector<Vultron::RenderHandle> materials;
+    for (uint32_t i = 0; i < materialCount; i++)
+    {
+        const Vultron::RenderHandle texture = renderer.LoadImage(texturePaths[i % 2]);
+        materials.push_back(renderer.CreateMaterial<Vultron::TexturedMaterial>({
+            .texture = texture,
+        }));
+    }
+
+    std::vector<BenchResult> results;
+    for (const BenchScene &scene : scenes)
+    {
+        // Same grid as the Testbed, wide enough for the largest scenes
+        const uint32_t numPerRow = 50;
+        const float spacing = 2.5f;
+        const glm::mat4 rot = glm::rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        std::vector<glm::mat4> transforms(scene.instanceCount);
+        std::set<std::pair<uint32_t, uint32_t>> batches;
+        for (uint32_t i = 0; i < scene.instanceCount; i++)
+        {
+            const float x = (i % numPerRow) * spacing - (numPerRow * spacing) / 2.0f;
+            const float y = (i / numPerRow) * spacing * -1.0f;
+            transforms[i] = rot * glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f));
+            batches.insert({i % scene.meshCount, (i / scene.meshCount) % scene.materialCount});
+        }
+
+        const uint32_t dynamicCount = static_cast<uint32_t>(scene.dynamicFraction * scene.instanceCount);
+
+        std::vector<Vultron::RenderHandle> objects;
+        if (retained)
+        {
+            for (uint32_t i = 0; i < scene.instanceCount; i++)
+            {
+                objects.push_back(renderer.CreateRenderObject(meshes[i % scene.meshCount], materials[(i / scene.meshCount) % scene.materialCount], transforms[i]));
+            }
+        }
+
+        std::vector<float> cpuTimes;
+        std::vector<float> gpuTimes;
+        float recordingTime = 0.0f;
+        std::vector<Vultron::GpuScope> scopeTotals;
+        uint32_t scopeFrames = 0;
+        for (uint32_t frame = 0; frame < warmupFrames + frameCount; frame++)
+        {
+            const auto frameStartTime = std::chrono::high_resolution_clock::now();
+
+            renderer.BeginFrame();
+
+            if (!headless)
+            {
+                window.PollEvents();
+            }
+
+            // Animated from the frame index, so every run submits the same frames
+            const float time = frame / 60.0f;
+            if (retained)
+            {
+                for (uint32_t i = 0; i < dynamicCount; i++)
+                {
+                    renderer.SetRenderObjectTransform(objects[i], glm::translate(transforms[i], glm::vec3(0.0f, 0.0f, glm::sin(time * 2.0f + i * 0.05f) * 0.5f)));
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < scene.instanceCount; i++)
+                {
+                    const glm::mat4 transform = i < dynamicCount ? glm::translate(transforms[i], glm::vec3(0.0f, 0.0f, glm::sin(time * 2.0f + i * 0.05f) * 0.5f)) : transforms[i];
+                    renderer.SubmitRenderJob({meshes[i % scene.meshCount], materials[(i / scene.meshCount) % scene.materialCount], transform});
+                }
+            }
+
+            renderer.EndFrame();
+
+            if (!headless)
+            {
+                window.SwapBuffers();
+            }
+
+            if (frame >= warmupFrames)
+            {
+                cpuTimes.push_back(std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - frameStartTime).count());
+                gpuTimes.push_back(renderer.GetGpuTime());
+                recordingTime += renderer.GetRecordingTime();
+
+                // Resolved frames can lag behind a scene change, those have a different set of scopes
+                const std::vector<Vultron::GpuScope> scopes = gpuScopes ? renderer.GetGpuScopes() : std::vector<Vultron::GpuScope>();
+                if (scopes.size() != scopeTotals.size())
+                {
+                    scopeTotals = scopes;
+                    scopeFrames = 1;
+                }
+                else if (!scopes.empty())
+                {
+                    for (size_t i = 0; i < scopes.size(); i++)
+                    {
+                        scopeTotals[i].time += scopes[i].time;
+                    }
+                    scopeFrames++;
+                }
+            }
+        }
+
+        for (Vultron::RenderHandle object : objects)
+        {
+            renderer.DestroyRenderObject(object);
+        }
+
+        BenchResult result;
+        result.scene = scene;
+        result.draws = batches.size();
+        result.triangles = meshTriangles * scene.instanceCount;
+        result.cpu = ComputeTimings(cpuTimes);
+        result.gpu = ComputeTimings(gpuTimes);
+        result.recordingTime = recordingTime / frameCount;
+        result.gpuScopes = scopeTotals;
+        result.stats = renderer.GetRenderStats();
+        for (Vultron::GpuScope &scope : result.gpuScopes)
+        {
+            scope.time /= scopeFrames;
+        }
+        results.push_back(result);
+
+        std::cerr << "Scene " << scene.name << ": " << result.cpu.mean << " ms CPU, " << result.gpu.mean << " ms GPU" << std::endl;
+    }
+
+    renderer.Shutdown();
+    if (!headless)
+    {
+        window.Shutdown();
+    }
+
+    std::ofstream file;
+    if (!outputPath.empty())
+    {
+        file.open(outputPath);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to open " << outputPath << std::endl;
+            return -1;
+        }
+    }
+    std::ostream &out = outputPath.empty() ? std::cout : file;
+
+    // Times are in milliseconds, counts are per frame and before culling
+    out << "{\n";
+    out << "  \"backend\": \"" << GetBackendName(backendType) << "\",\n";
+    out << "  \"headless\": " << (headless ? "true" : "false") << ",\n";
+    out << "  \"retained\": " << (retained ? "true" : "false") << ",\n";
+    out << "  \"frames\": " << frameCount << ",\n";
+    out << "  \"warmup\": " << warmupFrames << ",\n";
+    out << "  \"scenes\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &result = results[i];
+        out << "    {\"name\": \"" << result.scene.name << "\", \"instances\": " << result.scene.instanceCount
+            << ", \"meshes\": " << result.scene.meshCount << ", \"materials\": " << result.scene.materialCount
+            << ", \"dynamic\": " << result.scene.dynamicFraction << ", \"draws\": " << result.draws << ", \"triangles\": " << result.triangles
+            << ", \"recording_ms\": " << result.recordingTime << ", ";
+        WriteTimings(out, "cpu_ms", result.cpu);
+        out << ", ";
+        WriteTimings(out, "gpu_ms", result.gpu);
+        out << ", ";
+        WriteRenderStats(out, result.stats);
+        if (!result.gpuScopes.empty())
+        {
+            out << ", \"gpu_scopes\": [";
+            for (size_t j = 0; j < result.gpuScopes.size(); j++)
+            {
+                const Vultron::GpuScope &scope = result.gpuScopes[j];
+                out << (j > 0 ? ", " : "") << "{\"name\": \"" << scope.name << "\", \"index\": " << scope.index << ", \"depth\": " << scope.depth << ", \"ms\": " << scope.time << "}";
+            }
+            out << "]";
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,648 @@
+#include "Vultron/Vultron.h"
+#include "Vultron/SceneRenderer.h"
+#include "Vultron/TransformHierarchy.h"
+#include "Vultron/Vulkan/VulkanImage.h"
+#include "Vultron/Vulkan/VulkanMesh.h"
+#include "Vultron/Vulkan/VulkanResourcePool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Samples per benchmark, the median is reported
+constexpr uint32_t c_sampleCount = 9;
+// Every sample repeats the benchmark until it takes at least this long
+constexpr float c_minSampleTime = 20.0f;
+
+// Results are written here so the compiler cannot drop the measured work
+static volatile uint64_t s_sink = 0;
+
+struct MicroBenchmark
+{
+    std::string name;
+    // Items processed by one run, results are per item
+    uint64_t itemCount = 1;
+    std::function<void()> run;
+};
+
+struct MicroResult
+{
+    std::string name;
+    double nanosecondsPerItem = 0.0;
+};
+
+static bool PinThread(int cpu)
+{
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+static double Measure(const MicroBenchmark &benchmark)
+{
+    using Clock = std::chrono::high_resolution_clock;
+
+    // Warm up caches and find how many runs fill a sample
+    benchmark.run();
+    uint64_t runs = 1;
+    while (true)
+    {
+        const auto startTime = Clock::now();
+        for (uint64_t i = 0; i < runs; i++)
+        {
+            benchmark.run();
+        }
+        const float time = std::chrono::duration<float, std::chrono::milliseconds::period>(Clock::now() - startTime).count();
+        if (time >= c_minSampleTime)
+        {
+            break;
+        }
+        runs *= 2;
+    }
+
+    std::vector<double> samples;
+    for (uint32_t sample = 0; sample < c_sampleCount; sample++)
+    {
+        const auto startTime = Clock::now();
+        for (uint64_t i = 0; i < runs; i++)
+        {
+            benchmark.run();
+        }
+        const double time = std::chrono::duration<double, std::nano>(Clock::now() - startTime).count();
+        samples.push_back(time / static_cast<double>(runs * benchmark.itemCount));
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// Jobs spread over uniqueCount mesh and material combinations, the same seed gives the same jobs
+static std::vector<Vultron::RenderJob> MakeJobs(uint32_t count, uint32_t uniqueCount)
+{
+    std::mt19937 generator(1234);
+    std::uniform_int_distribution<uint32_t> combination(0, uniqueCount - 1);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+
+    std::vector<Vultron::RenderJob> jobs(count);
+    for (Vultron::RenderJob &job : jobs)
+    {
+        const uint32_t index = combination(generator);
+        job.mesh = 1 + index % 16;
+        job.material = 1 + index / 16;
+        job.transform = glm::mat4(1.0f);
+        job.transform[3] = glm::vec4(position(generator), position(generator), position(generator), 1.0f);
+    }
+
+    return jobs;
+}
+
+// Local transforms of a tree where node i is a child of node (i - 1) / fanOut, parents come first
+static std::vector<Vultron::TransformCommand> MakeHierarchy(uint32_t count, uint32_t fanOut)
+{
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.28f);
+
+    std::vector<Vultron::TransformCommand> commands(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const float rotation = angle(generator);
+        commands[i].node = i;
+        commands[i].target = i == 0 ? Vultron::c_noTransformTarget : (i - 1) / fanOut;
+        commands[i].local.position = glm::vec3(position(generator), position(generator), position(generator));
+        commands[i].local.rotation = glm::quat(std::cos(rotation * 0.5f), 0.0f, 0.0f, std::sin(rotation * 0.5f));
+    }
+
+    return commands;
+}
+
+static std::string WriteSyntheticMesh(const std::string &directory, uint32_t vertexCount)
+{
+    const std::string filepath = directory + "/mesh_" + std::to_string(vertexCount) + ".dat";
+    std::ofstream file(filepath, std::ios::binary);
+
+    // Same layout as the converted meshes: vertex count, vertices, index count, indices
+    std::vector<Vultron::StaticMeshVertex> vertices(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++)
+    {
+        vertices[i] = {glm::vec3(static_cast<float>(i), 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f)};
+    }
+    std::vector<uint32_t> indices(static_cast<size_t>(vertexCount) * 3);
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        indices[i] = static_cast<uint32_t>((i * 7) % vertexCount);
+    }
+
+    const uint32_t indexCount = static_cast<uint32_t>(indices.size());
+    file.write(reinterpret_cast<const char *>(&vertexCount), sizeof(vertexCount));
+    file.write(reinterpret_cast<const char *>(vertices.data()), vertices.size() * sizeof(Vultron::StaticMeshVertex));
+    file.write(reinterpret_cast<const char *>(&indexCount), sizeof(indexCount));
+    file.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(uint32_t));
+
+    return filepath;
+}
+
+static std::string WriteSyntheticImage(const std::string &directory, uint32_t size)
+{
+    const std::string filepath = directory + "/image_" + std::to_string(size) + ".dat";
+    std::ofstream file(filepath, std::ios::binary);
+
+    // RGBA8 with a full mip chain, see VulkanImage::ReadFile
+    uint32_t mipCount = 1;
+    while ((size >> mipCount) > 0 && mipCount < 10)
+    {
+        mipCount++;
+    }
+    const uint32_t header[] = {4, 1, mipCount};
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+
+    for (uint32_t mip = 0; mip < mipCount; mip++)
+    {
+        const uint32_t mipSize = std::max(size >> mip, 1u);
+        const uint32_t extent[] = {mipSize, mipSize};
+        file.write(reinterpret_cast<const char *>(extent), sizeof(extent));
+
+        const std::vector<uint8_t> data(static_cast<size_t>(mipSize) * mipSize * 4, static_cast<uint8_t>(mip));
+        file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    }
+
+    return filepath;
+}
+
+static std::map<std::string, double> ReadBaseline(const std::string &filepath)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream file(filepath);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream stream(line);
+        std::string name;
+        double nanoseconds = 0.0;
+        if (stream >> name >> nanoseconds)
+        {
+            baseline[name] = nanoseconds;
+        }
+    }
+
+    return baseline;
+}
+
+static void WriteBaseline(const std::string &filepath, const std::vector<MicroResult> &results)
+{
+    std::ofstream file(filepath);
+    file << "# name nanoseconds_per_item" << std::endl;
+    for (const MicroResult &result : results)
+    {
+        file << result.name << " " << result.nanosecondsPerItem << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // VultronMicroBench [--filter <substring>] [--cpu <index>, -1 to not pin]
+    //                   [--baseline <file>] [--tolerance <fraction>] [--save-baseline <file>]
+    // measures frontend hot paths without a GPU, exits with 1 when a benchmark is slower than the baseline by more than the tolerance
+    std::string filter;
+    int cpu = 0;
+    std::string baselinePath;
+    std::string saveBaselinePath;
+    double tolerance = 0.1;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (argument == "--cpu" && i + 1 < argc)
+        {
+            cpu = std::atoi(argv[++i]);
+        }
+        else if (argument == "--baseline" && i + 1 < argc)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (argument == "--tolerance" && i + 1 < argc)
+        {
+            tolerance = std::atof(argv[++i]);
+        }
+        else if (argument == "--save-baseline" && i + 1 < argc)
+        {
+            saveBaselinePath = argv[++i];
+        }
+    }
+
+    // Pinned before any job system starts, so only the measuring thread is pinned and workers stay free to move
+    if (cpu >= 0 && !PinThread(cpu))
+    {
+        std::cerr << "Failed to pin the benchmark thread to CPU " << cpu << ", results may be noisy" << std::endl;
+    }
+
+    const std::string dataDirectory = std::string(VLT_CACHE_DIR) + "/microbench";
+    std::filesystem::create_directories(dataDirectory);
+
+    std::vector<MicroResult> results;
+    const auto runBenchmark = [&](const MicroBenchmark &benchmark)
+    {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+        {
+            return;
+        }
+
+        const double nanoseconds = Measure(benchmark);
+        results.push_back({benchmark.name, nanoseconds});
+        std::cout << std::left << std::setw(40) << benchmark.name << std::right << std::setw(12) << std::fixed << std::setprecision(2) << nanoseconds << " ns/item" << std::endl;
+    };
+
+    // (jobs, unique mesh and material combinations)
+    const std::vector<std::pair<uint32_t, uint32_t>> jobScales = {{1'000, 16}, {10'000, 64}, {100'000, 256}};
+
+    for (const auto &[jobCount, uniqueCount] : jobScales)
+    {
+        const std::vector<Vultron::RenderJob> jobs = MakeJobs(jobCount, uniqueCount);
+        runBenchmark({"render_job_hash/" + std::to_string(jobCount), jobCount, [&jobs]()
+                      {
+                          uint64_t hash = 0;
+                          for (const Vultron::RenderJob &job : jobs)
+                          {
+                              hash ^= job.GetHash();
+                          }
+                          s_sink = hash;
+                      }});
+    }
+
+    // Scheduling overhead of the job system, empty jobs spawned from the measuring thread and waited for. Per job.
+    {
+        Vultron::JobSystem jobSystem;
+        jobSystem.Initialize();
+
+        for (uint32_t jobCount : {1'000u, 10'000u, 100'000u})
+        {
+            runBenchmark({"job_spawn/" + std::to_string(jobCount), jobCount, [&jobSystem, jobCount]()
+                          {
+                              Vultron::JobCounter counter;
+                              for (uint32_t i = 0; i < jobCount; i++)
+                              {
+                                  jobSystem.Run([]() {}, counter);
+                              }
+                              jobSystem.Wait(counter);
+                          }});
+        }
+
+        // Nested ranges whose jobs together overflow a thread's job ring, this used to hang once the ring wrapped
+        constexpr uint32_t outerCount = 8;
+        constexpr uint32_t innerCount = 9'000;
+        std::atomic<uint64_t> nestedItems = 0;
+        runBenchmark({"nested_parallel_for/" + std::to_string(outerCount) + "x" + std::to_string(innerCount), outerCount * innerCount, [&]()
+                      {
+                          nestedItems = 0;
+                          jobSystem.ParallelFor(outerCount, 1, [&](uint32_t begin, uint32_t end)
+                                                {
+                              for (uint32_t i = begin; i < end; i++)
+                              {
+                                  jobSystem.ParallelFor(innerCount, 16, [&](uint32_t innerBegin, uint32_t innerEnd)
+                                                        { nestedItems.fetch_add(innerEnd - innerBegin, std::memory_order_relaxed); });
+                              } });
+                          s_sink = nestedItems;
+                      }});
+
+        if (s_sink != outerCount * innerCount && (filter.empty() || std::string("nested_parallel_for").find(filter) != std::string::npos))
+        {
+            std::cerr << "nested_parallel_for covered " << s_sink << " items instead of " << outerCount * innerCount << std::endl;
+            return 1;
+        }
+
+        jobSystem.Shutdown();
+    }
+
+    // Scaling of ParallelFor over a fixed amount of work, the measuring thread is one of the threads. Per item.
+    {
+        constexpr uint32_t itemCount = 1'000'000;
+        constexpr uint32_t grainSize = 4'096;
+        std::vector<float> values(itemCount, 1.0f);
+        const auto work = [&values](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                values[i] = std::sqrt(values[i] * 1.0001f + 1.0f);
+            }
+        };
+
+        runBenchmark({"parallel_for/1", itemCount, [&]()
+                      {
+                          work(0, itemCount);
+                          s_sink = static_cast<uint64_t>(values[0]);
+                      }});
+
+        const uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 2u);
+        for (uint32_t threadCount : {2u, 4u, 8u, 16u})
+        {
+            if (threadCount > hardwareThreads)
+            {
+                break;
+            }
+
+            Vultron::JobSystem jobSystem;
+            jobSystem.Initialize(threadCount - 1);
+            runBenchmark({"parallel_for/" + std::to_string(threadCount), itemCount, [&]()
+                          {
+                              jobSystem.ParallelFor(itemCount, grainSize, work);
+                              s_sink = static_cast<uint64_t>(values[0]);
+                          }});
+            jobSystem.Shutdown();
+        }
+    }
+
+    {
+        Vultron::JobSystem jobSystem;
+        jobSystem.Initialize();
+
+        for (const auto &[jobCount, uniqueCount] : jobScales)
+        {
+            const std::vector<Vultron::RenderJob> jobs = MakeJobs(jobCount, uniqueCount);
+            std::map<uint64_t, Vultron::InstancedRenderJob> renderJobs;
+            std::vector<Vultron::RenderBatch> batches;
+            std::vector<const Vultron::InstancedRenderJob *> batchJobs;
+            std::vector<glm::mat4> instanceBuffer;
+
+            runBenchmark({"build_batches/" + std::to_string(jobCount), jobCount, [&]()
+                          {
+                              Vultron::BuildRenderBatches(jobs, renderJobs, batches, batchJobs);
+                              s_sink = batches.size();
+                          }});
+
+            Vultron::BuildRenderBatches(jobs, renderJobs, batches, batchJobs);
+            runBenchmark({"pack_instances/" + std::to_string(jobCount), jobCount, [&]()
+                          {
+                              Vultron::PackInstances(jobSystem, batches, batchJobs, instanceBuffer);
+                              s_sink = instanceBuffer.size();
+                          }});
+        }
+
+        jobSystem.Shutdown();
+    }
+
+    // Lookups only read the maps, so default constructed resources are enough
+    for (uint32_t resourceCount : {16u, 1'024u, 65'536u})
+    {
+        Vultron::ResourcePool pool;
+        for (uint32_t i = 0; i < resourceCount; i++)
+        {
+            pool.AddMesh(Vultron::VulkanMesh());
+            pool.AddMaterialInstance(Vultron::VulkanMaterialInstance());
+        }
+
+        std::mt19937 generator(1234);
+        std::vector<Vultron::RenderHandle> handles(4'096);
+        for (Vultron::RenderHandle &handle : handles)
+        {
+            handle = generator() % resourceCount;
+        }
+
+        runBenchmark({"resource_pool_lookup/" + std::to_string(resourceCount), handles.size() * 2, [&pool, &handles]()
+                      {
+                          uint64_t sum = 0;
+                          for (Vultron::RenderHandle handle : handles)
+                          {
+                              sum += reinterpret_cast<uintptr_t>(&pool.GetMesh(handle));
+                              sum += reinterpret_cast<uintptr_t>(&pool.GetMaterialInstance(handle));
+                          }
+                          s_sink = sum;
+                      }});
+    }
+
+    // The whole frontend frame with the null backend, submit through batching and packing
+    for (const auto &[jobCount, uniqueCount] : jobScales)
+    {
+        Vultron::SceneRenderer renderer;
+        if (!renderer.InitializeHeadless(64, 64, Vultron::RenderBackendType::Null))
+        {
+            std::cerr << "Renderer failed to initialize" << std::endl;
+            return -1;
+        }
+
+        const std::vector<Vultron::RenderJob> jobs = MakeJobs(jobCount, uniqueCount);
+        runBenchmark({"scene_submit/" + std::to_string(jobCount), jobCount, [&renderer, &jobs]()
+                      {
+                          renderer.BeginFrame();
+                          for (const Vultron::RenderJob &job : jobs)
+                          {
+                              renderer.SubmitRenderJob(job);
+                          }
+                          renderer.EndFrame();
+                      }});
+
+        renderer.Shutdown();
+    }
+
+    // The same jobs as render objects, a frame only moves a share of them. Per object, comparable to scene_submit.
+    for (const auto &[jobCount, uniqueCount] : jobScales)
+    {
+        for (uint32_t movingPercent : {0u, 1u, 10u, 100u})
+        {
+            Vultron::SceneRenderer renderer;
+            if (!renderer.InitializeHeadless(64, 64, Vultron::RenderBackendType::Null))
+            {
+                std::cerr << "Renderer failed to initialize" << std::endl;
+                return -1;
+            }
+
+            const std::vector<Vultron::RenderJob> jobs = MakeJobs(jobCount, uniqueCount);
+            std::vector<Vultron::RenderHandle> objects;
+            for (const Vultron::RenderJob &job : jobs)
+            {
+                objects.push_back(renderer.CreateRenderObject(job.mesh, job.material, job.transform));
+            }
+
+            const uint32_t movingCount = jobCount / 100 * movingPercent;
+            uint32_t frame = 0;
+            runBenchmark({"scene_retained/" + std::to_string(jobCount) + "/" + std::to_string(movingPercent) + "%", jobCount, [&]()
+                          {
+                              renderer.BeginFrame();
+                              frame++;
+                              for (uint32_t i = 0; i < movingCount; i++)
+                              {
+                                  glm::mat4 transform = jobs[i].transform;
+                                  transform[3].z += static_cast<float>(frame % 16);
+                                  renderer.SetRenderObjectTransform(objects[i], transform);
+                              }
+                              renderer.EndFrame();
+                          }});
+
+            renderer.Shutdown();
+        }
+    }
+
+    // World matrix propagation alone, a frame changes the local transform of a share of the nodes spread over every level.
+    // Per node, descendants of a changed node are recomputed as well.
+    {
+        Vultron::JobSystem jobSystem;
+        jobSystem.Initialize();
+
+        for (uint32_t nodeCount : {10'000u, 100'000u})
+        {
+            for (uint32_t movingPercent : {0u, 1u, 10u, 100u})
+            {
+                const std::vector<Vultron::TransformCommand> nodes = MakeHierarchy(nodeCount, 8);
+                Vultron::TransformHierarchy hierarchy;
+                hierarchy.Apply(nodes);
+                hierarchy.Update(jobSystem);
+
+                std::vector<Vultron::TransformCommand> changes;
+                const uint32_t movingCount = nodeCount / 100 * movingPercent;
+                for (uint32_t i = 0; i < movingCount; i++)
+                {
+                    const Vultron::TransformCommand &node = nodes[static_cast<uint64_t>(i) * nodeCount / movingCount];
+                    changes.push_back({.type = Vultron::TransformCommandType::SetLocal, .node = node.node, .local = node.local});
+                }
+
+                runBenchmark({"transform_hierarchy/" + std::to_string(nodeCount) + "/" + std::to_string(movingPercent) + "%", nodeCount, [&]()
+                              {
+                                  hierarchy.Apply(changes);
+                                  hierarchy.Update(jobSystem);
+                                  s_sink = hierarchy.GetUpdatedCount();
+                              }});
+            }
+        }
+
+        jobSystem.Shutdown();
+    }
+
+    // Render objects driven by transform nodes through the null backend, one object per node. Comparable to scene_retained.
+    for (uint32_t movingPercent : {0u, 1u, 10u, 100u})
+    {
+        constexpr uint32_t nodeCount = 100'000;
+        Vultron::SceneRenderer renderer;
+        if (!renderer.InitializeHeadless(64, 64, Vultron::RenderBackendType::Null))
+        {
+            std::cerr << "Renderer failed to initialize" << std::endl;
+            return -1;
+        }
+
+        const std::vector<Vultron::TransformCommand> nodes = MakeHierarchy(nodeCount, 8);
+        const std::vector<Vultron::RenderJob> jobs = MakeJobs(nodeCount, 256);
+        std::vector<Vultron::RenderHandle> handles;
+        for (uint32_t i = 0; i < nodeCount; i++)
+        {
+            const Vultron::RenderHandle parent = i == 0 ? VLT_INVALID_HANDLE : handles[nodes[i].target];
+            handles.push_back(renderer.CreateTransformNode(nodes[i].local, parent));
+            renderer.AttachRenderObject(renderer.CreateRenderObject(jobs[i].mesh, jobs[i].material, glm::mat4(1.0f)), handles.back());
+        }
+
+        const uint32_t movingCount = nodeCount / 100 * movingPercent;
+        uint32_t frame = 0;
+        runBenchmark({"scene_hierarchy/" + std::to_string(nodeCount) + "/" + std::to_string(movingPercent) + "%", nodeCount, [&]()
+                      {
+                          renderer.BeginFrame();
+                          frame++;
+                          for (uint32_t i = 0; i < movingCount; i++)
+                          {
+                              const uint32_t node = static_cast<uint32_t>(static_cast<uint64_t>(i) * nodeCount / movingCount);
+                              Vultron::Transform local = nodes[node].local;
+                              local.position.z += static_cast<float>(frame % 16);
+                              renderer.SetTransformNodeLocal(handles[node], local);
+                          }
+                          renderer.EndFrame();
+                      }});
+
+        renderer.Shutdown();
+    }
+
+    for (uint32_t vertexCount : {1'000u, 100'000u, 1'000'000u})
+    {
+        const std::string filepath = WriteSyntheticMesh(dataDirectory, vertexCount);
+        std::vector<Vultron::StaticMeshVertex> vertices;
+        std::vector<uint32_t> indices;
+        runBenchmark({"mesh_parse/" + std::to_string(vertexCount), vertexCount, [&]()
+                      {
+                          Vultron::VulkanMesh::ReadFile(filepath, vertices, indices);
+                          s_sink = indices.size();
+                      }});
+    }
+
+    for (uint32_t size : {256u, 1'024u, 2'048u})
+    {
+        const std::string filepath = WriteSyntheticImage(dataDirectory, size);
+        runBenchmark({"image_parse/" + std::to_string(size), static_cast<uint64_t>(size) * size, [&filepath]()
+                      {
+                          const Vultron::ImageFileData image = Vultron::VulkanImage::ReadFile(filepath);
+                          s_sink = image.mips.size();
+                      }});
+    }
+
+    if (!saveBaselinePath.empty())
+    {
+        WriteBaseline(saveBaselinePath, results);
+        std::cout << "Saved baseline to " << saveBaselinePath << std::endl;
+    }
+
+    if (baselinePath.empty())
+    {
+        return 0;
+    }
+
+    const std::map<std::string, double> baseline = ReadBaseline(baselinePath);
+    if (baseline.empty())
+    {
+        std::cerr << "Failed to read baseline " << baselinePath << std::endl;
+        return -1;
+    }
+
+    uint32_t regressions = 0;
+    std::cout << std::endl
+              << "Compared to " << baselinePath << ", tolerance " << tolerance * 100.0 << "%" << std::endl;
+    for (const MicroResult &result : results)
+    {
+        const auto entry = baseline.find(result.name);
+        if (entry == baseline.end())
+        {
+            std::cout << std::left << std::setw(40) << result.name << "  not in baseline" << std::endl;
+            continue;
+        }
+
+        const double change = result.nanosecondsPerItem / entry->second - 1.0;
+        const char *verdict = change > tolerance ? "REGRESSION" : change < -tolerance ? "faster" : "ok";
+        regressions += change > tolerance ? 1 : 0;
+        std::cout << std::left << std::setw(40) << result.name << std::right << std::setw(10) << std::showpos << std::setprecision(1) << change * 100.0
+                  << std::noshowpos << "%  " << verdict << std::endl;
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,281 @@
+#include "Vultron/Vultron.h"
+#include "Vultron/FrameCapture.h"
+#include "Vultron/SceneRenderer.h"
+#include "Vultron/Window.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ReplayTimings
+{
+    float mean = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    float max = 0.0f;
+};
+
+// Nearest rank percentiles, samples are sorted in place
+static ReplayTimings ComputeTimings(std::vector<float> &samples)
+{
+    ReplayTimings timings;
+    if (samples.empty())
+    {
+        return timings;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const auto percentile = [&samples](float p)
+    {
+        const size_t rank = static_cast<size_t>(p * (samples.size() - 1) + 0.5f);
+        return samples[rank];
+    };
+
+    for (float sample : samples)
+    {
+        timings.mean += sample;
+    }
+    timings.mean /= samples.size();
+    timings.p50 = percentile(0.50f);
+    timings.p95 = percentile(0.95f);
+    timings.p99 = percentile(0.99f);
+    timings.max = samples.back();
+
+    return timings;
+}
+
+static void WriteTimings(std::ostream &out, const char *name, const ReplayTimings &timings)
+{
+    out << "\"" << name << "\": {\"mean\": " << timings.mean << ", \"p50\": " << timings.p50 << ", \"p95\": " << timings.p95
+        << ", \"p99\": " << timings.p99 << ", \"max\": " << timings.max << "}";
+}
+
+// Counts the frames of a capture and reads the size of the first one, zero when it was rendered headless
+static bool ScanCapture(const std::string &filepath, uint64_t &frameCount, uint32_t &width, uint32_t &height)
+{
+    Vultron::FrameCaptureReader reader;
+    if (!reader.Open(filepath))
+    {
+        return false;
+    }
+
+    Vultron::CaptureRecordType type;
+    while (reader.Next(type))
+    {
+        if (type == Vultron::CaptureRecordType::Frame)
+        {
+            if (frameCount == 0)
+            {
+                width = reader.GetFrame().width;
+                height = reader.GetFrame().height;
+            }
+            frameCount++;
+        }
+    }
+
+    return true;
+}
+
+static const char *GetBackendName(Vultron::RenderBackendType type)
+{
+    switch (type)
+    {
+    case Vultron::RenderBackendType::Null:
+        return "null";
+    case Vultron::RenderBackendType::Software:
+        return "software";
+    case Vultron::RenderBackendType::Vulkan:
+    default:
+        return "vulkan";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // VultronReplay <capture> [--loops <n>] [--warmup <n>] [--headless] [--resolution <width> <height>]
+    //               [--backend vulkan|null|software] [--render-thread] [--output <file>]
+    // plays a capture written with SceneRenderer::BeginCapture as fast as possible and writes the timings as JSON,
+    // to stdout without --output. Headless runs use the size of the captured frames unless --resolution is given.
+    if (argc < 2)
+    {
+        std::cerr << "Usage: VultronReplay <capture> [--loops <n>] [--warmup <n>] [--headless] [--resolution <width> <height>] "
+                     "[--backend vulkan|null|software] [--render-thread] [--output <file>]"
+                  << std::endl;
+        return -1;
+    }
+
+    const std::string capturePath = argv[1];
+    uint32_t loops = 1;
+    uint32_t warmupFrames = 10;
+    bool headless = false;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    Vultron::RenderBackendType backendType = Vultron::RenderBackendType::Vulkan;
+    bool renderThread = false;
+    std::string outputPath;
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "--loops" && i + 1 < argc)
+        {
+            loops = std::max(static_cast<uint32_t>(std::atoi(argv[++i])), 1u);
+        }
+        else if (argument == "--warmup" && i + 1 < argc)
+        {
+            warmupFrames = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (argument == "--headless")
+        {
+            headless = true;
+        }
+        else if (argument == "--resolution" && i + 2 < argc)
+        {
+            width = static_cast<uint32_t>(std::atoi(argv[++i]));
+            height = static_cast<uint32_t>(std::atoi(argv[++i]));
+        }
+        else if (argument == "--backend" && i + 1 < argc)
+        {
+            const std::string_view backendName = argv[++i];
+            if (backendName == "null")
+            {
+                backendType = Vultron::RenderBackendType::Null;
+            }
+            else if (backendName == "software")
+            {
+                backendType = Vultron::RenderBackendType::Software;
+            }
+        }
+        else if (argument == "--render-thread")
+        {
+            renderThread = true;
+        }
+        else if (argument == "--output" && i + 1 < argc)
+        {
+            outputPath = argv[++i];
+        }
+    }
+
+    uint64_t captureFrames = 0;
+    uint32_t captureWidth = 0;
+    uint32_t captureHeight = 0;
+    if (!ScanCapture(capturePath, captureFrames, captureWidth, captureHeight))
+    {
+        return -1;
+    }
+
+    if (width == 0 || height == 0)
+    {
+        width = captureWidth > 0 ? captureWidth : 1920;
+        height = captureHeight > 0 ? captureHeight : 1080;
+    }
+
+    Vultron::FrameReplayer replayer;
+    if (!replayer.Open(capturePath))
+    {
+        return -1;
+    }
+
+    Vultron::Window window;
+    if (!headless && !window.Initialize())
+    {
+        std::cerr << "Window failed to initialize" << std::endl;
+        return -1;
+    }
+
+    Vultron::SceneRenderer renderer;
+    const bool initialized = headless ? renderer.InitializeHeadless(width, height, backendType) : renderer.Initialize(window, backendType);
+    if (!initialized)
+    {
+        std::cerr << "Renderer failed to initialize" << std::endl;
+        return -1;
+    }
+
+    renderer.SetRenderThreadEnabled(renderThread);
+
+    if (!replayer.LoadAssets(renderer))
+    {
+        std::cerr << "Capture " << capturePath << " has no frames" << std::endl;
+        renderer.Shutdown();
+        return -1;
+    }
+
+    for (uint32_t frame = 0; frame < warmupFrames; frame++)
+    {
+        replayer.ReplayFrame(renderer, true);
+    }
+
+    // Measuring continues where the warmup stopped, every captured frame is still measured once per loop
+    std::vector<float> cpuTimes;
+    std::vector<float> gpuTimes;
+    for (uint64_t frame = 0; frame < captureFrames * loops; frame++)
+    {
+        const auto frameStartTime = std::chrono::high_resolution_clock::now();
+
+        if (!headless)
+        {
+            window.PollEvents();
+        }
+
+        replayer.ReplayFrame(renderer, true);
+
+        if (!headless)
+        {
+            window.SwapBuffers();
+        }
+
+        cpuTimes.push_back(std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - frameStartTime).count());
+        gpuTimes.push_back(renderer.GetGpuTime());
+    }
+
+    const Vultron::RenderStats stats = renderer.GetRenderStats();
+    const uint64_t frameCount = cpuTimes.size();
+    const ReplayTimings cpu = ComputeTimings(cpuTimes);
+    const ReplayTimings gpu = ComputeTimings(gpuTimes);
+
+    renderer.Shutdown();
+    if (!headless)
+    {
+        window.Shutdown();
+    }
+
+    std::cerr << "Replayed " << frameCount << " frames: " << cpu.mean << " ms CPU, " << gpu.mean << " ms GPU" << std::endl;
+
+    std::ofstream file;
+    if (!outputPath.empty())
+    {
+        file.open(outputPath);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to open " << outputPath << std::endl;
+            return -1;
+        }
+    }
+    std::ostream &out = outputPath.empty() ? std::cout : file;
+
+    // Times are in milliseconds, the stats are those of the last frame
+    out << "{\n";
+    out << "  \"capture\": \"" << capturePath << "\",\n";
+    out << "  \"backend\": \"" << GetBackendName(backendType) << "\",\n";
+    out << "  \"headless\": " << (headless ? "true" : "false") << ",\n";
+    out << "  \"render_thread\": " << (renderThread ? "true" : "false") << ",\n";
+    out << "  \"width\": " << width << ",\n";
+    out << "  \"height\": " << height << ",\n";
+    out << "  \"frames\": " << frameCount << ",\n";
+    out << "  \"loops\": " << loops << ",\n";
+    out << "  ";
+    WriteTimings(out, "cpu_ms", cpu);
+    out << ",\n  ";
+    WriteTimings(out, "gpu_ms", gpu);
+    out << ",\n";
+    out << "  \"stats\": {\"jobs\": " << stats.submittedJobs << ", \"batches\": " << stats.batches << ", \"draw_calls\": " << stats.drawCalls
+        << ", \"instances\": " << stats.instances << ", \"triangles\": " << stats.triangles << "}\n";
+    out << "}" << std::endl;
+
+    return 0;
+}